@@ -0,0 +1,142 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// alloc_counter.cpp
+//
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "alloc_counter.h"
+#include "signal_safe.h"
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <stdexcept>
+
+#ifdef __GLIBC__
+#  include <execinfo.h>
+#endif
+
+YUNIT_NS_BEGIN
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+static const AllocCounterHooks *allocCounterHooks = NULL;
+
+void registerAllocCounter(const AllocCounterHooks *hooks)
+{
+    allocCounterHooks = hooks;
+}
+
+bool allocCounterEnabled()
+{
+    return NULL != allocCounterHooks;
+}
+
+AllocStats threadAllocStats()
+{
+    if (NULL != allocCounterHooks)
+        return *allocCounterHooks->threadStats();
+
+    AllocStats stats = {0, 0, 0, 0};
+    return stats;
+}
+
+static AllocBudgetState* threadBudget()
+{
+    return (NULL != allocCounterHooks) ? allocCounterHooks->threadBudget() : NULL;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+AllocationBudget::AllocationBudget(unsigned long long maxAllocations)
+: maxAllocations_(maxAllocations)
+, startAllocations_(0)
+{
+    AllocBudgetState *budget = threadBudget();
+    if (NULL == budget)
+        return;
+
+#ifdef __GLIBC__
+    static __thread bool unwinderLoaded = false;
+    if (!unwinderLoaded)
+    {
+        preloadUnwinder();
+        unwinderLoaded = true;
+    }
+#endif
+
+    prevState_ = *budget;
+
+    startAllocations_ = threadAllocStats().allocations_;
+    budget->threshold_ = startAllocations_ + maxAllocations_;
+    budget->captured_ = false;
+    budget->stackDepth_ = 0;
+    budget->armed_ = true;
+}
+
+AllocationBudget::~AllocationBudget()
+{
+    AllocBudgetState *budget = threadBudget();
+    if (NULL == budget)
+        return;
+
+    // stack, captured for outer budget, is restored too
+    *budget = prevState_;
+}
+
+unsigned long long AllocationBudget::allocations() const
+{
+    return allocCounterEnabled() ? threadAllocStats().allocations_ - startAllocations_ : 0;
+}
+
+std::string AllocationBudget::exceedingStack() const
+{
+    std::string res;
+    const AllocBudgetState *budget = threadBudget();
+    if (NULL == budget || !budget->captured_ || 0 == budget->stackDepth_)
+        return res;
+
+#ifdef __GLIBC__
+    // copy stack, because 'backtrace_symbols' allocates memory and may overwrite captured one
+    void *stack[maxStackDepth];
+    const int depth = budget->stackDepth_;
+    for (int idx = 0; idx < depth; ++idx)
+        stack[idx] = budget->stack_[idx];
+
+    char **symbols = ::backtrace_symbols(stack, depth);
+    if (NULL == symbols)
+        return res;
+
+    enum {skippedFrames = 2}; // captureExceedingStack, counted
+    for (int idx = skippedFrames; idx < depth; ++idx)
+    {
+        res += "\n    ";
+        res += symbols[idx];
+    }
+
+    ::free(symbols);
+#endif
+    return res;
+}
+
+bool AllocationBudget::exceeded() const
+{
+    return allocations() > maxAllocations_;
+}
+
+void AllocationBudget::check(const char *prefix) const
+{
+    const unsigned long long allocationsNumber = allocations();
+    if (allocationsNumber <= maxAllocations_)
+        return;
+
+    enum {msgSize = 512};
+    char msg[msgSize];
+    TS_SNPRINTF(msg, msgSize, "%s" " has made %llu heap allocations, but allowed %llu", prefix,
+                allocationsNumber, maxAllocations_);
+    msg[msgSize - 1] = '\0';
+
+    const std::string stack = exceedingStack();
+    if (stack.empty())
+        throw std::logic_error(msg);
+
+    throw std::logic_error(std::string(msg) + ", first exceeding allocation:" + stack);
+}
+
+YUNIT_NS_END
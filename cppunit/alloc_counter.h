@@ -0,0 +1,88 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// @file alloc_counter.h
+//
+// Heap allocation counters of current thread. They are collected by interposition of malloc/free family and
+// operator new/delete, implemented in alloc_interposer.cpp for glibc.
+//
+// Interposer is optional: link it into test executable (CMake object library 'yunit_alloc_counter') to count
+// allocations and to use '--leak-check'. Without it counters are zero and budget asserts always pass. Do not
+// link it into test program, which is built with address sanitizer or with other allocator (tcmalloc,
+// jemalloc), and into shared library, loaded by dlopen: its TLS uses "initial-exec" model.
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#ifndef _ALLOC_COUNTER_YUNIT_HEADER_
+#define _ALLOC_COUNTER_YUNIT_HEADER_
+
+#include "../yunit/yunit.h"
+#include <string>
+
+YUNIT_NS_BEGIN
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+struct AllocStats
+{
+    unsigned long long allocations_;
+    unsigned long long deallocations_;
+    unsigned long long allocatedBytes_;
+    long long outstandingBytes_;  ///< allocated and not freed yet by current thread bytes
+};
+
+/// @return false if interposer is not linked into test program or allocations are not counted on current platform
+bool allocCounterEnabled();
+
+/// @brief Counters of calling thread since its start. Difference of two values is statistics of allocations,
+/// done between calls.
+AllocStats threadAllocStats();
+
+enum {allocMaxStackDepth = 32};
+
+/// @brief State of active AllocationBudget of thread, checked by interposer on every allocation
+struct AllocBudgetState
+{
+    bool armed_;
+    bool captured_;
+    unsigned long long threshold_;  ///< value of 'allocations_' counter, which is exceeding
+    int stackDepth_;
+    void *stack_[allocMaxStackDepth];
+};
+
+/// @brief Access to thread counters of interposer, which registers it at static initialization
+struct AllocCounterHooks
+{
+    AllocStats* (*threadStats)();
+    AllocBudgetState* (*threadBudget)();
+};
+
+void registerAllocCounter(const AllocCounterHooks *hooks);
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief Count allocations of current thread during object life and remember call stack of the first
+/// allocation, which exceeds the budget. Used by 'assertMaxAllocations' and 'noAllocations' asserts.
+class AllocationBudget
+{
+public:
+    explicit AllocationBudget(unsigned long long maxAllocations);
+    ~AllocationBudget();
+
+    unsigned long long allocations() const;
+    bool exceeded() const;
+
+    /// @brief Throw std::logic_error, if budget has been exceeded
+    /// @param prefix Error message prefix (file, line, checked expression)
+    void check(const char *prefix) const;
+
+    enum {maxStackDepth = allocMaxStackDepth};
+
+private:
+    AllocationBudget(const AllocationBudget&);
+    AllocationBudget& operator=(const AllocationBudget&);
+
+    std::string exceedingStack() const;
+
+    unsigned long long maxAllocations_;
+    unsigned long long startAllocations_;
+    AllocBudgetState prevState_;        ///< budgets may be nested
+};
+
+YUNIT_NS_END
+
+#endif // _ALLOC_COUNTER_YUNIT_HEADER_
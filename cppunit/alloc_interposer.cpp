@@ -0,0 +1,218 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// alloc_interposer.cpp
+//
+// Replacement of malloc/free family and operator new/delete, which counts allocations of every thread. Link
+// it into test executable only (CMake object library 'yunit_alloc_counter'), see alloc_counter.h.
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "alloc_counter.h"
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+#ifdef __GLIBC__
+#  define YUNIT_ALLOC_INTERPOSER
+#  include <malloc.h>
+#  include <errno.h>
+#  include <execinfo.h>
+#endif
+
+#ifdef YUNIT_ALLOC_INTERPOSER
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// glibc original allocator entries
+extern "C"
+{
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t number, size_t size);
+void* __libc_realloc(void *ptr, size_t size);
+void* __libc_memalign(size_t alignment, size_t size);
+void* __libc_valloc(size_t size);
+void* __libc_pvalloc(size_t size);
+void  __libc_free(void *ptr);
+}
+
+// counters must be accessible from allocator without any allocation, so TLS is POD and uses "initial-exec"
+// model (default model for dynamic link libraries may call malloc on first access)
+static __thread YUNIT_NS_PREF(AllocStats) threadStats __attribute__ ((tls_model("initial-exec")));
+static __thread YUNIT_NS_PREF(AllocBudgetState) budgetState __attribute__ ((tls_model("initial-exec")));
+
+static __attribute__ ((noinline)) void captureExceedingStack()
+{
+    budgetState.captured_ = true; // before 'backtrace' call, because it may allocate memory
+    budgetState.stackDepth_ = ::backtrace(budgetState.stack_, YUNIT_NS_PREF(allocMaxStackDepth));
+}
+
+// not inlined, so the number of hook frames in captured stack is known
+static __attribute__ ((noinline)) void* counted(void *ptr)
+{
+    if (NULL != ptr)
+    {
+        const size_t size = ::malloc_usable_size(ptr);
+        ++threadStats.allocations_;
+        threadStats.allocatedBytes_ += size;
+        threadStats.outstandingBytes_ += size;
+
+        if (budgetState.armed_ && !budgetState.captured_ && threadStats.allocations_ > budgetState.threshold_)
+            captureExceedingStack();
+    }
+    return ptr;
+}
+
+static inline void uncount(size_t size)
+{
+    ++threadStats.deallocations_;
+    threadStats.outstandingBytes_ -= size;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+extern "C"
+{
+
+void* malloc(size_t size)
+{
+    return counted(__libc_malloc(size));
+}
+
+void* calloc(size_t number, size_t size)
+{
+    return counted(__libc_calloc(number, size));
+}
+
+// block is uncounted after successful reallocation only, failed one keeps old block alive
+void* realloc(void *ptr, size_t size)
+{
+    const size_t oldSize = (NULL != ptr) ? ::malloc_usable_size(ptr) : 0;
+    void *res = __libc_realloc(ptr, size);
+    if (NULL == res && 0 != size)
+        return NULL;
+
+    if (NULL != ptr)
+        uncount(oldSize);
+    return counted(res);
+}
+
+void free(void *ptr)
+{
+    if (NULL != ptr)
+        uncount(::malloc_usable_size(ptr));
+    __libc_free(ptr);
+}
+
+void* memalign(size_t alignment, size_t size)
+{
+    return counted(__libc_memalign(alignment, size));
+}
+
+void* aligned_alloc(size_t alignment, size_t size)
+{
+    return counted(__libc_memalign(alignment, size));
+}
+
+void* valloc(size_t size)
+{
+    return counted(__libc_valloc(size));
+}
+
+void* pvalloc(size_t size)
+{
+    return counted(__libc_pvalloc(size));
+}
+
+int posix_memalign(void **res, size_t alignment, size_t size)
+{
+    if (0 == alignment || 0 != (alignment & (alignment - 1)) || 0 != alignment % sizeof(void*))
+        return EINVAL;
+
+    void *ptr = counted(__libc_memalign(alignment, size));
+    if (NULL == ptr)
+        return ENOMEM;
+
+    *res = ptr;
+    return 0;
+}
+
+} // extern "C"
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// operators go through counted malloc/free, so they are counted once; failed allocation is repeated after
+// new_handler call as standard operator new does
+void* operator new(size_t size)
+{
+    for (;;)
+    {
+        void *ptr = ::malloc(0 == size ? 1 : size);
+        if (NULL != ptr)
+            return ptr;
+
+        const std::new_handler handler = std::get_new_handler();
+        if (NULL == handler)
+            throw std::bad_alloc();
+        handler();
+    }
+}
+
+void* operator new[](size_t size)
+{
+    return ::operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) throw()
+{
+    try
+    {
+        return ::operator new(size);
+    }
+    catch (const std::bad_alloc&)
+    {
+        return NULL;
+    }
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) throw()
+{
+    return ::operator new(size, std::nothrow);
+}
+
+void operator delete(void *ptr) throw()
+{
+    ::free(ptr);
+}
+
+void operator delete[](void *ptr) throw()
+{
+    ::free(ptr);
+}
+
+void operator delete(void *ptr, const std::nothrow_t&) throw()
+{
+    ::free(ptr);
+}
+
+void operator delete[](void *ptr, const std::nothrow_t&) throw()
+{
+    ::free(ptr);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+static YUNIT_NS_PREF(AllocStats)* threadAllocStatsPtr()
+{
+    return &threadStats;
+}
+
+static YUNIT_NS_PREF(AllocBudgetState)* threadBudgetState()
+{
+    return &budgetState;
+}
+
+static const YUNIT_NS_PREF(AllocCounterHooks) allocCounterHooks = {threadAllocStatsPtr, threadBudgetState};
+
+static struct RegisterAllocCounter
+{
+    RegisterAllocCounter()
+    {
+        YUNIT_NS_PREF(registerAllocCounter)(&allocCounterHooks);
+    }
+} allocCounterRegistration;
+
+#endif // YUNIT_ALLOC_INTERPOSER
@@ -8,6 +8,23 @@
 #include <cstring>
 #include <cstdlib>
 #include <cmath>
+#include <cstdarg>
+#include <stdint.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#   define YUNIT_MEM_SSE2
+#   include <emmintrin.h>
+#endif
+
+// AVX2 kernel is compiled for target attribute and it is selected at run time, so binary works on any CPU
+#if defined(YUNIT_MEM_SSE2) && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#   define YUNIT_MEM_AVX2
+#   include <immintrin.h>
+#endif
+
+#ifdef _MSC_VER
+#   include <intrin.h>
+#endif
 
 #if defined(_WIN32) || defined(__WIN32__) || defined(__CYGWIN__)
 #	define SNPRINTF	_snprintf
@@ -60,6 +77,168 @@ bool areEqValues(const wchar_t *expected, const wchar_t *actual)
 	return expected == actual || (NULL != expected && NULL != actual && 0 == ::wcscmp(expected, actual));
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Memory comparison kernels: 'find' returns offset of the first different byte or 'size', 'count' returns
+// number of different bytes. Vector kernels build mask with bit per different byte of block.
+typedef size_t (*MemKernel)(const unsigned char *expected, const unsigned char *actual, size_t size);
+
+static unsigned int lowestBit(unsigned int mask)
+{
+#ifdef _MSC_VER
+    unsigned long idx;
+    _BitScanForward(&idx, mask);
+    return idx;
+#else
+    return static_cast<unsigned int>(__builtin_ctz(mask));
+#endif
+}
+
+static unsigned int bitsNumber(unsigned int mask)
+{
+#ifdef __GNUC__
+    return static_cast<unsigned int>(__builtin_popcount(mask));
+#else
+    unsigned int count = 0;
+    for (; 0 != mask; mask &= mask - 1)
+        ++count;
+    return count;
+#endif
+}
+
+static size_t findScalar(const unsigned char *expected, const unsigned char *actual, size_t size)
+{
+    size_t idx = 0;
+    for (; idx + sizeof(uint64_t) <= size; idx += sizeof(uint64_t))
+    {
+        uint64_t lhs, rhs;
+        ::memcpy(&lhs, expected + idx, sizeof(lhs));
+        ::memcpy(&rhs, actual + idx, sizeof(rhs));
+        if (lhs != rhs)
+            break;
+    }
+    while (idx < size && expected[idx] == actual[idx])
+        ++idx;
+    return idx;
+}
+
+static size_t countScalar(const unsigned char *expected, const unsigned char *actual, size_t size)
+{
+    size_t count = 0;
+    for (size_t idx = 0; idx < size; ++idx)
+        count += (expected[idx] != actual[idx]) ? 1 : 0;
+    return count;
+}
+
+#ifdef YUNIT_MEM_SSE2
+static unsigned int mismatchMask16(const unsigned char *expected, const unsigned char *actual)
+{
+    const __m128i lhs = _mm_loadu_si128(reinterpret_cast<const __m128i*>(expected));
+    const __m128i rhs = _mm_loadu_si128(reinterpret_cast<const __m128i*>(actual));
+    return ~static_cast<unsigned int>(_mm_movemask_epi8(_mm_cmpeq_epi8(lhs, rhs))) & 0xFFFFu;
+}
+
+static size_t findSse2(const unsigned char *expected, const unsigned char *actual, size_t size)
+{
+    size_t idx = 0;
+    for (; idx + 16 <= size; idx += 16)
+    {
+        const unsigned int mask = mismatchMask16(expected + idx, actual + idx);
+        if (0 != mask)
+            return idx + lowestBit(mask);
+    }
+    return idx + findScalar(expected + idx, actual + idx, size - idx);
+}
+
+static size_t countSse2(const unsigned char *expected, const unsigned char *actual, size_t size)
+{
+    size_t idx = 0, count = 0;
+    for (; idx + 16 <= size; idx += 16)
+        count += bitsNumber(mismatchMask16(expected + idx, actual + idx));
+    return count + countScalar(expected + idx, actual + idx, size - idx);
+}
+#endif // YUNIT_MEM_SSE2
+
+#ifdef YUNIT_MEM_AVX2
+__attribute__((target("avx2")))
+static unsigned int mismatchMask32(const unsigned char *expected, const unsigned char *actual)
+{
+    const __m256i lhs = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(expected));
+    const __m256i rhs = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(actual));
+    return ~static_cast<unsigned int>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(lhs, rhs)));
+}
+
+__attribute__((target("avx2")))
+static size_t findAvx2(const unsigned char *expected, const unsigned char *actual, size_t size)
+{
+    size_t idx = 0;
+    for (; idx + 32 <= size; idx += 32)
+    {
+        const unsigned int mask = mismatchMask32(expected + idx, actual + idx);
+        if (0 != mask)
+            return idx + lowestBit(mask);
+    }
+    return idx + findSse2(expected + idx, actual + idx, size - idx);
+}
+
+__attribute__((target("avx2")))
+static size_t countAvx2(const unsigned char *expected, const unsigned char *actual, size_t size)
+{
+    size_t idx = 0, count = 0;
+    for (; idx + 32 <= size; idx += 32)
+        count += bitsNumber(mismatchMask32(expected + idx, actual + idx));
+    return count + countSse2(expected + idx, actual + idx, size - idx);
+}
+#endif // YUNIT_MEM_AVX2
+
+struct MemKernels
+{
+    MemKernels()
+    : find_(findScalar)
+    , count_(countScalar)
+    {
+#ifdef YUNIT_MEM_SSE2
+        find_ = findSse2;
+        count_ = countSse2;
+#endif
+#ifdef YUNIT_MEM_AVX2
+        if (__builtin_cpu_supports("avx2"))
+        {
+            find_ = findAvx2;
+            count_ = countAvx2;
+        }
+#endif
+    }
+
+    MemKernel find_;
+    MemKernel count_;
+};
+
+static const MemKernels& memKernels()
+{
+    static const MemKernels kernels;
+    return kernels;
+}
+
+size_t firstMemMismatch(const void *expected, const void *actual, size_t size)
+{
+    if (expected == actual || 0 == size)
+        return size;
+    if (NULL == expected || NULL == actual)
+        return 0;
+    return memKernels().find_(static_cast<const unsigned char*>(expected), static_cast<const unsigned char*>(actual),
+                              size);
+}
+
+size_t countMemMismatches(const void *expected, const void *actual, size_t size)
+{
+    if (expected == actual)
+        return 0;
+    if (NULL == expected || NULL == actual)
+        return size;
+    return memKernels().count_(static_cast<const unsigned char*>(expected), static_cast<const unsigned char*>(actual),
+                               size);
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////
 struct TestException : std::exception
 {
@@ -86,8 +265,8 @@ void throwException(const char *prefix, const void* expected, const void* actual
 {
     TestException e;
     
-	int writtenBytes = SNPRINTF(e.msg_, e.msgSize - 1, mustBeEqual ? "%s" "\"0x%X\" != \"0x%X\"" : "%s" "\"0x%X\" == \"0x%X\"",
-        prefix, reinterpret_cast<unsigned int>(expected), reinterpret_cast<unsigned int>(actual));
+	int writtenBytes = SNPRINTF(e.msg_, e.msgSize - 1, mustBeEqual ? "%s" "\"%p\" != \"%p\"" : "%s" "\"%p\" == \"%p\"",
+        prefix, expected, actual);
     e.msg_[writtenBytes] = '\0';
 
     throw e;
@@ -149,4 +328,110 @@ void throwException(const char *prefix,
     throw e;
 }
 
+static void appendFormat(char *buf, size_t bufSize, size_t &len, const char *format, ...)
+{
+    if (len + 1 >= bufSize)
+        return;
+
+    va_list args;
+    va_start(args, format);
+    const int writtenBytes = vsnprintf(buf + len, bufSize - len, format, args);
+    va_end(args);
+
+    if (writtenBytes > 0)
+        len += static_cast<size_t>(writtenBytes);
+    if (len >= bufSize)
+        len = bufSize - 1;
+}
+
+// one row of dump: offset, bytes in hex (only the first 'size' of 'rowSize'), bytes as ASCII
+static void appendMemRow(char *buf, size_t bufSize, size_t &len, char sign, size_t offset, const unsigned char *row,
+                         size_t size)
+{
+    enum {rowSize = 16};
+    appendFormat(buf, bufSize, len, "\n%c%08llx:", sign, static_cast<unsigned long long>(offset));
+    for (size_t idx = 0; idx < rowSize; ++idx)
+    {
+        if (idx < size)
+            appendFormat(buf, bufSize, len, " %02x", row[idx]);
+        else
+            appendFormat(buf, bufSize, len, "   ");
+    }
+
+    appendFormat(buf, bufSize, len, "  |");
+    for (size_t idx = 0; idx < size; ++idx)
+        appendFormat(buf, bufSize, len, "%c", (row[idx] >= 0x20 && row[idx] < 0x7F) ? row[idx] : '.');
+    appendFormat(buf, bufSize, len, "|");
+}
+
+// Dump of buffers around the first difference in diff style: equal rows are written once, different rows are
+// written for expected ('-') and actual ('+') buffer with marks under different bytes; buffers are not copied
+void throwMemException(const char *prefix, const void *expected, const void *actual, size_t size, size_t mismatch)
+{
+    TestException e;
+    size_t len = 0;
+
+    if (NULL == expected || NULL == actual)
+    {
+        appendFormat(e.msg_, e.msgSize, len, "%s" "%s buffer is NULL", prefix, (NULL == expected) ? "expected" : "actual");
+        throw e;
+    }
+
+    const unsigned char *lhs = static_cast<const unsigned char*>(expected);
+    const unsigned char *rhs = static_cast<const unsigned char*>(actual);
+    const size_t different = countMemMismatches(lhs + mismatch, rhs + mismatch, size - mismatch);
+
+    appendFormat(e.msg_, e.msgSize, len, "%s" "memory differs at offset %llu (0x%llx), %llu of %llu bytes differ:",
+                 prefix, static_cast<unsigned long long>(mismatch), static_cast<unsigned long long>(mismatch),
+                 static_cast<unsigned long long>(different), static_cast<unsigned long long>(size));
+
+    enum {rowSize = 16, rowsBefore = 2, rowsAfter = 3};
+    const size_t mismatchRow = mismatch / rowSize;
+    const size_t firstRow = (mismatchRow > rowsBefore) ? mismatchRow - rowsBefore : 0;
+    const size_t rowsNumber = (size + rowSize - 1) / rowSize;
+    const size_t endRow = (mismatchRow + rowsAfter + 1 < rowsNumber) ? mismatchRow + rowsAfter + 1 : rowsNumber;
+
+    for (size_t row = firstRow; row < endRow; ++row)
+    {
+        const size_t offset = row * rowSize;
+        const size_t rowBytes = (size - offset < rowSize) ? size - offset : rowSize;
+        if (rowBytes == firstMemMismatch(lhs + offset, rhs + offset, rowBytes))
+        {
+            appendMemRow(e.msg_, e.msgSize, len, ' ', offset, lhs + offset, rowBytes);
+            continue;
+        }
+
+        appendMemRow(e.msg_, e.msgSize, len, '-', offset, lhs + offset, rowBytes);
+        appendMemRow(e.msg_, e.msgSize, len, '+', offset, rhs + offset, rowBytes);
+        appendFormat(e.msg_, e.msgSize, len, "\n          ");
+        for (size_t idx = 0; idx < rowBytes; ++idx)
+            appendFormat(e.msg_, e.msgSize, len, (lhs[offset + idx] != rhs[offset + idx]) ? " ^^" : "   ");
+    }
+
+    throw e;
+}
+
+void throwRangeException(const char *prefix, size_t expectedSize, size_t actualSize, size_t mismatch,
+                         size_t mismatches, const char *expectedValue, const char *actualValue)
+{
+    TestException e;
+    size_t len = 0;
+
+    appendFormat(e.msg_, e.msgSize, len, "%s" "ranges differ:", prefix);
+    if (expectedSize != actualSize)
+        appendFormat(e.msg_, e.msgSize, len, " size %llu != %llu;", static_cast<unsigned long long>(expectedSize),
+                     static_cast<unsigned long long>(actualSize));
+
+    const size_t compared = (expectedSize < actualSize) ? expectedSize : actualSize;
+    if (mismatch < compared)
+        appendFormat(e.msg_, e.msgSize, len, " [%llu] %s != %s, %llu of %llu elements differ",
+                     static_cast<unsigned long long>(mismatch), expectedValue, actualValue,
+                     static_cast<unsigned long long>(mismatches), static_cast<unsigned long long>(compared));
+    else
+        appendFormat(e.msg_, e.msgSize, len, " the first %llu elements are equal",
+                     static_cast<unsigned long long>(compared));
+
+    throw e;
+}
+
 YUNIT_NS_END
@@ -14,9 +14,17 @@
 
 // own headers are included before system headers for detection abscence of dependent headers includence
 #include "../yunit/yunit.h"
+#include "alloc_counter.h"
+#include "benchmark.h"
+#include "death_test.h"
 
 #include <string> // for STL strings comparison macro
 #include <stdexcept>
+#include <cstdio>
+#include <iterator>
+#include <limits>
+#include <type_traits>
+#include <utility>
 
 
 YUNIT_NS_BEGIN
@@ -70,6 +78,23 @@ YUNIT_NS_BEGIN
         YUNIT_NS_PREF(throwException)(ASSERT_MESSAGE_PREFIX(__FILE__, __LINE__), (expected), (actual), (delta), false);\
 }
 
+/// Compare 'size' bytes of buffers; failure message contains offset of the first different byte, number of
+/// different bytes and hex dump of both buffers around the first difference
+#define areMemEq(expected, actual, size)\
+{\
+    YUNIT_NS_PREF(checkMemEq)(ASSERT_MESSAGE_PREFIX(__FILE__, __LINE__), (expected), (actual), (size));\
+}
+
+/// Compare ranges (containers, arrays) by size and elements; failure message contains sizes, index and values
+/// of the first different element and number of different elements
+/// @code
+/// areRangesEq(expectedIds, parseIds(text));
+/// @endcode
+#define areRangesEq(expected, actual)\
+{\
+    YUNIT_NS_PREF(checkRangesEq)(ASSERT_MESSAGE_PREFIX(__FILE__, __LINE__), (expected), (actual));\
+}
+
 #define willThrow(expression, exceptionType)																\
     for (;;) \
     {                                                                                                       \
@@ -111,6 +136,56 @@ YUNIT_NS_BEGIN
     }\
 }
 
+/// @brief Check, that 'expression' kills process: by signal (abort, crash) or by exit with non-zero code, and
+/// its stderr output contains match of regular expression 'stderrPattern' ("" matches any output).
+/// Expression is executed in forked child process, so test process survives. You have to add death_test.cpp
+/// into your project to use it.
+/// @code
+/// willDie(parseConfig(NULL), "config is NULL");
+/// @endcode
+#define willDie(expression, stderrPattern)\
+{\
+    auto deathStatement = [&]() { expression; };\
+    YUNIT_NS_PREF(checkDeath)(ASSERT_MESSAGE_PREFIX(__FILE__, __LINE__) #expression,\
+                              YUNIT_NS_PREF(runInChild)(deathStatement), stderrPattern);\
+}
+
+/// @brief Check, that 'expression' calls exit with 'exitCode'. Expression is executed in forked child process.
+#define willExit(expression, exitCode)\
+{\
+    auto deathStatement = [&]() { expression; };\
+    YUNIT_NS_PREF(checkExit)(ASSERT_MESSAGE_PREFIX(__FILE__, __LINE__) #expression,\
+                             YUNIT_NS_PREF(runInChild)(deathStatement), exitCode);\
+}
+
+/// @brief Check, that 'expression' makes not more than 'maxAllocations' heap allocations in current thread.
+/// Failure message contains number of allocations and call stack of the first exceeding one.
+/// Allocations are counted only if allocator interposer is linked into test program (see alloc_counter.h),
+/// otherwise assert always passes.
+#define assertMaxAllocations(maxAllocations, expression)\
+{\
+    YUNIT_NS_PREF(AllocationBudget) allocationBudget(maxAllocations);\
+    expression;\
+    allocationBudget.check(ASSERT_MESSAGE_PREFIX(__FILE__, __LINE__) #expression);\
+}
+
+#define noAllocations(expression) assertMaxAllocations(0, expression)
+
+/// @brief Measure 'expression' duration and compare it with baseline 'baselineKey', stored in baselines file
+/// ('--baselines' option) or in memory of process.
+/// Assert fails, if median of measurements is more than (1 + tolerance) times slower than baseline one and
+/// difference is statistically significant (Mann-Whitney test), so noise of single run does not fail test.
+/// Missing baseline is recorded by the first run. You have to add benchmark.cpp into your project to use it.
+/// @code
+/// assertNotSlowerThan("sort 1000 ints", std::sort(copy.begin(), copy.end()), 0.1);
+/// @endcode
+#define assertNotSlowerThan(baselineKey, expression, tolerance)\
+{\
+    auto benchmarkBody = [&]() { expression; };\
+    YUNIT_NS_PREF(checkNotSlowerThan)(ASSERT_MESSAGE_PREFIX(__FILE__, __LINE__) #expression, baselineKey,\
+                                      YUNIT_NS_PREF(measure)(benchmarkBody), tolerance);\
+}
+
 
 #ifdef _WIN32 // use _WIN32 instead of WIN32, because _WIN32 is automatically defined by the visual C/C++ compiler
 
@@ -147,6 +222,12 @@ bool areEqValues(const void *expected, const void *actual);
 bool areEqValues(const char *expected, const char *actual);
 bool areEqValues(const wchar_t *expected, const wchar_t *actual);
 
+/// @return Offset of the first different byte of buffers or 'size', if they are equal
+size_t firstMemMismatch(const void *expected, const void *actual, size_t size);
+
+/// @return Number of different bytes of buffers
+size_t countMemMismatches(const void *expected, const void *actual, size_t size);
+
 inline bool areEqValues(const std::wstring& expected, const std::wstring& actual)
 {
     return areEqValues(expected.c_str(), actual.c_str());
@@ -165,6 +246,15 @@ void throwException(const char *prefix, const long long expected, const long lon
 void throwException(const char *prefix, const char* expected, const char* actual, bool mustBeEqual);
 void throwException(const char *prefix, const wchar_t* expected, const wchar_t* actual, bool mustBeEqual);
 void throwException(const char *prefix, const double expected, const double actual, const double delta, bool mustBeEqual);
+void throwMemException(const char *prefix, const void *expected, const void *actual, size_t size, size_t mismatch);
+
+/// @brief 'areMemEq' implementation, so arguments of macro are evaluated once
+inline void checkMemEq(const char *prefix, const void *expected, const void *actual, size_t size)
+{
+    const size_t mismatch = firstMemMismatch(expected, actual, size);
+    if (size != mismatch)
+        throwMemException(prefix, expected, actual, size, mismatch);
+}
 
 // This function is inline historically. Firstly it was a part of yUnit API, built as Dinamic Link Library.
 // There is a problem to pass STL strings inside DLL functions, because they are different for Debug and
@@ -184,6 +274,166 @@ inline void throwException(const char *prefix, const std::wstring& expected, con
     throwException(prefix, expected.c_str(), actual.c_str(), mustBeEqual);
 }
 
+void throwRangeException(const char *prefix, size_t expectedSize, size_t actualSize, size_t mismatch,
+                         size_t mismatches, const char *expectedValue, const char *actualValue);
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Range comparison for 'areRangesEq'. Ranges are iterated by 'begin' and 'end', elements are compared by
+// operator==. Contiguous ranges (arrays and containers with 'data()': vector, array, string) of the same
+// integral, enum or pointer elements are compared as memory by vectorized 'firstMemMismatch' instead.
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template<typename Range, typename Enable = void>
+struct RangeData
+{
+    typedef void Element;
+};
+
+template<typename T, size_t N>
+struct RangeData<T[N]>
+{
+    typedef typename std::remove_cv<T>::type Element;
+
+    static const Element* data(const T (&range)[N])
+    {
+        return range;
+    }
+};
+
+template<typename Range>
+struct RangeData<Range, typename std::enable_if<std::is_pointer<decltype(std::declval<const Range&>().data())>::value>::type>
+{
+    typedef typename std::remove_cv<typename std::remove_pointer<decltype(std::declval<const Range&>().data())>::type>::type
+        Element;
+
+    static const Element* data(const Range &range)
+    {
+        return range.data();
+    }
+};
+
+template<typename Expected, typename Actual>
+struct AreMemComparableRanges
+{
+    typedef typename RangeData<Expected>::Element Element;
+
+    enum
+    {
+        value = std::is_same<Element, typename RangeData<Actual>::Element>::value
+             && (std::is_integral<Element>::value || std::is_enum<Element>::value || std::is_pointer<Element>::value)
+    };
+};
+
+/// @brief Printer of element value for failure message, specialize it for own types
+template<typename T, typename Enable = void>
+struct RangeElement
+{
+    static void print(const T &/*value*/, std::string &out)
+    {
+        out += "(not printable)";
+    }
+};
+
+template<typename T>
+struct RangeElement<T, typename std::enable_if<std::is_integral<T>::value || std::is_enum<T>::value>::type>
+{
+    static void print(const T &value, std::string &out)
+    {
+        if (std::is_signed<T>::value)
+            out += std::to_string(static_cast<long long>(value));
+        else
+            out += std::to_string(static_cast<unsigned long long>(value));
+    }
+};
+
+template<typename T>
+struct RangeElement<T, typename std::enable_if<std::is_floating_point<T>::value>::type>
+{
+    // shortest precision, which keeps value distinguishable from its neighbours
+    static void print(const T &value, std::string &out)
+    {
+        char buf[64];
+        TS_SNPRINTF(buf, sizeof(buf), "%.*Lg", std::numeric_limits<T>::max_digits10, static_cast<long double>(value));
+        buf[sizeof(buf) - 1] = '\0';
+        out += buf;
+    }
+};
+
+template<typename T>
+struct RangeElement<T*>
+{
+    static void print(T *value, std::string &out)
+    {
+        char buf[32];
+        TS_SNPRINTF(buf, sizeof(buf), "%p", static_cast<const volatile void*>(value));
+        buf[sizeof(buf) - 1] = '\0';
+        out += buf;
+    }
+};
+
+template<typename Char>
+struct RangeElement<std::basic_string<Char> >
+{
+    static void print(const std::basic_string<Char> &value, std::string &out)
+    {
+        out += '"';
+        for (size_t idx = 0; idx < value.size(); ++idx)
+            out += (value[idx] >= 0x20 && value[idx] < 0x7F) ? static_cast<char>(value[idx]) : '?';
+        out += '"';
+    }
+};
+
+template<typename Expected, typename Actual>
+size_t firstRangeMismatch(const Expected &expected, const Actual &actual, size_t size, std::true_type)
+{
+    typedef typename RangeData<Expected>::Element Element;
+    return firstMemMismatch(RangeData<Expected>::data(expected), RangeData<Actual>::data(actual),
+                            size * sizeof(Element)) / sizeof(Element);
+}
+
+template<typename Expected, typename Actual>
+size_t firstRangeMismatch(const Expected &expected, const Actual &actual, size_t size, std::false_type)
+{
+    using std::begin;
+    auto expectedIt = begin(expected);
+    auto actualIt = begin(actual);
+    size_t idx = 0;
+    for (; idx < size && *expectedIt == *actualIt; ++idx, ++expectedIt, ++actualIt)
+        ;
+    return idx;
+}
+
+template<typename Expected, typename Actual>
+void checkRangesEq(const char *prefix, const Expected &expected, const Actual &actual)
+{
+    using std::begin;
+    using std::end;
+    const size_t expectedSize = static_cast<size_t>(std::distance(begin(expected), end(expected)));
+    const size_t actualSize = static_cast<size_t>(std::distance(begin(actual), end(actual)));
+    const size_t size = (expectedSize < actualSize) ? expectedSize : actualSize;
+
+    typedef std::integral_constant<bool, AreMemComparableRanges<Expected, Actual>::value> MemComparable;
+    const size_t mismatch = firstRangeMismatch(expected, actual, size, MemComparable());
+    if (mismatch == size && expectedSize == actualSize)
+        return;
+
+    // failure path: the rest of elements is compared one by one to count differences
+    std::string expectedValue, actualValue;
+    size_t mismatches = 0;
+    if (mismatch < size)
+    {
+        auto expectedIt = std::next(begin(expected), mismatch);
+        auto actualIt = std::next(begin(actual), mismatch);
+        RangeElement<typename std::decay<decltype(*expectedIt)>::type>::print(*expectedIt, expectedValue);
+        RangeElement<typename std::decay<decltype(*actualIt)>::type>::print(*actualIt, actualValue);
+
+        for (size_t idx = mismatch; idx < size; ++idx, ++expectedIt, ++actualIt)
+            mismatches += (*expectedIt == *actualIt) ? 0 : 1;
+    }
+
+    throwRangeException(prefix, expectedSize, actualSize, mismatch, mismatches, expectedValue.c_str(),
+                        actualValue.c_str());
+}
+
 
 YUNIT_NS_END
 
@@ -1,5 +1,30 @@
 #include "asserts.h"
 #include <cstdio>
+#include <list>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// message of assert, which must fail
+template<typename Check>
+static std::string failureMessage(Check check)
+{
+    try
+    {
+        check();
+    }
+    catch (std::exception &e)
+    {
+        return e.what();
+    }
+    return std::string();
+}
+
+static void hasPart(const std::string &message, const char *part)
+{
+    if (std::string::npos == message.find(part))
+        throw std::logic_error("assert message \"" + message + "\" does not contain \"" + part + "\"");
+}
 
 int main(int /*argc*/, char ** /*argv*/)
 {
@@ -31,6 +56,50 @@ int main(int /*argc*/, char ** /*argv*/)
     };
     areNotEq((void*)main, (void*)___::foo);
 
+    unsigned char expectedMem[1000], actualMem[1000];
+    for (size_t idx = 0; idx < sizeof(expectedMem); ++idx)
+        expectedMem[idx] = actualMem[idx] = static_cast<unsigned char>(idx * 7);
+    for (size_t size = 0; size < 100; ++size)
+        areMemEq(expectedMem + size % 5, actualMem + size % 5, size);
+    areMemEq(NULL, NULL, 0);
+
+    // every argument of macro is evaluated once
+    const unsigned char *expectedPtr = expectedMem, *actualPtr = actualMem;
+    size_t sizeArg = 8;
+    areMemEq(expectedPtr++, actualPtr++, sizeArg++);
+    isTrue(expectedMem + 1 == expectedPtr && actualMem + 1 == actualPtr && 9 == sizeArg);
+
+    // vector kernels are checked against byte by byte comparison at every offset of the first difference
+    for (size_t mismatch = 0; mismatch < 200; ++mismatch)
+    {
+        actualMem[mismatch] ^= 0x5A;
+        actualMem[mismatch + 40] ^= 0x01;
+        for (size_t size = mismatch; size < 250; size += 13)
+        {
+            size_t first = 0, count = 0;
+            while (first < size && expectedMem[first] == actualMem[first])
+                ++first;
+            for (size_t idx = 0; idx < size; ++idx)
+                count += (expectedMem[idx] != actualMem[idx]) ? 1 : 0;
+            areEq(first, YUNIT_NS_PREF(firstMemMismatch)(expectedMem, actualMem, size));
+            areEq(count, YUNIT_NS_PREF(countMemMismatches)(expectedMem, actualMem, size));
+        }
+        actualMem[mismatch] ^= 0x5A;
+        actualMem[mismatch + 40] ^= 0x01;
+    }
+
+    std::vector<int> expectedInts(100000), actualInts;
+    for (size_t idx = 0; idx < expectedInts.size(); ++idx)
+        expectedInts[idx] = static_cast<int>(idx * idx);
+    actualInts = expectedInts;
+    areRangesEq(expectedInts, actualInts);
+    areRangesEq(std::vector<int>(), std::vector<int>());
+    const int intsArray[] = {0, 1, 4, 9};
+    areRangesEq(intsArray, std::vector<int>(expectedInts.begin(), expectedInts.begin() + 4));
+    areRangesEq(std::list<int>(intsArray, intsArray + 4), std::vector<long long>(intsArray, intsArray + 4));
+    areRangesEq(std::string("range"), std::string("range"));
+    areRangesEq(std::vector<std::string>(3, "a"), std::list<std::string>(3, "a"));
+
     willThrow(std::exception mustBeCatched; throw mustBeCatched;, std::exception);
 
     try
@@ -69,5 +138,36 @@ int main(int /*argc*/, char ** /*argv*/)
         printf("%s\n", e.what());
     }
 
+    // failure messages point at the first difference and count all of them
+    actualMem[70] = 'y';
+    actualMem[75] = 'a';
+    willThrow(areMemEq(expectedMem, actualMem, 130), std::exception);
+    const std::string memMessage = failureMessage([&]() { areMemEq(expectedMem, actualMem, 130); });
+    hasPart(memMessage, "memory differs at offset 70 (0x46), 2 of 130 bytes differ");
+    hasPart(memMessage, "+00000040: c0 c7 ce d5 dc e3 79 f1 f8 ff 06 61");
+
+    actualInts[500] = -1;
+    actualInts[90000] = -1;
+    willThrow(areRangesEq(expectedInts, actualInts), std::exception);
+    hasPart(failureMessage([&]() { areRangesEq(expectedInts, actualInts); }),
+            "[500] 250000 != -1, 2 of 100000 elements differ");
+
+    willThrow(areRangesEq(std::vector<double>(3, 0.5), std::list<double>(2, 0.5)), std::exception);
+    hasPart(failureMessage([]() { areRangesEq(std::vector<double>(3, 0.5), std::list<double>(2, 0.5)); }),
+            "size 3 != 2; the first 2 elements are equal");
+
+    // floating point elements are printed with full precision
+    std::vector<double> actualDoubles(2, 0.1);
+    actualDoubles[1] = 0.1 + 1e-15;
+    willThrow(areRangesEq(std::vector<double>(2, 0.1), actualDoubles), std::exception);
+    hasPart(failureMessage([&]() { areRangesEq(std::vector<double>(2, 0.1), actualDoubles); }),
+            "[1] 0.10000000000000001 != 0.100000000000001");
+
+    std::vector<std::string> actualStrings(2, "a");
+    actualStrings[1] = "b";
+    willThrow(areRangesEq(std::vector<std::string>(3, "a"), actualStrings), std::exception);
+    hasPart(failureMessage([&]() { areRangesEq(std::vector<std::string>(3, "a"), actualStrings); }),
+            "size 3 != 2; [1] \"a\" != \"b\", 1 of 2 elements differ");
+
     return 0;
 }
@@ -0,0 +1,286 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// benchmark.cpp
+//
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "benchmark.h"
+#include "benchmark_store.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+
+YUNIT_NS_BEGIN
+
+const double benchmarkAlpha = 0.01;
+const char *defaultBaselineFile = ".yunit_baselines";
+const char *defaultBenchmarkHistoryFile = ".yunit_benchmarks";
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+double median(Samples samples)
+{
+    if (samples.empty())
+        return 0;
+
+    const size_t middle = samples.size() / 2;
+    std::nth_element(samples.begin(), samples.begin() + middle, samples.end());
+    if (samples.size() % 2)
+        return samples[middle];
+
+    const double upper = samples[middle];
+    return (*std::max_element(samples.begin(), samples.begin() + middle) + upper) / 2;
+}
+
+double slowerPValue(const Samples &baseline, const Samples &current)
+{
+    const size_t n1 = baseline.size(), n2 = current.size(), n = n1 + n2;
+    if (0 == n1 || 0 == n2)
+        return 1;
+
+    // (value, belongs to 'current')
+    std::vector<std::pair<double, bool> > all;
+    all.reserve(n);
+    for (size_t idx = 0; idx < n1; ++idx)
+        all.push_back(std::make_pair(baseline[idx], false));
+    for (size_t idx = 0; idx < n2; ++idx)
+        all.push_back(std::make_pair(current[idx], true));
+    std::sort(all.begin(), all.end());
+
+    // ranks sum of 'current' values; tied values get average rank
+    double currentRanks = 0, tiesCorrection = 0;
+    for (size_t first = 0; first < n; )
+    {
+        size_t last = first;
+        while (last + 1 < n && all[last + 1].first == all[first].first)
+            ++last;
+
+        const double rank = (first + last) / 2.0 + 1;
+        for (size_t idx = first; idx <= last; ++idx)
+            if (all[idx].second)
+                currentRanks += rank;
+
+        const double ties = static_cast<double>(last - first + 1);
+        tiesCorrection += ties * ties * ties - ties;
+        first = last + 1;
+    }
+
+    const double u = currentRanks - n2 * (n2 + 1) / 2.0;
+    const double mean = n1 * n2 / 2.0;
+    const double variance = n1 * n2 / 12.0 * ((n + 1) - tiesCorrection / (static_cast<double>(n) * (n - 1)));
+    if (variance <= 0)
+        return 1;
+
+    const double z = (u - mean - 0.5) / ::sqrt(variance);
+    return 0.5 * ::erfc(z / ::sqrt(2.0));
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+class BaselineStore
+{
+public:
+    BaselineStore()
+    : loaded_(false)
+    , update_(false)
+    {
+    }
+
+    void setPath(const char *path)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        path_ = NULL != path ? path : "";
+        loaded_ = false;
+    }
+
+    void setUpdate(bool update)
+    {
+        update_ = update;
+    }
+
+    // @return true if 'baseline' has been found, otherwise 'samples' are stored as new baseline
+    bool baseline(const char *key, const Samples &samples, Samples &baseline)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        load();
+
+        Baselines::const_iterator it = baselines_.find(key);
+        if (baselines_.end() != it && !update_)
+        {
+            baseline = it->second;
+            return true;
+        }
+
+        baselines_[key] = samples;
+        save();
+        return false;
+    }
+
+private:
+    void load()
+    {
+        if (loaded_)
+            return;
+        loaded_ = true;
+        baselines_.clear();
+        if (path_.empty())
+            return;
+
+        FILE *file = ::fopen(path_.c_str(), "r");
+        if (NULL == file)
+            return;
+
+        enum {lineSize = 16 * 1024};
+        char line[lineSize];
+        while (::fgets(line, lineSize, file))
+        {
+            char *tab = ::strchr(line, '\t');
+            if (NULL == tab)
+                continue;
+
+            Samples &samples = baselines_[std::string(line, tab - line)];
+            for (char *ptr = tab + 1, *end = NULL; ; ptr = end)
+            {
+                const double value = ::strtod(ptr, &end);
+                if (ptr == end)
+                    break;
+                samples.push_back(value);
+            }
+        }
+
+        ::fclose(file);
+    }
+
+    void save() const
+    {
+        if (path_.empty())
+            return;
+
+        FILE *file = ::fopen(path_.c_str(), "w");
+        if (NULL == file)
+            return;
+
+        for (Baselines::const_iterator it = baselines_.begin(), endIt = baselines_.end(); it != endIt; ++it)
+        {
+            ::fprintf(file, "%s\t", it->first.c_str());
+            for (size_t idx = 0, size = it->second.size(); idx < size; ++idx)
+                ::fprintf(file, idx ? " %.17g" : "%.17g", it->second[idx]);
+            ::fprintf(file, "\n");
+        }
+
+        ::fclose(file);
+    }
+
+    typedef std::map<std::string, Samples> Baselines;
+    Baselines baselines_;
+    std::string path_; ///< empty path means, that baselines live in memory of process only
+    bool loaded_;
+    bool update_;
+    std::mutex mutex_;
+};
+
+static BaselineStore& baselineStore()
+{
+    static BaselineStore store;
+    return store;
+}
+
+void setBaselineFile(const char *path)
+{
+    baselineStore().setPath(path);
+}
+
+void setUpdateBaselines(bool update)
+{
+    baselineStore().setUpdate(update);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+class BenchmarkHistory
+{
+public:
+    BenchmarkHistory()
+    : enabled_(false)
+    {
+        const char *commit = ::getenv("YUNIT_COMMIT");
+        if (NULL != commit)
+            commit_ = commit;
+    }
+
+    void setPath(const char *path)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        enabled_ = NULL != path;
+        if (enabled_)
+            path_ = path;
+    }
+
+    void setCommit(const char *commit)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        commit_ = commit;
+    }
+
+    void record(const char *key, const Samples &samples)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!enabled_)
+            return;
+
+        BenchmarkStore::append(path_.c_str(), BenchmarkStore::summarize(key, commit_.c_str(),
+                               BenchmarkStore::machineFingerprint().c_str(), samples));
+    }
+
+private:
+    std::string path_;
+    std::string commit_;
+    bool enabled_;
+    std::mutex mutex_;
+};
+
+static BenchmarkHistory& benchmarkHistory()
+{
+    static BenchmarkHistory history;
+    return history;
+}
+
+void setBenchmarkHistoryFile(const char *path)
+{
+    benchmarkHistory().setPath(path);
+}
+
+void setBenchmarkCommit(const char *commit)
+{
+    benchmarkHistory().setCommit(commit);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void checkNotSlowerThan(const char *prefix, const char *key, const Samples &samples, double tolerance)
+{
+    benchmarkHistory().record(key, samples);
+
+    Samples baseline;
+    if (!baselineStore().baseline(key, samples, baseline))
+        return;
+
+    const double baselineMedian = median(baseline);
+    const double currentMedian = median(samples);
+    if (currentMedian <= baselineMedian * (1 + tolerance))
+        return;
+
+    const double pValue = slowerPValue(baseline, samples);
+    if (pValue >= benchmarkAlpha)
+        return;
+
+    enum {msgSize = 1024};
+    char msg[msgSize];
+    TS_SNPRINTF(msg, msgSize, "%s" "\"%s\" is slower than baseline: median %.1f ns, baseline %.1f ns (+%.1f%%, allowed +%.1f%%, p = %.4f)",
+                prefix, key, currentMedian, baselineMedian, (currentMedian / baselineMedian - 1) * 100, tolerance * 100, pValue);
+    msg[msgSize - 1] = '\0';
+    throw std::logic_error(msg);
+}
+
+YUNIT_NS_END
@@ -0,0 +1,98 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// @file benchmark.h
+//
+// Repeated time measurement of code fragment and its statistical comparison with a recorded baseline.
+// Used by 'assertNotSlowerThan' assert.
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#ifndef _BENCHMARK_YUNIT_HEADER_
+#define _BENCHMARK_YUNIT_HEADER_
+
+#include "tests.h"
+#include <vector>
+
+YUNIT_NS_BEGIN
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief Durations of one iteration (nanoseconds), every sample is an average of series of iterations
+typedef std::vector<double> Samples;
+
+enum
+{
+    benchmarkSamples = 20,             ///< number of samples in normal case
+    benchmarkMinSamples = 5,           ///< number of samples for very slow code
+    benchmarkSampleTimeNs = 2000000,   ///< minimal duration of one sample
+    benchmarkTimeBudgetNs = 1000000000 ///< samples number is decreased, if measurement would last longer
+};
+
+/// @brief Significance level of regression detection
+extern const double benchmarkAlpha;
+
+/// @brief Measure 'func()' duration
+template<typename Func>
+Samples measure(Func &func)
+{
+    func(); // warm up caches, lazy initialization and so on
+
+    unsigned long long startTime = currentTimeNs();
+    func();
+    unsigned long long iterationNs = currentTimeNs() - startTime;
+    if (0 == iterationNs)
+        iterationNs = 1;
+
+    const unsigned long long iterations = iterationNs >= benchmarkSampleTimeNs ? 1 : benchmarkSampleTimeNs / iterationNs;
+    unsigned long long samplesNumber = benchmarkTimeBudgetNs / (iterations * iterationNs);
+    if (samplesNumber > benchmarkSamples)
+        samplesNumber = benchmarkSamples;
+    else if (samplesNumber < benchmarkMinSamples)
+        samplesNumber = benchmarkMinSamples;
+
+    Samples samples;
+    samples.reserve(static_cast<size_t>(samplesNumber));
+
+    for (unsigned long long sampleIdx = 0; sampleIdx < samplesNumber; ++sampleIdx)
+    {
+        startTime = currentTimeNs();
+        for (unsigned long long iteration = 0; iteration < iterations; ++iteration)
+            func();
+        samples.push_back(static_cast<double>(currentTimeNs() - startTime) / iterations);
+    }
+
+    return samples;
+}
+
+double median(Samples samples);
+
+/// @brief One-sided Mann-Whitney U test (normal approximation with ties correction)
+/// @return Probability to get such or larger 'current' values, if both samples have the same distribution
+double slowerPValue(const Samples &baseline, const Samples &current);
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief Baselines are stored in text file, one per line: <key>\t<sample>[ <sample>...]
+/// File is used only if it has been set ('--baselines' or '--baselines=<path>' command line option), otherwise
+/// baselines are kept in memory of process and the first measurement of every key becomes its baseline.
+/// NULL path returns to in-memory baselines.
+void setBaselineFile(const char *path);
+
+/// @brief Replace stored baselines with new measurements instead of comparison ('--update-baselines')
+void setUpdateBaselines(bool update);
+
+extern const char *defaultBaselineFile;
+
+/// @brief Every measurement is appended to benchmark history file (see BenchmarkStore) with current commit and
+/// machine fingerprint ('--benchmark-history' or '--benchmark-history=<path>'). History is not stored by default,
+/// NULL path disables it ('--no-benchmark-history').
+void setBenchmarkHistoryFile(const char *path);
+
+/// @brief Identifier of tested sources revision ('--commit=<id>'), YUNIT_COMMIT environment variable by default
+void setBenchmarkCommit(const char *commit);
+
+extern const char *defaultBenchmarkHistoryFile;
+
+/// @brief Compare 'samples' with baseline 'key'
+/// Baseline is recorded, if it is absent. Exception is thrown, if 'samples' median is slower than baseline one
+/// more than in (1 + tolerance) times and difference is statistically significant.
+void checkNotSlowerThan(const char *prefix, const char *key, const Samples &samples, double tolerance);
+
+YUNIT_NS_END
+
+#endif // _BENCHMARK_YUNIT_HEADER_
@@ -0,0 +1,116 @@
+#include "asserts.h"
+#include "benchmark.h"
+#include "benchmark_store.h"
+#include <cstdio>
+
+static YUNIT_NS_PREF(Samples) series(double from, double step, int size)
+{
+    YUNIT_NS_PREF(Samples) res;
+    for (int idx = 0; idx < size; ++idx)
+        res.push_back(from + step * idx);
+    return res;
+}
+
+static bool exists(const char *path)
+{
+    FILE *file = ::fopen(path, "r");
+    if (NULL != file)
+        ::fclose(file);
+    return NULL != file;
+}
+
+int main(int /*argc*/, char ** /*argv*/)
+{
+    using YUNIT_NS_PREF(Samples);
+
+    areDoubleEq(2., YUNIT_NS_PREF(median)(series(1, 1, 3)), 1e-9);
+    areDoubleEq(2.5, YUNIT_NS_PREF(median)(series(1, 1, 4)), 1e-9);
+
+    const Samples baseline = series(100, 1, 20);
+    isTrue(YUNIT_NS_PREF(slowerPValue)(baseline, baseline) > 0.4);
+    isTrue(YUNIT_NS_PREF(slowerPValue)(baseline, series(200, 1, 20)) < YUNIT_NS_PREF(benchmarkAlpha));
+    isTrue(YUNIT_NS_PREF(slowerPValue)(baseline, series(50, 1, 20)) > 0.99);
+    areDoubleEq(1., YUNIT_NS_PREF(slowerPValue)(Samples(5, 1.), Samples(5, 1.)), 1e-9); // all values are tied
+
+    // until files are set, baselines live in memory of process and benchmark history is not stored
+    const bool baselinesExisted = exists(YUNIT_NS_PREF(defaultBaselineFile));
+    const bool historyExisted = exists(YUNIT_NS_PREF(defaultBenchmarkHistoryFile));
+    YUNIT_NS_PREF(checkNotSlowerThan)("", "memory", baseline, 0.05);
+    willThrow(YUNIT_NS_PREF(checkNotSlowerThan)("", "memory", series(150, 1, 20), 0.05), std::logic_error);
+    areEq(baselinesExisted, exists(YUNIT_NS_PREF(defaultBaselineFile)));
+    areEq(historyExisted, exists(YUNIT_NS_PREF(defaultBenchmarkHistoryFile)));
+
+    const char *baselineFile = "benchmark_test.baselines";
+    ::remove(baselineFile);
+    YUNIT_NS_PREF(setBaselineFile)(baselineFile);
+
+    const char *historyFile = "benchmark_test.history";
+    ::remove(historyFile);
+    YUNIT_NS_PREF(setBenchmarkHistoryFile)(historyFile);
+    YUNIT_NS_PREF(setBenchmarkCommit)("first");
+
+    // first check records baseline, next ones compare with it
+    YUNIT_NS_PREF(checkNotSlowerThan)("", "series", baseline, 0.05);
+    YUNIT_NS_PREF(checkNotSlowerThan)("", "series", series(101, 1, 20), 0.05);
+    willThrow(YUNIT_NS_PREF(checkNotSlowerThan)("", "series", series(150, 1, 20), 0.05), std::logic_error);
+
+    // baseline is reloaded from file
+    YUNIT_NS_PREF(setBaselineFile)(baselineFile);
+    willThrow(YUNIT_NS_PREF(checkNotSlowerThan)("", "series", series(150, 1, 20), 0.05), std::logic_error);
+    YUNIT_NS_PREF(checkNotSlowerThan)("", "series", series(150, 1, 20), 1.);
+
+    YUNIT_NS_PREF(setBenchmarkCommit)("second");
+    YUNIT_NS_PREF(setUpdateBaselines)(true);
+    YUNIT_NS_PREF(checkNotSlowerThan)("", "series", series(150, 1, 20), 0.05);
+    YUNIT_NS_PREF(setUpdateBaselines)(false);
+    YUNIT_NS_PREF(checkNotSlowerThan)("", "series", series(150, 1, 20), 0.05);
+
+    volatile unsigned int sum = 0;
+    assertNotSlowerThan("loop", for (unsigned int i = 0; i < 1000; ++i) sum += i, 100.);
+    assertNotSlowerThan("loop", for (unsigned int i = 0; i < 1000; ++i) sum += i, 100.);
+
+    try
+    {
+        YUNIT_NS_PREF(checkNotSlowerThan)("", "series", series(300, 1, 20), 0.05);
+    }
+    catch (std::exception &e)
+    {
+        printf("%s\n", e.what());
+    }
+
+    // every measurement is stored into history with commit and machine fingerprint
+    using YUNIT_NS_PREF(BenchmarkStore);
+    using YUNIT_NS_PREF(BenchmarkRecord);
+    using YUNIT_NS_PREF(BenchmarkDelta);
+
+    BenchmarkStore store;
+    isTrue(store.load(historyFile));
+    const std::string &machine = BenchmarkStore::machineFingerprint();
+    areEq("second", store.lastCommit(machine));
+    areEq("first", store.previousCommit(machine, "second"));
+    isTrue(store.previousCommit(machine, "first").empty());
+
+    const BenchmarkRecord *first = store.find("series", "first", machine);
+    const BenchmarkRecord *second = store.find("series", "second", machine);
+    isNotNull(first);
+    isNotNull(second);
+    areEq(20u, second->samples_);
+    areDoubleEq(309.5, second->mean_, 0.01);
+    areDoubleEq(309.5, second->median_, 0.01);
+    areDoubleEq(35., second->variance_, 0.01);
+    isNull(store.find("series", "first", "other machine"));
+
+    const BenchmarkDelta same = BenchmarkStore::compare(*second, *second, 0.95);
+    areDoubleEq(0., same.delta_, 1e-9);
+    isTrue(same.lower_ < 0 && same.upper_ > 0);
+
+    const BenchmarkRecord slower = BenchmarkStore::summarize("series", "third", machine.c_str(),
+                                                             series(400, 1, 20));
+    const BenchmarkDelta slowdown = BenchmarkStore::compare(*second, slower, 0.95);
+    areDoubleEq(100 * (409.5 / 309.5 - 1), slowdown.delta_, 1e-6);
+    isTrue(slowdown.lower_ > 20 && slowdown.upper_ < 40);
+
+    ::remove(baselineFile);
+    ::remove(historyFile);
+    return 0;
+}
@@ -0,0 +1,285 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// benchmark_store.cpp
+//
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "benchmark_store.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#ifdef _WIN32
+#  include <windows.h>
+#else
+#  include <unistd.h>
+#endif
+
+YUNIT_NS_BEGIN
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+BenchmarkRecord::BenchmarkRecord()
+: samples_(0)
+, mean_(0)
+, variance_(0)
+, median_(0)
+, time_(0)
+{
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// field of record must not contain separators
+static std::string field(const char *value)
+{
+    std::string res(NULL == value || '\0' == *value ? "-" : value);
+    for (size_t idx = 0, size = res.size(); idx < size; ++idx)
+        if ('\t' == res[idx] || '\n' == res[idx] || '\r' == res[idx])
+            res[idx] = ' ';
+    return res;
+}
+
+bool BenchmarkStore::load(const char *path)
+{
+    records_.clear();
+
+    FILE *file = ::fopen(path, "r");
+    if (NULL == file)
+        return false;
+
+    enum {lineSize = 4 * 1024};
+    char line[lineSize];
+
+    while (::fgets(line, lineSize, file))
+    {
+        char *fields[3] = {line, NULL, NULL};
+        char *numbers = NULL;
+        for (int idx = 0; idx < 3; ++idx)
+        {
+            char *tab = ::strchr(fields[idx], '\t');
+            if (NULL == tab)
+                break;
+            *tab = '\0';
+            if (idx < 2)
+                fields[idx + 1] = tab + 1;
+            else
+                numbers = tab + 1;
+        }
+
+        if (NULL == numbers)
+            continue;
+
+        BenchmarkRecord record;
+        unsigned long long time = 0;
+        if (5 != ::sscanf(numbers, "%u\t%lf\t%lf\t%lf\t%llu", &record.samples_, &record.mean_, &record.variance_,
+                          &record.median_, &time))
+            continue;
+
+        record.key_ = fields[0];
+        record.commit_ = fields[1];
+        record.machine_ = fields[2];
+        record.time_ = static_cast<time_t>(time);
+        records_.push_back(record);
+    }
+
+    ::fclose(file);
+    return true;
+}
+
+bool BenchmarkStore::append(const char *path, const BenchmarkRecord &record)
+{
+    FILE *file = ::fopen(path, "a");
+    if (NULL == file)
+        return false;
+
+    ::fprintf(file, "%s\t%s\t%s\t%u\t%.17g\t%.17g\t%.17g\t%llu\n",
+              field(record.key_.c_str()).c_str(), field(record.commit_.c_str()).c_str(),
+              field(record.machine_.c_str()).c_str(), record.samples_, record.mean_, record.variance_,
+              record.median_, static_cast<unsigned long long>(record.time_));
+
+    return 0 == ::fclose(file);
+}
+
+BenchmarkRecord BenchmarkStore::summarize(const char *key, const char *commit, const char *machine,
+                                          const std::vector<double> &samples)
+{
+    BenchmarkRecord record;
+    record.key_ = field(key);
+    record.commit_ = field(commit);
+    record.machine_ = field(machine);
+    record.samples_ = static_cast<unsigned int>(samples.size());
+    record.time_ = ::time(NULL);
+
+    if (samples.empty())
+        return record;
+
+    double sum = 0;
+    for (size_t idx = 0; idx < samples.size(); ++idx)
+        sum += samples[idx];
+    record.mean_ = sum / samples.size();
+
+    if (samples.size() > 1)
+    {
+        double squares = 0;
+        for (size_t idx = 0; idx < samples.size(); ++idx)
+            squares += (samples[idx] - record.mean_) * (samples[idx] - record.mean_);
+        record.variance_ = squares / (samples.size() - 1);
+    }
+
+    std::vector<double> sorted(samples);
+    std::sort(sorted.begin(), sorted.end());
+    const size_t middle = sorted.size() / 2;
+    record.median_ = sorted.size() % 2 ? sorted[middle] : (sorted[middle - 1] + sorted[middle]) / 2;
+
+    return record;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+static std::string cpuModel()
+{
+#ifdef _WIN32
+    const char *model = ::getenv("PROCESSOR_IDENTIFIER");
+    return NULL == model ? std::string() : std::string(model);
+#else
+    std::string res;
+    FILE *file = ::fopen("/proc/cpuinfo", "r");
+    if (NULL == file)
+        return res;
+
+    enum {lineSize = 1024};
+    char line[lineSize];
+    while (::fgets(line, lineSize, file))
+    {
+        if (0 != ::strncmp(line, "model name", sizeof("model name") - 1))
+            continue;
+
+        const char *value = ::strchr(line, ':');
+        if (NULL != value)
+            res = value + 1;
+        break;
+    }
+
+    ::fclose(file);
+    return res;
+#endif
+}
+
+const std::string& BenchmarkStore::machineFingerprint()
+{
+    static std::string fingerprint;
+    if (!fingerprint.empty())
+        return fingerprint;
+
+    std::string machine;
+    char name[256] = {0};
+#ifdef _WIN32
+    DWORD size = sizeof(name);
+    ::GetComputerNameA(name, &size);
+    SYSTEM_INFO info;
+    ::GetSystemInfo(&info);
+    const unsigned long processors = info.dwNumberOfProcessors;
+#else
+    ::gethostname(name, sizeof(name) - 1);
+    const unsigned long processors = static_cast<unsigned long>(::sysconf(_SC_NPROCESSORS_ONLN));
+#endif
+    machine += name;
+    machine += '/';
+    machine += cpuModel();
+
+    // FNV-1a
+    unsigned long long hash = 14695981039346656037ULL;
+    for (size_t idx = 0, size = machine.size(); idx < size; ++idx)
+    {
+        hash ^= static_cast<unsigned char>(machine[idx]);
+        hash *= 1099511628211ULL;
+    }
+
+    char buf[64];
+    TS_SNPRINTF(buf, sizeof(buf), "%016llx-%lu", hash, processors);
+    buf[sizeof(buf) - 1] = '\0';
+    fingerprint = buf;
+    return fingerprint;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+const BenchmarkRecord* BenchmarkStore::find(const std::string &key, const std::string &commit,
+                                            const std::string &machine) const
+{
+    for (Records::const_reverse_iterator it = records_.rbegin(), endIt = records_.rend(); it != endIt; ++it)
+        if (it->key_ == key && it->commit_ == commit && it->machine_ == machine)
+            return &*it;
+    return NULL;
+}
+
+std::string BenchmarkStore::lastCommit(const std::string &machine) const
+{
+    for (Records::const_reverse_iterator it = records_.rbegin(), endIt = records_.rend(); it != endIt; ++it)
+        if (it->machine_ == machine)
+            return it->commit_;
+    return std::string();
+}
+
+std::string BenchmarkStore::previousCommit(const std::string &machine, const std::string &commit) const
+{
+    bool commitFound = false;
+    for (Records::const_reverse_iterator it = records_.rbegin(), endIt = records_.rend(); it != endIt; ++it)
+    {
+        if (it->machine_ != machine)
+            continue;
+
+        if (it->commit_ == commit)
+            commitFound = true;
+        else if (commitFound)
+            return it->commit_;
+    }
+    return std::string();
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// two-sided quantile of Student's t distribution (Cornish-Fisher expansion of normal one)
+static double studentQuantile(double confidence, double degreesOfFreedom)
+{
+    const double z = confidence >= 0.99 ? 2.5758 : (confidence >= 0.95 ? 1.9600 : 1.6449);
+    if (degreesOfFreedom < 1)
+        degreesOfFreedom = 1;
+
+    const double z3 = z * z * z, z5 = z3 * z * z, z7 = z5 * z * z;
+    const double df = degreesOfFreedom;
+    return z + (z3 + z) / (4 * df)
+             + (5 * z5 + 16 * z3 + 3 * z) / (96 * df * df)
+             + (3 * z7 + 19 * z5 + 17 * z3 - 15 * z) / (384 * df * df * df);
+}
+
+BenchmarkDelta BenchmarkStore::compare(const BenchmarkRecord &baseline, const BenchmarkRecord &current,
+                                       double confidence)
+{
+    BenchmarkDelta res = {0, 0, 0};
+    if (baseline.mean_ <= 0 || 0 == baseline.samples_ || 0 == current.samples_)
+        return res;
+
+    const double difference = current.mean_ - baseline.mean_;
+    const double baselineError = baseline.variance_ / baseline.samples_;
+    const double currentError = current.variance_ / current.samples_;
+    const double error = baselineError + currentError;
+
+    double halfWidth = 0;
+    if (error > 0)
+    {
+        // Welch-Satterthwaite equation
+        double denominator = 0;
+        if (baseline.samples_ > 1)
+            denominator += baselineError * baselineError / (baseline.samples_ - 1);
+        if (current.samples_ > 1)
+            denominator += currentError * currentError / (current.samples_ - 1);
+        const double degreesOfFreedom = denominator > 0 ? error * error / denominator : 1;
+
+        halfWidth = studentQuantile(confidence, degreesOfFreedom) * ::sqrt(error);
+    }
+
+    res.delta_ = 100 * difference / baseline.mean_;
+    res.lower_ = 100 * (difference - halfWidth) / baseline.mean_;
+    res.upper_ = 100 * (difference + halfWidth) / baseline.mean_;
+    return res;
+}
+
+YUNIT_NS_END
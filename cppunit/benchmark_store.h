@@ -0,0 +1,88 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// @file benchmark_store.h
+//
+// Results of benchmarks ('assertNotSlowerThan' measurements), persisted between runs and keyed by benchmark
+// name, commit and machine fingerprint. The same file is read by 'yunit --compare-benchmarks' to report
+// regressions of current commit against a baseline one.
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#ifndef _BENCHMARK_STORE_YUNIT_HEADER_
+#define _BENCHMARK_STORE_YUNIT_HEADER_
+
+#include "../yunit/yunit.h"
+#include <ctime>
+#include <string>
+#include <vector>
+
+YUNIT_NS_BEGIN
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief Summary of one benchmark measurement, samples themselves are not stored
+struct BenchmarkRecord
+{
+    BenchmarkRecord();
+
+    std::string key_;
+    std::string commit_;
+    std::string machine_;
+    unsigned int samples_;
+    double mean_;       ///< nanoseconds per iteration
+    double variance_;   ///< unbiased variance of samples
+    double median_;
+    time_t time_;
+};
+
+/// @brief Difference of two benchmark records in percents of baseline mean
+struct BenchmarkDelta
+{
+    double delta_;
+    double lower_;      ///< confidence interval bounds
+    double upper_;
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief Append-only text file, one record per line:
+/// @code
+/// <key>\t<commit>\t<machine>\t<samples>\t<mean>\t<variance>\t<median>\t<time>
+/// @endcode
+class BenchmarkStore
+{
+public:
+    typedef std::vector<BenchmarkRecord> Records;
+
+    /// @return false if file does not exist; lines with wrong format are skipped
+    bool load(const char *path);
+
+    static bool append(const char *path, const BenchmarkRecord &record);
+
+    static BenchmarkRecord summarize(const char *key, const char *commit, const char *machine,
+                                     const std::vector<double> &samples);
+
+    /// @brief Hash of host name, CPU model and number of processors, so results of different machines are
+    /// never compared with each other
+    static const std::string& machineFingerprint();
+
+    /// @return The last stored record of 'key' for 'commit' and 'machine' or NULL
+    const BenchmarkRecord* find(const std::string &key, const std::string &commit, const std::string &machine) const;
+
+    /// @return Commit of the last stored record of 'machine' or empty string
+    std::string lastCommit(const std::string &machine) const;
+
+    /// @return The last commit of 'machine', stored before 'commit', or empty string
+    std::string previousCommit(const std::string &machine, const std::string &commit) const;
+
+    const Records& records() const
+    {
+        return records_;
+    }
+
+    /// @brief Welch's t-test based confidence interval of means difference
+    /// @param confidence One of 0.9, 0.95, 0.99
+    static BenchmarkDelta compare(const BenchmarkRecord &baseline, const BenchmarkRecord &current, double confidence);
+
+private:
+    Records records_;
+};
+
+YUNIT_NS_END
+
+#endif // _BENCHMARK_STORE_YUNIT_HEADER_
@@ -0,0 +1,345 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// crash_isolation.cpp
+//
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "crash_isolation.h"
+#include "crash_record.h"
+#include "signal_safe.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#ifdef YUNIT_CRASH_ISOLATION
+#  include <dlfcn.h>
+#  include <execinfo.h>
+#  include <link.h>
+#  include <ucontext.h>
+#  include <unistd.h>
+#endif
+
+YUNIT_NS_BEGIN
+
+#ifdef YUNIT_CRASH_ISOLATION
+
+static const int crashSignals[] = {SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT};
+enum {crashSignalsNumber = sizeof(crashSignals) / sizeof(crashSignals[0])};
+
+// signal handler does not allocate memory, so all its data is prepared by CrashHandlers constructor
+static bool handlersInstalled = false;
+static struct sigaction previousActions[crashSignalsNumber];
+
+static std::vector<std::string> restartArgs;
+static std::vector<char*> restartArgv;
+static bool restartAllowed = false;
+
+#define RESUME_AFTER_OPTION "--resume-after="
+#define RESUME_RESULTS_OPTION "--resume-results="
+enum {resumeArgSize = 1024};
+static char resumeArg[resumeArgSize] = RESUME_AFTER_OPTION;
+static std::string resumeResultsArg;
+
+// executable segments of C library: crash inside them may leave its locks (malloc, stdio) taken
+static uintptr_t libcBegin = 0;
+static uintptr_t libcEnd = 0;
+
+static __thread CrashTrap *currentTrap __attribute__ ((tls_model("initial-exec")));
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+static int findLibcSegments(struct dl_phdr_info *info, size_t /*size*/, void *base)
+{
+    if (reinterpret_cast<void*>(info->dlpi_addr) != base)
+        return 0;
+
+    for (int idx = 0; idx < info->dlpi_phnum; ++idx)
+    {
+        const ElfW(Phdr) &header = info->dlpi_phdr[idx];
+        if (PT_LOAD != header.p_type || 0 == (header.p_flags & PF_X))
+            continue;
+
+        const uintptr_t begin = info->dlpi_addr + header.p_vaddr;
+        if (0 == libcBegin || begin < libcBegin)
+            libcBegin = begin;
+        if (begin + header.p_memsz > libcEnd)
+            libcEnd = begin + header.p_memsz;
+    }
+    return 1;
+}
+
+static void findLibc()
+{
+    Dl_info info;
+    if (0 != ::dladdr(reinterpret_cast<void*>(&::fflush), &info))
+        ::dl_iterate_phdr(findLibcSegments, info.dli_fbase);
+}
+
+static uintptr_t instructionAddress(void *context)
+{
+    const ucontext_t *ucontext = static_cast<const ucontext_t*>(context);
+#if defined(__x86_64__)
+    return static_cast<uintptr_t>(ucontext->uc_mcontext.gregs[REG_RIP]);
+#elif defined(__i386__)
+    return static_cast<uintptr_t>(ucontext->uc_mcontext.gregs[REG_EIP]);
+#elif defined(__aarch64__)
+    return static_cast<uintptr_t>(ucontext->uc_mcontext.pc);
+#else
+    (void)ucontext;
+    return 0;
+#endif
+}
+
+// fault, raised by instruction of test code, does not leave C library in inconsistent state
+static bool canContinue(const siginfo_t *info, void *context)
+{
+    if (info->si_code <= 0) // sent by kill, raise or abort
+        return false;
+
+    const uintptr_t address = instructionAddress(context);
+    return 0 != address && (address < libcBegin || address >= libcEnd);
+}
+
+static void restartProcess(const char *testName, int signalNumber)
+{
+    resumeArg[sizeof(RESUME_AFTER_OPTION) - 1] = '\0';
+    appendString(resumeArg, resumeArgSize, testName);
+
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, signalNumber);
+    ::sigprocmask(SIG_UNBLOCK, &signals, NULL);
+
+    ::execv("/proc/self/exe", &restartArgv[0]);
+}
+
+static void onCrashSignal(int signalNumber, siginfo_t *info, void *context)
+{
+    CrashTrap *trap = currentTrap;
+    currentTrap = NULL; // crash inside handler is not caught
+
+    if (NULL != trap)
+    {
+        trap->signal_ = signalNumber;
+        trap->address_ = info->si_addr;
+        trap->stackDepth_ = unwindStack(context, trap->stack_, CrashTrap::maxStackDepth);
+
+        if (canContinue(info, context))
+            ::siglongjmp(trap->jump_, 1);
+
+        char msg[1024] = "\ntest \"";
+        appendString(msg, sizeof(msg), trap->testName_);
+        appendString(msg, sizeof(msg), "\" has crashed with signal ");
+        appendNumber(msg, sizeof(msg), signalNumber);
+        appendString(msg, sizeof(msg), restartAllowed ? ", process is restarted" : ", process can not continue");
+        appendString(msg, sizeof(msg), ", stack:\n");
+        writeStderr(msg);
+        ::backtrace_symbols_fd(trap->stack_, trap->stackDepth_, STDERR_FILENO);
+    }
+
+    if (crashRecordEnabled())
+        writeCrashRecord(signalNumber, info, context, NULL != trap ? trap->testName_ : NULL);
+
+    if (NULL != trap && restartAllowed)
+        restartProcess(trap->testName_, signalNumber);
+
+    ::signal(signalNumber, SIG_DFL);
+    ::raise(signalNumber);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+bool crashIsolationSupported()
+{
+    return true;
+}
+
+bool crashIsolationEnabled()
+{
+    return handlersInstalled;
+}
+
+CrashHandlers::CrashHandlers(bool enable, bool restart, const char *resultsPath)
+: enabled_(enable && !handlersInstalled)
+{
+    if (!enabled_)
+        return;
+
+    if (0 == libcEnd)
+        findLibc();
+
+    restartAllowed = restart && !restartArgs.empty();
+    if (restartAllowed)
+    {
+        restartArgv.clear();
+        for (size_t idx = 0; idx < restartArgs.size(); ++idx)
+            restartArgv.push_back(const_cast<char*>(restartArgs[idx].c_str()));
+        if (NULL != resultsPath)
+        {
+            resumeResultsArg = std::string(RESUME_RESULTS_OPTION) + resultsPath;
+            restartArgv.push_back(const_cast<char*>(resumeResultsArg.c_str()));
+        }
+        restartArgv.push_back(resumeArg);
+        restartArgv.push_back(NULL);
+
+        // lines, printed before crash, must not be lost in stdio buffer by exec
+        ::fflush(stdout);
+        ::setvbuf(stdout, NULL, _IOLBF, BUFSIZ);
+    }
+
+    if (crashRecordEnabled())
+        installThreadDumpHandler();
+
+    struct sigaction action;
+    ::memset(&action, 0, sizeof(action));
+    action.sa_sigaction = onCrashSignal;
+    action.sa_flags = SA_SIGINFO | SA_ONSTACK;
+    sigemptyset(&action.sa_mask);
+    for (int idx = 0; idx < crashSignalsNumber; ++idx)
+        ::sigaction(crashSignals[idx], &action, &previousActions[idx]);
+
+    handlersInstalled = true;
+}
+
+CrashHandlers::~CrashHandlers()
+{
+    if (!enabled_)
+        return;
+
+    for (int idx = 0; idx < crashSignalsNumber; ++idx)
+        ::sigaction(crashSignals[idx], &previousActions[idx], NULL);
+    removeThreadDumpHandler();
+
+    handlersInstalled = false;
+    restartAllowed = false;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// handler writes call stack and may be called by stack overflow, so default SIGSTKSZ is too small
+enum {altStackSize = 64 * 1024};
+
+CrashAltStack::CrashAltStack(bool enable)
+: stack_(NULL)
+{
+    if (!enable)
+        return;
+
+    stack_ = ::malloc(altStackSize);
+    if (NULL == stack_)
+        return;
+
+    stack_t altStack;
+    altStack.ss_sp = stack_;
+    altStack.ss_size = altStackSize;
+    altStack.ss_flags = 0;
+    if (0 != ::sigaltstack(&altStack, &prevStack_))
+    {
+        ::free(stack_);
+        stack_ = NULL;
+    }
+}
+
+CrashAltStack::~CrashAltStack()
+{
+    if (NULL == stack_)
+        return;
+
+    ::sigaltstack(&prevStack_, NULL);
+    ::free(stack_);
+}
+
+void setCrashRestartCommandLine(int argc, char **argv)
+{
+    restartArgs.clear();
+    for (int idx = 0; idx < argc; ++idx)
+        if (0 != ::strncmp(argv[idx], RESUME_AFTER_OPTION, sizeof(RESUME_AFTER_OPTION) - 1)
+            && 0 != ::strncmp(argv[idx], RESUME_RESULTS_OPTION, sizeof(RESUME_RESULTS_OPTION) - 1))
+            restartArgs.push_back(argv[idx]);
+}
+
+std::string crashRestartResultsPath()
+{
+    const char *dir = ::getenv("TMPDIR");
+    char name[64];
+    TS_SNPRINTF(name, sizeof(name), "/yunit-results-%ld", static_cast<long>(::getpid()));
+    name[sizeof(name) - 1] = '\0';
+    return std::string((NULL != dir && '\0' != *dir) ? dir : "/tmp") + name;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+CrashTrap::CrashTrap(const char *testName)
+: testName_(testName)
+, signal_(0)
+, address_(NULL)
+, stackDepth_(0)
+, prev_(currentTrap)
+{
+    currentTrap = this;
+}
+
+CrashTrap::~CrashTrap()
+{
+    currentTrap = prev_;
+}
+
+std::string CrashTrap::message() const
+{
+    char header[256];
+    TS_SNPRINTF(header, sizeof(header), "signal %d (%s) at address %p", signal_, ::strsignal(signal_), address_);
+    header[sizeof(header) - 1] = '\0';
+
+    std::string msg(header);
+    char **symbols = ::backtrace_symbols(stack_, stackDepth_);
+    if (NULL == symbols)
+        return msg;
+
+    msg += ", stack:";
+    for (int idx = 0; idx < stackDepth_; ++idx)
+    {
+        msg += "\n    ";
+        msg += symbols[idx];
+    }
+    ::free(symbols);
+    return msg;
+}
+
+#else // YUNIT_CRASH_ISOLATION
+
+bool crashIsolationSupported()
+{
+    return false;
+}
+
+bool crashIsolationEnabled()
+{
+    return false;
+}
+
+CrashHandlers::CrashHandlers(bool /*enable*/, bool /*restart*/, const char * /*resultsPath*/)
+: enabled_(false)
+{
+}
+
+CrashHandlers::~CrashHandlers()
+{
+}
+
+CrashAltStack::CrashAltStack(bool /*enable*/)
+: stack_(NULL)
+{
+}
+
+CrashAltStack::~CrashAltStack()
+{
+}
+
+void setCrashRestartCommandLine(int /*argc*/, char ** /*argv*/)
+{
+}
+
+std::string crashRestartResultsPath()
+{
+    return std::string();
+}
+
+#endif // YUNIT_CRASH_ISOLATION
+
+YUNIT_NS_END
@@ -0,0 +1,119 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// @file crash_isolation.h
+//
+// Conversion of hardware faults (SIGSEGV, SIGBUS, SIGFPE, SIGILL) and abort of test into test failure on
+// Linux (see TestRegistry::setCrashIsolation). Signal handlers work on alternate stack of worker thread, so
+// stack overflow is caught too. Handler captures call stack and jumps back into test executor by siglongjmp,
+// when fault has happened in code of test (not inside C library, which may hold its internal locks). Otherwise
+// crash is reported to stderr and the process is restarted by exec with '--resume-after=<crashed test>'
+// option, so execution continues with the next test; with several workers restart is impossible and process
+// dies.
+// Before restart or death crash record is written, if it is enabled (see crash_record.h).
+//
+// Test, which has crashed, has not executed destructors of its local objects and may leave locked mutexes or
+// broken heap, so crash isolation is a last resort to finish test run, not a way to test crashes (use
+// 'willDie' for that).
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#ifndef _CRASH_ISOLATION_YUNIT_HEADER_
+#define _CRASH_ISOLATION_YUNIT_HEADER_
+
+#include "../yunit/yunit.h"
+#include <string>
+
+#if defined(__linux__)
+#  define YUNIT_CRASH_ISOLATION
+#  include <setjmp.h>
+#  include <signal.h>
+#endif
+
+YUNIT_NS_BEGIN
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @return false if crash isolation is not implemented for current platform
+bool crashIsolationSupported();
+
+/// @return true while crash signal handlers are installed
+bool crashIsolationEnabled();
+
+/// @brief Install crash signal handlers while object exists, if 'enable' is true
+/// @param restart Allow restart of process with '--resume-after' for crash, which can not be caught in process
+/// @param resultsPath Results file of executed tests, it is passed to restarted process by '--resume-results',
+/// or NULL
+class CrashHandlers
+{
+public:
+    CrashHandlers(bool enable, bool restart, const char *resultsPath);
+    ~CrashHandlers();
+
+private:
+    CrashHandlers(const CrashHandlers&);
+    CrashHandlers& operator=(const CrashHandlers&);
+
+    bool enabled_;
+};
+
+/// @brief Alternate signal stack of calling thread while object exists, if 'enable' is true
+class CrashAltStack
+{
+public:
+    explicit CrashAltStack(bool enable);
+    ~CrashAltStack();
+
+private:
+    CrashAltStack(const CrashAltStack&);
+    CrashAltStack& operator=(const CrashAltStack&);
+
+    void *stack_;
+#ifdef YUNIT_CRASH_ISOLATION
+    stack_t prevStack_;
+#endif
+};
+
+/// @brief Remember command line of test program for restart
+void setCrashRestartCommandLine(int argc, char **argv);
+
+/// @return path of temporary results file, which passes results of tests to restarted process, or empty
+/// string, if restart is not supported
+std::string crashRestartResultsPath();
+
+#ifdef YUNIT_CRASH_ISOLATION
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief Crash of calling thread jumps into 'jump_' of the innermost trap, armed by sigsetjmp:
+/// @code
+/// CrashTrap trap(test->name_);
+/// if (0 == sigsetjmp(trap.jump_, 1))
+///     runTest();
+/// else
+///     report(trap.message());
+/// @endcode
+class CrashTrap
+{
+public:
+    explicit CrashTrap(const char *testName);
+    ~CrashTrap();
+
+    /// @brief Description of signal and its call stack
+    std::string message() const;
+
+    enum {maxStackDepth = 64};
+
+    sigjmp_buf jump_;
+    const char *testName_;
+    int signal_;
+    void *address_;
+    int stackDepth_;
+    void *stack_[maxStackDepth];
+
+private:
+    CrashTrap(const CrashTrap&);
+    CrashTrap& operator=(const CrashTrap&);
+
+    CrashTrap *prev_;
+};
+
+#endif // YUNIT_CRASH_ISOLATION
+
+YUNIT_NS_END
+
+#endif // _CRASH_ISOLATION_YUNIT_HEADER_
@@ -0,0 +1,81 @@
+#include "tests.h"
+#include "crash_isolation.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+// tests are executed in reverse order of registration
+
+TEST(abortRestartsProcess)
+{
+    ::abort();
+}
+
+TEST(segfaultIsReportedAsFailure)
+{
+    *static_cast<volatile int*>(NULL) = 1;
+}
+
+TEST(testBeforeCrashes)
+{
+}
+
+int main(int argc, char **argv)
+{
+    using namespace YUNIT_NS;
+
+    struct TestResultHandler
+    {
+        typedef TestResultHandler Self;
+
+        TestResultHandler()
+        : successTestCounter_(0)
+        , crashedTestCounter_(0)
+        {}
+
+        static void onTestEvent(void *ctx, void *arg, void *data)
+        {
+            Self *self = static_cast<Self*>(ctx);
+
+            if (TestRegistry::success == arg)
+                ++(self->successTestCounter_);
+            else if (TestRegistry::fail == arg)
+            {
+                TestRegistry::FailCtx *failCtx = static_cast<TestRegistry::FailCtx*>(data);
+                if (failCtx->test_->stats_.crashed_)
+                    ++(self->crashedTestCounter_);
+                printf("%s\n", failCtx->errmsg_);
+                delete [] failCtx->errmsg_;
+                delete failCtx;
+            }
+        }
+
+        unsigned int successTestCounter_;
+        unsigned int crashedTestCounter_;
+    }
+    testCtx;
+
+    bool resumed = false;
+    for (int argIdx = 1; argIdx < argc; ++argIdx)
+        resumed = resumed || 0 == ::strncmp(argv[argIdx], "--resume-after=", sizeof("--resume-after=") - 1);
+
+    if (!parseCommandLine(argc, argv))
+        return 1;
+    testRegistry->setHistoryFile(NULL);
+    testRegistry->setCrashIsolation(true);
+    testRegistry->executeAllTests(TestResultHandler::onTestEvent, &testCtx);
+
+    printf("success - %u" "\n"
+           "crashed - %u" "\n",
+           testCtx.successTestCounter_,
+           testCtx.crashedTestCounter_);
+
+    // the first process has caught segfault and has been restarted by abort, which may happen inside locked
+    // C library, so restarted process reports results of the first one and the last test as crashed
+    if (!resumed)
+    {
+        printf("process has not been restarted\n");
+        return 1;
+    }
+    return (2 == testCtx.crashedTestCounter_ && 1 == testCtx.successTestCounter_) ? 0 : 1;
+}
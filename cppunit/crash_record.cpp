@@ -0,0 +1,486 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// crash_record.cpp
+//
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "crash_record.h"
+#include "signal_safe.h"
+#include <cstdio>
+#include <cstring>
+
+#if defined(__linux__)
+#  define YUNIT_CRASH_RECORD
+#  include <atomic>
+#  include <errno.h>
+#  include <fcntl.h>
+#  include <signal.h>
+#  include <sys/syscall.h>
+#  include <time.h>
+#  include <ucontext.h>
+#  include <unistd.h>
+#endif
+
+YUNIT_NS_BEGIN
+
+#ifdef __aarch64__
+#  define YUNIT_REGISTER_PREFIX "x"
+#else
+#  define YUNIT_REGISTER_PREFIX "r"
+#endif
+
+const char crashRecordMagic[8] = {'Y', 'C', 'R', 'A', 'S', 'H', '\0', '\0'};
+
+#ifdef YUNIT_CRASH_RECORD
+
+// everything, used by signal handlers, is allocated statically
+enum {recordDirSize = 1024, redZoneSize = 128, dumpWaitMs = 200, dumpedThreadWaitMs = 5000};
+
+static char recordDir[recordDirSize] = "";
+static char mapsBuffer[crashRecordMaxMapsSize];
+
+struct ThreadSnapshot
+{
+    CrashRecordThread thread_;
+    std::atomic<int> ready_;
+};
+
+static ThreadSnapshot snapshots[crashRecordMaxThreads];
+static std::atomic<int> snapshotsNumber(0);
+static std::atomic<bool> recordStarted(false);
+static std::atomic<bool> dumpFinished(false);
+
+static int dumpSignal = 0;
+static struct sigaction previousDumpAction;
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+static void sleepMs(long ms)
+{
+    struct timespec delay = {0, ms * 1000000L};
+    ::nanosleep(&delay, NULL);
+}
+
+static bool writeAll(int fd, const void *data, size_t size)
+{
+    const char *ptr = static_cast<const char*>(data);
+    while (size > 0)
+    {
+        const ssize_t res = ::write(fd, ptr, size);
+        if (res < 0 && EINTR == errno)
+            continue;
+        if (res <= 0)
+            return false;
+        ptr += res;
+        size -= static_cast<size_t>(res);
+    }
+    return true;
+}
+
+// unreadable memory is replaced with zeros, so size of record part is kept
+static void writeMemory(int fd, uintptr_t address, size_t size)
+{
+    static const char zeros[4096] = {0};
+    while (size > 0)
+    {
+        const size_t chunk = size < sizeof(zeros) ? size : sizeof(zeros);
+        if (!writeAll(fd, reinterpret_cast<const void*>(address), chunk) && !writeAll(fd, zeros, chunk))
+            return;
+        address += chunk;
+        size -= chunk;
+    }
+}
+
+static uintptr_t parseHex(const char *&ptr, const char *end)
+{
+    uintptr_t value = 0;
+    for (; ptr < end; ++ptr)
+    {
+        const char ch = *ptr;
+        if (ch >= '0' && ch <= '9')
+            value = value * 16 + (ch - '0');
+        else if (ch >= 'a' && ch <= 'f')
+            value = value * 16 + (ch - 'a' + 10);
+        else
+            break;
+    }
+    return value;
+}
+
+// line of /proc/self/maps: "<begin>-<end> <perms> ..."
+static bool findReadableMapping(const char *maps, size_t size, uintptr_t address, uintptr_t &begin, uintptr_t &end)
+{
+    const char *mapsEnd = maps + size;
+    for (const char *line = maps; line < mapsEnd; )
+    {
+        const char *ptr = line;
+        const uintptr_t lineBegin = parseHex(ptr, mapsEnd);
+        ++ptr; // '-'
+        const uintptr_t lineEnd = parseHex(ptr, mapsEnd);
+        ++ptr; // ' '
+        const bool readable = ptr < mapsEnd && 'r' == *ptr;
+
+        if (readable && lineBegin <= address && address < lineEnd)
+        {
+            begin = lineBegin;
+            end = lineEnd;
+            return true;
+        }
+
+        const char *lineEndPtr = static_cast<const char*>(::memchr(ptr, '\n', mapsEnd - ptr));
+        if (NULL == lineEndPtr)
+            break;
+        line = lineEndPtr + 1;
+    }
+    return false;
+}
+
+static size_t readMaps()
+{
+    const int fd = ::open("/proc/self/maps", O_RDONLY);
+    if (fd < 0)
+        return 0;
+
+    size_t size = 0;
+    while (size < sizeof(mapsBuffer))
+    {
+        const ssize_t res = ::read(fd, mapsBuffer + size, sizeof(mapsBuffer) - size);
+        if (res < 0 && EINTR == errno)
+            continue;
+        if (res <= 0)
+            break;
+        size += static_cast<size_t>(res);
+    }
+    ::close(fd);
+    return size;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+static uint64_t stackPointer(const CrashRecordThread &thread)
+{
+#if defined(__x86_64__)
+    return thread.registersNumber_ > REG_RSP ? thread.registers_[REG_RSP] : 0;
+#elif defined(__i386__)
+    return thread.registersNumber_ > REG_ESP ? thread.registers_[REG_ESP] : 0;
+#elif defined(__aarch64__)
+    return thread.registersNumber_ > 31 ? thread.registers_[31] : 0;
+#else
+    (void)thread;
+    return 0;
+#endif
+}
+
+static void fillThread(CrashRecordThread &thread, void *context, bool crashed)
+{
+    ::memset(&thread, 0, sizeof(thread));
+    thread.tid_ = static_cast<int32_t>(::syscall(SYS_gettid));
+    thread.crashed_ = crashed ? 1 : 0;
+
+    const ucontext_t *ucontext = static_cast<const ucontext_t*>(context);
+#if defined(__x86_64__) || defined(__i386__)
+    thread.registersNumber_ = NGREG;
+    for (int idx = 0; idx < NGREG; ++idx)
+        thread.registers_[idx] = static_cast<uint64_t>(ucontext->uc_mcontext.gregs[idx]);
+#elif defined(__aarch64__)
+    thread.registersNumber_ = 34;
+    for (int idx = 0; idx < 31; ++idx)
+        thread.registers_[idx] = ucontext->uc_mcontext.regs[idx];
+    thread.registers_[31] = ucontext->uc_mcontext.sp;
+    thread.registers_[32] = ucontext->uc_mcontext.pc;
+    thread.registers_[33] = ucontext->uc_mcontext.pstate;
+#else
+    (void)ucontext;
+#endif
+
+    void *frames[crashRecordMaxFrames];
+    const int depth = unwindStack(context, frames, crashRecordMaxFrames);
+    for (int idx = 0; idx < depth; ++idx)
+        thread.frames_[thread.framesNumber_++] = reinterpret_cast<uintptr_t>(frames[idx]);
+}
+
+static void onThreadDump(int /*signal*/, siginfo_t * /*info*/, void *context)
+{
+    const int idx = snapshotsNumber.fetch_add(1);
+    if (idx < crashRecordMaxThreads)
+    {
+        fillThread(snapshots[idx].thread_, context, false);
+        snapshots[idx].ready_.store(1);
+    }
+
+    // stack of thread must not change, while it is copied into record
+    for (int waits = 0; waits < dumpedThreadWaitMs && !dumpFinished.load(); ++waits)
+        sleepMs(1);
+}
+
+struct DirEntry64
+{
+    uint64_t ino_;
+    int64_t off_;
+    unsigned short reclen_;
+    unsigned char type_;
+    char name_[1];
+};
+
+// @return number of threads, which have been asked to dump themselves
+static int stopOtherThreads()
+{
+    const int fd = ::open("/proc/self/task", O_RDONLY | O_DIRECTORY);
+    if (fd < 0)
+        return 0;
+
+    const long pid = ::getpid();
+    const long tid = ::syscall(SYS_gettid);
+    int requested = 0;
+
+    char buf[4096];
+    for (long size; 0 < (size = ::syscall(SYS_getdents64, fd, buf, sizeof(buf))); )
+        for (long pos = 0; pos < size; )
+        {
+            const DirEntry64 *entry = reinterpret_cast<const DirEntry64*>(buf + pos);
+            pos += entry->reclen_;
+
+            long threadId = 0;
+            for (const char *ch = entry->name_; *ch >= '0' && *ch <= '9'; ++ch)
+                threadId = threadId * 10 + (*ch - '0');
+
+            // one slot is taken by crashed thread
+            if (0 == threadId || tid == threadId || requested + 1 >= crashRecordMaxThreads)
+                continue;
+            if (0 == ::syscall(SYS_tgkill, pid, threadId, dumpSignal))
+                ++requested;
+        }
+
+    ::close(fd);
+    return requested;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void setCrashRecordDir(const char *dir)
+{
+    recordDir[0] = '\0';
+    if (NULL != dir)
+        appendString(recordDir, recordDirSize, dir);
+}
+
+bool crashRecordEnabled()
+{
+    return '\0' != recordDir[0];
+}
+
+void installThreadDumpHandler()
+{
+    dumpSignal = SIGRTMAX - 2;
+
+    struct sigaction action;
+    ::memset(&action, 0, sizeof(action));
+    action.sa_sigaction = onThreadDump;
+    action.sa_flags = SA_SIGINFO | SA_ONSTACK | SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    ::sigaction(dumpSignal, &action, &previousDumpAction);
+}
+
+void removeThreadDumpHandler()
+{
+    if (0 != dumpSignal)
+        ::sigaction(dumpSignal, &previousDumpAction, NULL);
+    dumpSignal = 0;
+}
+
+void writeCrashRecord(int signal, const void *info, void *context, const char *testName)
+{
+    // the second crashed thread is written as stopped one
+    if (recordStarted.exchange(true))
+    {
+        onThreadDump(signal, NULL, context);
+        return;
+    }
+
+    snapshotsNumber.store(1);
+    fillThread(snapshots[0].thread_, context, true);
+    snapshots[0].ready_.store(1);
+
+    const int requested = 0 != dumpSignal ? stopOtherThreads() : 0;
+    for (int waits = 0; waits < dumpWaitMs && snapshotsNumber.load() < requested + 1; ++waits)
+        sleepMs(1);
+    for (int waits = 0; waits < dumpWaitMs; ++waits)
+    {
+        int ready = 0;
+        const int number = snapshotsNumber.load() < crashRecordMaxThreads ? snapshotsNumber.load() : crashRecordMaxThreads;
+        for (int idx = 0; idx < number; ++idx)
+            ready += snapshots[idx].ready_.load();
+        if (ready == number)
+            break;
+        sleepMs(1);
+    }
+
+    struct timespec now;
+    ::clock_gettime(CLOCK_REALTIME, &now);
+
+    char path[recordDirSize + 64] = "";
+    appendString(path, sizeof(path), recordDir);
+    appendString(path, sizeof(path), "/crash-");
+    appendNumber(path, sizeof(path), static_cast<unsigned long long>(::getpid()));
+    appendString(path, sizeof(path), "-");
+    appendNumber(path, sizeof(path), static_cast<unsigned long long>(now.tv_sec) * 1000000000ULL + now.tv_nsec);
+    appendString(path, sizeof(path), ".yrec");
+
+    const int fd = ::open(path, O_WRONLY | O_CREAT | O_EXCL, 0644);
+    if (fd < 0)
+    {
+        dumpFinished.store(true);
+        writeStderr("\ncrash record can not be created\n");
+        return;
+    }
+
+    const size_t mapsSize = readMaps();
+
+    static CrashRecordHeader header;
+    ::memset(&header, 0, sizeof(header));
+    ::memcpy(header.magic_, crashRecordMagic, sizeof(header.magic_));
+    header.version_ = crashRecordVersion;
+    header.signal_ = signal;
+    header.pid_ = static_cast<uint32_t>(::getpid());
+    if (NULL != info)
+    {
+        const siginfo_t *signalInfo = static_cast<const siginfo_t*>(info);
+        header.code_ = signalInfo->si_code;
+        header.faultAddress_ = reinterpret_cast<uintptr_t>(signalInfo->si_addr);
+    }
+    header.mapsSize_ = static_cast<uint32_t>(mapsSize);
+    if (NULL != testName)
+        appendString(header.test_, sizeof(header.test_), testName);
+
+    const int number = snapshotsNumber.load() < crashRecordMaxThreads ? snapshotsNumber.load() : crashRecordMaxThreads;
+    for (int idx = 0; idx < number; ++idx)
+        header.threadsNumber_ += snapshots[idx].ready_.load();
+
+    bool written = writeAll(fd, &header, sizeof(header)) && writeAll(fd, mapsBuffer, mapsSize);
+    for (int idx = 0; idx < number && written; ++idx)
+    {
+        if (0 == snapshots[idx].ready_.load())
+            continue;
+
+        CrashRecordThread &thread = snapshots[idx].thread_;
+        uintptr_t begin = 0, end = 0;
+        const uintptr_t sp = static_cast<uintptr_t>(stackPointer(thread));
+        if (0 != sp && findReadableMapping(mapsBuffer, mapsSize, sp, begin, end))
+        {
+            thread.stackAddress_ = (sp - begin > redZoneSize) ? sp - redZoneSize : begin;
+            thread.stackSize_ = end - thread.stackAddress_;
+            if (thread.stackSize_ > crashRecordMaxStackSize)
+                thread.stackSize_ = crashRecordMaxStackSize;
+        }
+
+        written = writeAll(fd, &thread, sizeof(thread));
+        if (written)
+            writeMemory(fd, static_cast<uintptr_t>(thread.stackAddress_), static_cast<size_t>(thread.stackSize_));
+    }
+    ::close(fd);
+    dumpFinished.store(true);
+
+    writeStderr("\ncrash record is written into ");
+    writeStderr(path);
+    writeStderr("\n");
+}
+
+#else // YUNIT_CRASH_RECORD
+
+void setCrashRecordDir(const char * /*dir*/)
+{
+}
+
+bool crashRecordEnabled()
+{
+    return false;
+}
+
+void installThreadDumpHandler()
+{
+}
+
+void removeThreadDumpHandler()
+{
+}
+
+void writeCrashRecord(int /*signal*/, const void * /*info*/, void * /*context*/, const char * /*testName*/)
+{
+}
+
+#endif // YUNIT_CRASH_RECORD
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+bool readCrashRecord(const char *path, CrashRecord &record, std::string &error)
+{
+    FILE *file = ::fopen(path, "rb");
+    if (NULL == file)
+    {
+        error = std::string("can not open ") + path;
+        return false;
+    }
+
+    CrashRecordHeader &header = record.header_;
+    bool res = 1 == ::fread(&header, sizeof(header), 1, file)
+            && 0 == ::memcmp(header.magic_, crashRecordMagic, sizeof(header.magic_));
+    if (!res)
+        error = std::string(path) + " is not crash record";
+    else if (crashRecordVersion != header.version_ || header.mapsSize_ > crashRecordMaxMapsSize
+             || header.threadsNumber_ > crashRecordMaxThreads)
+    {
+        res = false;
+        error = std::string(path) + " is crash record of other version or machine";
+    }
+
+    if (res)
+    {
+        header.test_[sizeof(header.test_) - 1] = '\0';
+        record.maps_.resize(header.mapsSize_);
+        res = 0 == header.mapsSize_ || 1 == ::fread(&record.maps_[0], header.mapsSize_, 1, file);
+    }
+
+    for (uint32_t idx = 0; res && idx < header.threadsNumber_; ++idx)
+    {
+        CrashRecordThread thread;
+        res = 1 == ::fread(&thread, sizeof(thread), 1, file)
+           && thread.registersNumber_ <= crashRecordMaxRegisters
+           && thread.framesNumber_ <= crashRecordMaxFrames
+           && thread.stackSize_ <= crashRecordMaxStackSize;
+        if (!res)
+            break;
+
+        std::string stack(static_cast<size_t>(thread.stackSize_), '\0');
+        res = 0 == stack.size() || 1 == ::fread(&stack[0], stack.size(), 1, file);
+
+        record.threads_.push_back(thread);
+        record.stacks_.push_back(stack);
+    }
+
+    if (!res && error.empty())
+        error = std::string(path) + " is truncated";
+
+    ::fclose(file);
+    return res;
+}
+
+std::string crashRegisterName(unsigned int idx)
+{
+#if defined(__x86_64__)
+    static const char *names[] = {"r8", "r9", "r10", "r11", "r12", "r13", "r14", "r15", "rdi", "rsi", "rbp",
+                                  "rbx", "rdx", "rax", "rcx", "rsp", "rip", "efl", "csgsfs", "err", "trapno",
+                                  "oldmask", "cr2"};
+    if (idx < sizeof(names) / sizeof(names[0]))
+        return names[idx];
+#elif defined(__i386__)
+    static const char *names[] = {"gs", "fs", "es", "ds", "edi", "esi", "ebp", "esp", "ebx", "edx", "ecx", "eax",
+                                  "trapno", "err", "eip", "cs", "efl", "uesp", "ss"};
+    if (idx < sizeof(names) / sizeof(names[0]))
+        return names[idx];
+#elif defined(__aarch64__)
+    static const char *names[] = {"sp", "pc", "pstate"};
+    if (idx >= 31 && idx < 34)
+        return names[idx - 31];
+#endif
+
+    char name[16];
+    TS_SNPRINTF(name, sizeof(name), "%s%u", YUNIT_REGISTER_PREFIX, idx);
+    return name;
+}
+
+YUNIT_NS_END
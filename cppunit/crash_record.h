@@ -0,0 +1,92 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// @file crash_record.h
+//
+// Compact crash artifact of test process for Linux, instead of core dump. Record is written by crash signal
+// handler (see crash_isolation.h), when crashed process can not continue, into
+// '<dir>/crash-<pid>-<time>.yrec'. It contains signal, name of running test, memory map and for every thread
+// (up to crashRecordMaxThreads) its registers, call stack and bounded copy of stack memory. Other threads
+// are stopped by thread dump signal, so their registers are taken by themselves.
+//
+// Record is symbolized offline by runner ('--crash-report <path>'), file layout is native for writing machine:
+// CrashRecordHeader, memory map text, then CrashRecordThread with stack bytes for every thread.
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#ifndef _CRASH_RECORD_YUNIT_HEADER_
+#define _CRASH_RECORD_YUNIT_HEADER_
+
+#include "../yunit/yunit.h"
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+YUNIT_NS_BEGIN
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+enum
+{
+    crashRecordVersion = 1,
+    crashRecordMaxThreads = 64,
+    crashRecordMaxStackSize = 64 * 1024,    ///< copied stack bytes of every thread
+    crashRecordMaxFrames = 64,
+    crashRecordMaxRegisters = 40,
+    crashRecordMaxTestName = 256,
+    crashRecordMaxMapsSize = 512 * 1024
+};
+
+extern const char crashRecordMagic[8];
+
+struct CrashRecordHeader
+{
+    char magic_[8];
+    uint32_t version_;
+    int32_t signal_;
+    int32_t code_;              ///< si_code of signal
+    uint32_t pid_;
+    uint64_t faultAddress_;
+    uint32_t threadsNumber_;
+    uint32_t mapsSize_;         ///< length of /proc/self/maps text after header
+    char test_[crashRecordMaxTestName];
+};
+
+struct CrashRecordThread
+{
+    int32_t tid_;
+    int32_t crashed_;           ///< thread has received crash signal
+    uint32_t registersNumber_;  ///< machine context registers (see crashRegisterName)
+    uint32_t framesNumber_;
+    uint64_t registers_[crashRecordMaxRegisters];
+    uint64_t frames_[crashRecordMaxFrames];     ///< call stack from interrupted instruction (see unwindStack)
+    uint64_t stackAddress_;     ///< address of the first copied stack byte
+    uint64_t stackSize_;        ///< number of stack bytes after this structure
+};
+
+/// @brief Contents of record file
+struct CrashRecord
+{
+    CrashRecordHeader header_;
+    std::string maps_;
+    std::vector<CrashRecordThread> threads_;
+    std::vector<std::string> stacks_;
+};
+
+/// @brief Write crash records into 'dir' ('--crash-record=<dir>'), NULL disables them
+void setCrashRecordDir(const char *dir);
+bool crashRecordEnabled();
+
+/// @brief Install and remove handler of thread dump signal; called by CrashHandlers
+void installThreadDumpHandler();
+void removeThreadDumpHandler();
+
+/// @brief Write record of crash 'signal' of calling thread. It is async-signal-safe and it is called from
+/// signal handler with its 'info' (siginfo_t) and 'context' (ucontext_t).
+/// @param testName Test, which has been executed by crashed thread, or NULL
+void writeCrashRecord(int signal, const void *info, void *context, const char *testName);
+
+/// @return false and 'error' description, if 'path' is not crash record of this machine type
+bool readCrashRecord(const char *path, CrashRecord &record, std::string &error);
+
+/// @brief Name of register 'idx' of CrashRecordThread::registers_ for current machine
+std::string crashRegisterName(unsigned int idx);
+
+YUNIT_NS_END
+
+#endif // _CRASH_RECORD_YUNIT_HEADER_
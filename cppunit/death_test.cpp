@@ -0,0 +1,256 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// death_test.cpp
+//
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "death_test.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <regex>
+#include <stdexcept>
+
+#ifndef _WIN32
+#  include <errno.h>
+#  include <poll.h>
+#  include <signal.h>
+#  include <sys/wait.h>
+#  include <unistd.h>
+#endif
+
+YUNIT_NS_BEGIN
+
+enum {maxShownStderr = 1024};
+
+#ifndef _WIN32
+
+// read both pipes until child closes them, return false, if deadline has come before
+static bool readAll(int stderrFd, std::string &stderrOutput, int statusFd, std::string &statusOutput,
+                    std::chrono::steady_clock::time_point deadline)
+{
+    struct pollfd fds[2];
+    fds[0].fd = stderrFd;
+    fds[1].fd = statusFd;
+    std::string *outputs[2] = {&stderrOutput, &statusOutput};
+
+    char buf[4096];
+    while (fds[0].fd >= 0 || fds[1].fd >= 0)
+    {
+        const long long leftMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+            deadline - std::chrono::steady_clock::now()).count();
+        if (leftMs <= 0)
+            return false;
+
+        fds[0].events = fds[1].events = POLLIN;
+        const int res = ::poll(fds, 2, static_cast<int>(leftMs));
+        if (res < 0 && EINTR != errno)
+            return true;
+
+        for (int idx = 0; idx < 2 && res > 0; ++idx)
+        {
+            if (fds[idx].fd < 0 || 0 == fds[idx].revents)
+                continue;
+
+            const ssize_t size = ::read(fds[idx].fd, buf, sizeof(buf));
+            if (size > 0)
+                outputs[idx]->append(buf, static_cast<size_t>(size));
+            else if (0 == size || EINTR != errno)
+                fds[idx].fd = -1; // negative descriptor is ignored by poll
+        }
+    }
+    return true;
+}
+
+static void runChild(DeathStatement statement, void *ctx, int stderrFd, int statusFd)
+{
+    // crash handlers of test process (fuzzing, crash isolation) must not intercept death of child
+    const int deathSignals[] = {SIGABRT, SIGSEGV, SIGBUS, SIGFPE, SIGILL};
+    for (size_t idx = 0; idx < sizeof(deathSignals) / sizeof(deathSignals[0]); ++idx)
+        ::signal(deathSignals[idx], SIG_DFL);
+
+    ::dup2(stderrFd, STDERR_FILENO);
+    ::close(stderrFd);
+
+    char status = DeathStatus::returned;
+    try
+    {
+        statement(ctx);
+    }
+    catch (...)
+    {
+        status = DeathStatus::threw;
+    }
+
+    ssize_t res;
+    do
+        res = ::write(statusFd, &status, 1);
+    while (res < 0 && EINTR == errno);
+
+    // neither static destructors nor atexit handlers of test process are executed in child
+    ::_exit(0);
+}
+
+DeathStatus runInChild(DeathStatement statement, void *ctx, int timeoutSec)
+{
+    DeathStatus status;
+    status.kind_ = DeathStatus::notSupported;
+    status.code_ = 0;
+
+    // buffered output would be printed twice: by parent and by child
+    ::fflush(NULL);
+
+    int stderrPipe[2], statusPipe[2];
+    if (0 != ::pipe(stderrPipe))
+        return status;
+    if (0 != ::pipe(statusPipe))
+    {
+        ::close(stderrPipe[0]);
+        ::close(stderrPipe[1]);
+        return status;
+    }
+
+    const pid_t pid = ::fork();
+    if (0 == pid)
+    {
+        ::close(stderrPipe[0]);
+        ::close(statusPipe[0]);
+        runChild(statement, ctx, stderrPipe[1], statusPipe[1]);
+    }
+
+    ::close(stderrPipe[1]);
+    ::close(statusPipe[1]);
+
+    if (pid > 0)
+    {
+        const std::chrono::steady_clock::time_point deadline =
+            std::chrono::steady_clock::now() + std::chrono::seconds(timeoutSec);
+        std::string statementStatus;
+        const bool finished = readAll(stderrPipe[0], status.stderr_, statusPipe[0], statementStatus, deadline);
+        if (!finished)
+            ::kill(pid, SIGKILL);
+
+        int waitStatus = 0;
+        pid_t res;
+        do
+            res = ::waitpid(pid, &waitStatus, 0);
+        while (res < 0 && EINTR == errno);
+
+        if (!finished)
+        {
+            status.kind_ = DeathStatus::timedOut;
+            status.code_ = timeoutSec;
+        }
+        else if (!statementStatus.empty())
+            status.kind_ = static_cast<DeathStatus::Kind>(statementStatus[0]);
+        else if (res == pid && WIFSIGNALED(waitStatus))
+        {
+            status.kind_ = DeathStatus::signaled;
+            status.code_ = WTERMSIG(waitStatus);
+        }
+        else if (res == pid && WIFEXITED(waitStatus))
+        {
+            status.kind_ = DeathStatus::exited;
+            status.code_ = WEXITSTATUS(waitStatus);
+        }
+    }
+
+    ::close(stderrPipe[0]);
+    ::close(statusPipe[0]);
+    return status;
+}
+
+static const char* signalName(int signalNumber)
+{
+    return ::strsignal(signalNumber);
+}
+
+#else // _WIN32
+
+DeathStatus runInChild(DeathStatement /*statement*/, void * /*ctx*/, int /*timeoutSec*/)
+{
+    DeathStatus status;
+    status.kind_ = DeathStatus::notSupported;
+    status.code_ = 0;
+    return status;
+}
+
+static const char* signalName(int /*signalNumber*/)
+{
+    return "";
+}
+
+#endif // _WIN32
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+static void throwDeathFailure(const char *prefix, const DeathStatus &status, const char *expectation)
+{
+    enum {msgSize = 512};
+    char msg[msgSize];
+
+    switch (status.kind_)
+    {
+    case DeathStatus::returned:
+        TS_SNPRINTF(msg, msgSize, "%s" " has finished normally, but expected %s", prefix, expectation);
+        break;
+    case DeathStatus::threw:
+        TS_SNPRINTF(msg, msgSize, "%s" " has thrown C++ exception, but expected %s", prefix, expectation);
+        break;
+    case DeathStatus::exited:
+        TS_SNPRINTF(msg, msgSize, "%s" " has exited with code %d, but expected %s", prefix, status.code_, expectation);
+        break;
+    case DeathStatus::signaled:
+        TS_SNPRINTF(msg, msgSize, "%s" " has been killed by signal %d (%s), but expected %s", prefix, status.code_,
+                    signalName(status.code_), expectation);
+        break;
+    case DeathStatus::timedOut:
+        TS_SNPRINTF(msg, msgSize, "%s" " has not finished in %d seconds, but expected %s", prefix, status.code_,
+                    expectation);
+        break;
+    default:
+        TS_SNPRINTF(msg, msgSize, "%s" " can not be executed in child process", prefix);
+        break;
+    }
+    msg[msgSize - 1] = '\0';
+
+    if (status.stderr_.empty())
+        throw std::logic_error(msg);
+
+    throw std::logic_error(std::string(msg) + ", stderr:\n" + status.stderr_.substr(0, maxShownStderr));
+}
+
+void checkDeath(const char *prefix, const DeathStatus &status, const char *stderrPattern)
+{
+    const bool died = DeathStatus::signaled == status.kind_ || (DeathStatus::exited == status.kind_ && 0 != status.code_);
+    if (!died)
+        throwDeathFailure(prefix, status, "death");
+
+    if (NULL == stderrPattern || '\0' == *stderrPattern)
+        return;
+
+    bool matched = false;
+    try
+    {
+        matched = std::regex_search(status.stderr_, std::regex(stderrPattern));
+    }
+    catch (std::regex_error&)
+    {
+        throw std::logic_error(std::string(prefix) + " has invalid stderr pattern \"" + stderrPattern + "\"");
+    }
+
+    if (!matched)
+        throw std::logic_error(std::string(prefix) + " has died, but its stderr does not match \"" + stderrPattern
+                               + "\":\n" + status.stderr_.substr(0, maxShownStderr));
+}
+
+void checkExit(const char *prefix, const DeathStatus &status, int exitCode)
+{
+    if (DeathStatus::exited == status.kind_ && exitCode == status.code_)
+        return;
+
+    char expectation[64];
+    TS_SNPRINTF(expectation, sizeof(expectation), "exit with code %d", exitCode);
+    expectation[sizeof(expectation) - 1] = '\0';
+    throwDeathFailure(prefix, status, expectation);
+}
+
+YUNIT_NS_END
@@ -0,0 +1,70 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// @file death_test.h
+//
+// Execution of statement in forked child process for 'willDie' and 'willExit' asserts. Child is a copy of
+// test process at the moment of assert, so statement sees all test state, and it costs a single fork instead of
+// process spawn. Child stderr is captured and returned to parent for matching.
+//
+// Only the calling thread exists in child. If other threads of test process (e.g. workers of '--jobs=<n>') hold
+// a lock at the moment of fork (heap, stdio), the statement can block forever on it, so death tests should be
+// executed by a single worker. Child, which does not finish in time, is killed and assert fails.
+//
+// Death tests are implemented for POSIX systems only, on other platforms these asserts always fail.
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#ifndef _DEATH_TEST_YUNIT_HEADER_
+#define _DEATH_TEST_YUNIT_HEADER_
+
+#include "../yunit/yunit.h"
+#include <string>
+
+YUNIT_NS_BEGIN
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+struct DeathStatus
+{
+    enum Kind
+    {
+        returned,       ///< statement has finished normally
+        threw,          ///< statement has thrown C++ exception
+        exited,         ///< child has called exit/_exit with 'code_'
+        signaled,       ///< child has been killed by signal 'code_'
+        timedOut,       ///< child has not finished in 'code_' seconds and has been killed
+        notSupported    ///< child process can not be created
+    };
+
+    Kind kind_;
+    int code_;
+    std::string stderr_;    ///< whole stderr output of child
+};
+
+typedef void (*DeathStatement)(void *ctx);
+
+enum {defaultDeathTimeoutSec = 60};
+
+/// @brief Run 'statement(ctx)' in child process and wait its finish
+/// @param timeoutSec Child, which has not finished in this time, is killed by SIGKILL
+DeathStatus runInChild(DeathStatement statement, void *ctx, int timeoutSec = defaultDeathTimeoutSec);
+
+template<typename Func>
+void callDeathStatement(void *ctx)
+{
+    (*static_cast<Func*>(ctx))();
+}
+
+template<typename Func>
+DeathStatus runInChild(Func &func)
+{
+    return runInChild(&callDeathStatement<Func>, &func);
+}
+
+/// @brief Throw std::logic_error, if child has not been killed by signal or has not exited with non-zero code,
+/// or its stderr does not contain match of ECMAScript regular expression 'stderrPattern' (empty one matches any)
+/// @param prefix Error message prefix (file, line, checked statement)
+void checkDeath(const char *prefix, const DeathStatus &status, const char *stderrPattern);
+
+/// @brief Throw std::logic_error, if child has not exited with 'exitCode'
+void checkExit(const char *prefix, const DeathStatus &status, int exitCode);
+
+YUNIT_NS_END
+
+#endif // _DEATH_TEST_YUNIT_HEADER_
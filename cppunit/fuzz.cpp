@@ -0,0 +1,727 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// fuzz.cpp
+//
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "fuzz.h"
+#include "property.h"
+#include "signal_safe.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+
+#ifdef _WIN32
+#  include <windows.h>
+#  include <direct.h>
+#else
+#  define YUNIT_FUZZ_FORK
+#  include <dirent.h>
+#  include <fcntl.h>
+#  include <signal.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <sys/types.h>
+#  include <sys/wait.h>
+#  include <unistd.h>
+#endif
+
+YUNIT_NS_BEGIN
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// counters are cleared before every run
+uint8_t fuzzCoverage[fuzzCoverageMapSize];
+
+const char *defaultFuzzCorpus = "fuzz_corpus";
+
+static std::string fuzzTargetName;
+static std::string fuzzCorpus(defaultFuzzCorpus);
+static std::string fuzzMinimizePath;
+static unsigned long long fuzzRuns = 0;
+static unsigned int fuzzTimeSec = fuzzDefaultTimeSec;
+static unsigned long long fuzzSeed = 0;
+
+void setFuzzTarget(const char *name)
+{
+    fuzzTargetName = (NULL != name) ? name : "";
+}
+
+void setFuzzCorpus(const char *dir)
+{
+    fuzzCorpus = (NULL != dir) ? dir : defaultFuzzCorpus;
+}
+
+void setFuzzRuns(unsigned long long runs)
+{
+    fuzzRuns = runs;
+}
+
+void setFuzzTime(unsigned int seconds)
+{
+    fuzzTimeSec = seconds;
+}
+
+void setFuzzMinimize(const char *path)
+{
+    fuzzMinimizePath = (NULL != path) ? path : "";
+}
+
+void setFuzzSeed(unsigned long long seed)
+{
+    fuzzSeed = seed;
+}
+
+// fuzz.cpp is linked into test program by FUZZ_TEST only, so options are parsed by extension
+struct FuzzExtension : TestExtension
+{
+    virtual bool parseOption(const char *arg)
+    {
+        const char *value;
+        if (NULL != (value = optionValue(arg, "--fuzz=")))
+            setFuzzTarget(value);
+        else if (NULL != (value = optionValue(arg, "--fuzz-corpus=")))
+            setFuzzCorpus(value);
+        else if (NULL != (value = optionValue(arg, "--fuzz-runs=")))
+            setFuzzRuns(::strtoull(value, NULL, 10));
+        else if (NULL != (value = optionValue(arg, "--fuzz-time=")))
+            setFuzzTime(static_cast<unsigned int>(::strtoul(value, NULL, 10)));
+        else if (NULL != (value = optionValue(arg, "--fuzz-minimize=")))
+            setFuzzMinimize(value);
+        else if (NULL != (value = optionValue(arg, "--fuzz-seed=")))
+            setFuzzSeed(::strtoull(value, NULL, 0));
+        else
+            return false;
+        return true;
+    }
+};
+
+static FuzzExtension fuzzExtension;
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+typedef std::vector<uint8_t> Input;
+
+static unsigned long long inputHash(const uint8_t *data, size_t size)
+{
+    // FNV-1a
+    unsigned long long hash = 0xcbf29ce484222325ULL;
+    for (size_t idx = 0; idx < size; ++idx)
+        hash = (hash ^ data[idx]) * 0x100000001b3ULL;
+    return hash;
+}
+
+static std::string joinPath(const std::string &dir, const char *name)
+{
+    return dir.empty() ? std::string(name) : dir + "/" + name;
+}
+
+static void makeDirectory(const std::string &path)
+{
+#ifdef _WIN32
+    ::_mkdir(path.c_str());
+#else
+    ::mkdir(path.c_str(), 0755);
+#endif
+}
+
+static std::vector<std::string> listDirectory(const std::string &dir)
+{
+    std::vector<std::string> files;
+#ifdef _WIN32
+    WIN32_FIND_DATAA data;
+    HANDLE handle = ::FindFirstFileA((dir + "\\*").c_str(), &data);
+    if (INVALID_HANDLE_VALUE == handle)
+        return files;
+    do
+    {
+        if (0 == (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) && '.' != data.cFileName[0])
+            files.push_back(joinPath(dir, data.cFileName));
+    }
+    while (::FindNextFileA(handle, &data));
+    ::FindClose(handle);
+#else
+    DIR *directory = ::opendir(dir.c_str());
+    if (NULL == directory)
+        return files;
+
+    while (const struct dirent *entry = ::readdir(directory))
+    {
+        if ('.' == entry->d_name[0])
+            continue;
+
+        const std::string path = joinPath(dir, entry->d_name);
+        struct stat info;
+        if (0 == ::stat(path.c_str(), &info) && S_ISREG(info.st_mode))
+            files.push_back(path);
+    }
+    ::closedir(directory);
+#endif
+
+    std::sort(files.begin(), files.end());
+    return files;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief Read-only content of file, mapped into memory where it is possible
+class MappedFile
+{
+public:
+    explicit MappedFile(const std::string &path)
+    : data_(NULL)
+    , size_(0)
+    , mapped_(false)
+    , opened_(false)
+    {
+#ifdef _WIN32
+        FILE *file = ::fopen(path.c_str(), "rb");
+        if (NULL == file)
+            return;
+        uint8_t buf[4096];
+        for (size_t read; 0 < (read = ::fread(buf, 1, sizeof(buf), file)); )
+            content_.insert(content_.end(), buf, buf + read);
+        ::fclose(file);
+        data_ = content_.empty() ? NULL : &content_[0];
+        size_ = content_.size();
+        opened_ = true;
+#else
+        const int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            return;
+
+        struct stat info;
+        if (0 == ::fstat(fd, &info))
+        {
+            size_ = static_cast<size_t>(info.st_size);
+            opened_ = true;
+            if (size_ > 0)
+            {
+                void *memory = ::mmap(NULL, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+                mapped_ = MAP_FAILED != memory;
+                opened_ = mapped_;
+                data_ = mapped_ ? static_cast<const uint8_t*>(memory) : NULL;
+            }
+        }
+        ::close(fd);
+#endif
+    }
+
+    ~MappedFile()
+    {
+#ifndef _WIN32
+        if (mapped_)
+            ::munmap(const_cast<uint8_t*>(data_), size_);
+#endif
+    }
+
+    bool opened() const
+    {
+        return opened_;
+    }
+
+    const uint8_t* data() const
+    {
+        static const uint8_t empty = 0;
+        return (NULL != data_) ? data_ : &empty;
+    }
+
+    size_t size() const
+    {
+        return size_;
+    }
+
+private:
+    MappedFile(const MappedFile&);
+    MappedFile& operator=(const MappedFile&);
+
+    const uint8_t *data_;
+    size_t size_;
+    bool mapped_;
+    bool opened_;
+    Input content_;
+};
+
+static bool writeFile(const std::string &path, const Input &input)
+{
+    FILE *file = ::fopen(path.c_str(), "wb");
+    if (NULL == file)
+        return false;
+    const bool written = input.empty() || input.size() == ::fwrite(&input[0], 1, input.size(), file);
+    ::fclose(file);
+    return written;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Input of current run and origin of it; signal handler saves them, when target kills process
+struct CrashContext
+{
+    const uint8_t *volatile data_;
+    volatile size_t size_;
+    const char *volatile name_;
+    const char *volatile corpusFile_;   ///< replayed file, input is not saved then
+};
+
+static CrashContext crashContext;
+
+#ifdef YUNIT_FUZZ_FORK
+static const int crashSignals[] = {SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT};
+enum {crashSignalsNumber = sizeof(crashSignals) / sizeof(crashSignals[0])};
+
+// handlers, which have been installed before CrashGuard ('--crash-isolation' ones, for example)
+static struct sigaction previousActions[crashSignalsNumber];
+
+static void restorePreviousActions()
+{
+    for (int idx = 0; idx < crashSignalsNumber; ++idx)
+        ::sigaction(crashSignals[idx], &previousActions[idx], NULL);
+}
+
+// Previous handler may not return (crash isolation jumps back to test execution), so guard is dismissed
+// before it is called
+static void chainCrashSignal(int signal, siginfo_t *info, void *context)
+{
+    restorePreviousActions();
+    crashContext.data_ = NULL;
+    crashContext.name_ = NULL;
+    crashContext.corpusFile_ = NULL;
+
+    int idx = 0;
+    while (idx < crashSignalsNumber && crashSignals[idx] != signal)
+        ++idx;
+    if (crashSignalsNumber == idx)
+        return;
+
+    const struct sigaction &previous = previousActions[idx];
+    if (0 != (previous.sa_flags & SA_SIGINFO))
+        previous.sa_sigaction(signal, info, context);
+    else if (SIG_IGN == previous.sa_handler)
+        return;
+    else if (SIG_DFL != previous.sa_handler)
+        previous.sa_handler(signal);
+    else
+        ::raise(signal); // delivered with default action after return from handler
+}
+
+static void onCrashSignal(int signal, siginfo_t *info, void *context)
+{
+    char msg[1024] = "";
+    if (NULL != crashContext.corpusFile_)
+    {
+        appendString(msg, sizeof(msg), "\nfuzz target has crashed on corpus input ");
+        appendString(msg, sizeof(msg), crashContext.corpusFile_);
+        appendString(msg, sizeof(msg), "\n");
+    }
+    else if (NULL != crashContext.data_ && NULL != crashContext.name_)
+    {
+        char path[512] = "crash-";
+        appendString(path, sizeof(path), crashContext.name_);
+        appendString(path, sizeof(path), "-");
+        appendHex(path, sizeof(path), inputHash(crashContext.data_, crashContext.size_));
+
+        const int fd = ::open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd >= 0)
+        {
+            if (::write(fd, crashContext.data_, crashContext.size_) < 0)
+                appendString(msg, sizeof(msg), "\ncrash input can not be written");
+            ::close(fd);
+        }
+
+        appendString(msg, sizeof(msg), "\nfuzz target has crashed, input is written into ");
+        appendString(msg, sizeof(msg), path);
+        appendString(msg, sizeof(msg), "\nminimize it with --fuzz=");
+        appendString(msg, sizeof(msg), crashContext.name_);
+        appendString(msg, sizeof(msg), " --fuzz-minimize=");
+        appendString(msg, sizeof(msg), path);
+        appendString(msg, sizeof(msg), "\n");
+    }
+    writeStderr(msg);
+
+    chainCrashSignal(signal, info, context);
+}
+#endif // YUNIT_FUZZ_FORK
+
+/// @brief Save input of crashed run while object exists
+class CrashGuard
+{
+public:
+    CrashGuard(const char *name, const char *corpusFile)
+    {
+        crashContext.data_ = NULL;
+        crashContext.size_ = 0;
+        crashContext.name_ = name;
+        crashContext.corpusFile_ = corpusFile;
+
+#ifdef YUNIT_FUZZ_FORK
+        struct sigaction action;
+        ::memset(&action, 0, sizeof(action));
+        action.sa_sigaction = onCrashSignal;
+        action.sa_flags = SA_SIGINFO | SA_ONSTACK;
+        sigemptyset(&action.sa_mask);
+        for (int idx = 0; idx < crashSignalsNumber; ++idx)
+            ::sigaction(crashSignals[idx], &action, &previousActions[idx]);
+#endif
+    }
+
+    ~CrashGuard()
+    {
+#ifdef YUNIT_FUZZ_FORK
+        restorePreviousActions();
+#endif
+        crashContext.data_ = NULL;
+        crashContext.name_ = NULL;
+        crashContext.corpusFile_ = NULL;
+    }
+
+private:
+    CrashGuard(const CrashGuard&);
+    CrashGuard& operator=(const CrashGuard&);
+};
+
+/// @return false, if target has thrown exception
+static bool execute(FuzzTarget target, const uint8_t *data, size_t size, std::string &error)
+{
+    crashContext.data_ = data;
+    crashContext.size_ = size;
+
+    bool passed = true;
+    try
+    {
+        target(data, size);
+    }
+    catch (std::exception &ex)
+    {
+        error = ex.what();
+        passed = false;
+    }
+    catch (...)
+    {
+        error = "unknown C++ exception";
+        passed = false;
+    }
+
+    crashContext.data_ = NULL;
+    return passed;
+}
+
+// input is copied into buffer of exact size, so memory checkers detect reading after its end
+static bool execute(FuzzTarget target, const Input &input, std::string &error)
+{
+    uint8_t *copy = new uint8_t[input.size() + (input.empty() ? 1 : 0)];
+    if (!input.empty())
+        ::memcpy(copy, &input[0], input.size());
+    const bool passed = execute(target, copy, input.size(), error);
+    delete [] copy;
+    return passed;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+unsigned int replayCorpus(const char *dir, FuzzTarget target)
+{
+    const std::vector<std::string> files = listDirectory(dir);
+
+    for (size_t idx = 0; idx < files.size(); ++idx)
+    {
+        MappedFile file(files[idx]);
+        if (!file.opened())
+            throw std::logic_error("fuzz corpus input " + files[idx] + " can not be read");
+
+        CrashGuard guard(NULL, files[idx].c_str());
+        std::string error;
+        if (!execute(target, file.data(), file.size(), error))
+            throw std::logic_error("fuzz corpus input " + files[idx] + " fails target: " + error);
+    }
+
+    return static_cast<unsigned int>(files.size());
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+std::vector<uint8_t> minimizeInput(const std::vector<uint8_t> &input, FuzzPredicate fails, void *ctx)
+{
+    Input best(input);
+    unsigned int attempts = 0;
+
+    // remove chunks of halving size; removal is kept, if input still fails
+    for (size_t chunk = std::max<size_t>(best.size() / 2, 1); !best.empty() && attempts < fuzzMinimizeAttempts; chunk /= 2)
+    {
+        for (size_t offset = 0; offset < best.size() && attempts < fuzzMinimizeAttempts; ++attempts)
+        {
+            Input candidate(best.begin(), best.begin() + offset);
+            candidate.insert(candidate.end(), best.begin() + std::min(offset + chunk, best.size()), best.end());
+
+            if (fails(ctx, candidate))
+                best.swap(candidate);
+            else
+                offset += chunk;
+        }
+
+        if (1 == chunk)
+            break;
+    }
+
+    return best;
+}
+
+static bool throwsException(void *ctx, const Input &input)
+{
+    std::string error;
+    return !execute(reinterpret_cast<FuzzTarget>(ctx), input, error);
+}
+
+#ifdef YUNIT_FUZZ_FORK
+static bool failsInChildProcess(void *ctx, const Input &input)
+{
+    ::fflush(NULL);
+    const pid_t pid = ::fork();
+    if (pid < 0)
+        return false;
+
+    if (0 == pid)
+        ::_exit(throwsException(ctx, input) ? 1 : 0);
+
+    int status = 0;
+    if (::waitpid(pid, &status, 0) != pid)
+        return false;
+    return !WIFEXITED(status) || 0 != WEXITSTATUS(status);
+}
+#endif
+
+static std::string inputName(const Input &input)
+{
+    char name[32] = "";
+    appendHex(name, sizeof(name), inputHash(input.empty() ? NULL : &input[0], input.size()));
+    return name;
+}
+
+static void minimizeCrashFile(const char *name, FuzzTarget target, const std::string &path)
+{
+    MappedFile file(path);
+    if (!file.opened())
+        throw std::logic_error("crash input " + path + " can not be read");
+    const Input input(file.data(), file.data() + file.size());
+
+#ifdef YUNIT_FUZZ_FORK
+    FuzzPredicate fails = failsInChildProcess;
+#else
+    FuzzPredicate fails = throwsException; // process killing inputs can not be minimized without fork
+#endif
+    void *ctx = reinterpret_cast<void*>(target);
+
+    if (!fails(ctx, input))
+        throw std::logic_error("crash input " + path + " does not fail fuzz target " + name);
+
+    const Input minimized = minimizeInput(input, fails, ctx);
+    const std::string minimizedPath = path + ".min";
+    if (!writeFile(minimizedPath, minimized))
+        throw std::logic_error("minimized input can not be written into " + minimizedPath);
+
+    ::fprintf(stderr, "%s: crash input is minimized from %u to %u bytes into %s\n", name,
+              static_cast<unsigned int>(input.size()), static_cast<unsigned int>(minimized.size()),
+              minimizedPath.c_str());
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Feature is pair (counter, logarithmic bucket of its hits), so loops with new number of iterations are
+// interesting too
+static uint8_t seenFeatures[fuzzCoverageMapSize];
+
+static uint8_t hitsBucket(uint8_t hits)
+{
+    if (hits < 4)
+        return static_cast<uint8_t>(1 << (hits - 1)); // 1, 2 and 3 hits
+    if (hits < 8)
+        return 8;
+    if (hits < 16)
+        return 16;
+    if (hits < 32)
+        return 32;
+    return (hits < 128) ? 64 : 128;
+}
+
+/// @return number of features, which have not been seen before; counters are cleared
+static unsigned int collectFeatures()
+{
+    unsigned int newFeatures = 0;
+    for (size_t idx = 0; idx < fuzzCoverageMapSize; idx += sizeof(unsigned long long))
+    {
+        unsigned long long word;
+        ::memcpy(&word, fuzzCoverage + idx, sizeof(word));
+        if (0 == word)
+            continue;
+
+        for (size_t counterIdx = idx; counterIdx < idx + sizeof(word); ++counterIdx)
+        {
+            if (0 == fuzzCoverage[counterIdx])
+                continue;
+
+            const uint8_t bucket = hitsBucket(fuzzCoverage[counterIdx]);
+            if (0 == (seenFeatures[counterIdx] & bucket))
+            {
+                seenFeatures[counterIdx] |= bucket;
+                ++newFeatures;
+            }
+            fuzzCoverage[counterIdx] = 0;
+        }
+    }
+    return newFeatures;
+}
+
+static void mutate(Input &input, const std::vector<Input> &corpus, Random &random)
+{
+    static const uint8_t interesting[] = {0, 1, 0x7f, 0x80, 0xff, '0', '9', 'a', ' ', '\n'};
+
+    for (unsigned long long mutations = 1 + random.below(4); mutations > 0; --mutations)
+    {
+        const size_t size = input.size();
+        const size_t pos = static_cast<size_t>(random.below(size));
+
+        switch (random.below(input.empty() ? 1 : 8))
+        {
+        case 0: // insert random byte
+            if (size < fuzzMaxInputSize)
+                input.insert(input.begin() + static_cast<size_t>(random.below(size + 1)), static_cast<uint8_t>(random.next()));
+            break;
+        case 1:
+            input[pos] ^= static_cast<uint8_t>(1 << random.below(8));
+            break;
+        case 2:
+            input[pos] = static_cast<uint8_t>(random.next());
+            break;
+        case 3:
+            input[pos] = interesting[random.below(sizeof(interesting))];
+            break;
+        case 4:
+            input[pos] = static_cast<uint8_t>(input[pos] + random.below(33) - 16);
+            break;
+        case 5: // erase bytes
+            input.erase(input.begin() + pos, input.begin() + std::min<size_t>(size, pos + 1 + random.below(4)));
+            break;
+        case 6: // duplicate chunk of input
+        {
+            const size_t length = std::min<size_t>(1 + static_cast<size_t>(random.below(size - pos)), fuzzMaxInputSize - size);
+            const Input chunk(input.begin() + pos, input.begin() + pos + length);
+            input.insert(input.begin() + static_cast<size_t>(random.below(size + 1)), chunk.begin(), chunk.end());
+            break;
+        }
+        default: // crossover with other corpus input
+        {
+            const Input &other = corpus[static_cast<size_t>(random.below(corpus.size()))];
+            if (other.empty())
+                break;
+            const size_t from = static_cast<size_t>(random.below(other.size()));
+            const size_t length = std::min<size_t>(1 + static_cast<size_t>(random.below(other.size() - from)),
+                                                   fuzzMaxInputSize - pos);
+            input.resize(std::max(input.size(), pos + length));
+            std::copy(other.begin() + from, other.begin() + from + length, input.begin() + pos);
+            break;
+        }
+        }
+    }
+}
+
+unsigned int fuzz(const char *name, FuzzTarget target, const char *dir)
+{
+    makeDirectory(fuzzCorpus);
+    makeDirectory(dir);
+
+    std::vector<Input> corpus;
+    const std::vector<std::string> files = listDirectory(dir);
+    for (size_t idx = 0; idx < files.size(); ++idx)
+    {
+        MappedFile file(files[idx]);
+        if (file.opened() && file.size() <= fuzzMaxInputSize)
+            corpus.push_back(Input(file.data(), file.data() + file.size()));
+    }
+    if (corpus.empty())
+        corpus.push_back(Input());
+
+    CrashGuard guard(name, NULL);
+    const unsigned long long seed = (0 != fuzzSeed) ? fuzzSeed : currentTimeNs();
+    Random random(seed);
+    ::memset(fuzzCoverage, 0, sizeof(fuzzCoverage));
+    ::memset(seenFeatures, 0, sizeof(seenFeatures));
+
+    const unsigned long long startTime = currentTimeNs();
+    unsigned long long runs = 0, nextReport = 1024;
+    unsigned int features = 0, added = 0;
+    std::string error;
+
+    // corpus itself is executed at first, mutated inputs are kept, if they reach new features
+    for (const size_t corpusSize = corpus.size(); ; ++runs)
+    {
+        Input input;
+        if (runs < corpusSize)
+            input = corpus[static_cast<size_t>(runs)];
+        else
+        {
+            input = corpus[static_cast<size_t>(random.below(corpus.size()))];
+            mutate(input, corpus, random);
+        }
+
+        if (!execute(target, input, error))
+        {
+            const Input minimized = minimizeInput(input, throwsException, reinterpret_cast<void*>(target));
+            const std::string path = std::string("crash-") + name + "-" + inputName(minimized);
+            writeFile(path, minimized);
+
+            enum {msgSize = 1024};
+            char msg[msgSize];
+            TS_SNPRINTF(msg, msgSize, "fuzz target %s has failed after %llu runs (--fuzz-seed=%llu), input of %u bytes "
+                        "(minimized from %u) is written into %s: ", name, runs + 1, seed,
+                        static_cast<unsigned int>(minimized.size()), static_cast<unsigned int>(input.size()),
+                        path.c_str());
+            msg[msgSize - 1] = '\0';
+            throw std::logic_error(msg + error);
+        }
+
+        const unsigned int newFeatures = collectFeatures();
+        features += newFeatures;
+        if (newFeatures > 0 && runs >= corpusSize)
+        {
+            writeFile(joinPath(dir, inputName(input).c_str()), input);
+            corpus.push_back(input);
+            ++added;
+        }
+
+        if (runs + 1 == corpusSize && 0 == features)
+            ::fprintf(stderr, "%s: no coverage is collected, compile code under test with -fsanitize-coverage\n", name);
+
+        const unsigned long long elapsedNs = currentTimeNs() - startTime;
+        if (runs + 1 >= nextReport)
+        {
+            ::fprintf(stderr, "%s: #%llu\tfeatures: %u\tcorpus: %u\texec/s: %llu\n", name, runs + 1, features,
+                      static_cast<unsigned int>(corpus.size()),
+                      (runs + 1) * 1000000000ULL / (elapsedNs > 0 ? elapsedNs : 1));
+            nextReport *= 2;
+        }
+
+        if ((0 != fuzzRuns && runs + 1 >= fuzzRuns)
+            || (0 != fuzzTimeSec && elapsedNs >= fuzzTimeSec * 1000000000ULL))
+            break;
+    }
+
+    ::fprintf(stderr, "%s: %llu runs with --fuzz-seed=%llu, %u inputs are added to %s\n", name, runs + 1, seed,
+              added, dir);
+    return added;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void runFuzzTarget(const char *name, FuzzTarget target)
+{
+    const std::string dir = joinPath(fuzzCorpus, name);
+
+    if (fuzzTargetName != name)
+    {
+        // target must not fail with empty input too, it is the only input of empty corpus
+        if (0 == replayCorpus(dir.c_str(), target))
+        {
+            std::string error;
+            if (!execute(target, Input(), error))
+                throw std::logic_error(std::string("fuzz target fails with empty input: ") + error);
+        }
+    }
+    else if (!fuzzMinimizePath.empty())
+        minimizeCrashFile(name, target, fuzzMinimizePath);
+    else
+        fuzz(name, target, dir.c_str());
+}
+
+YUNIT_NS_END
@@ -0,0 +1,99 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// @file fuzz.h
+//
+// In-process fuzz targets, registered as ordinary tests:
+// @code
+// FUZZ_TEST(parseNumber)(const uint8_t *data, size_t size)
+// {
+//     std::string text(reinterpret_cast<const char*>(data), size);
+//     parseNumber(text); // must not crash or throw for any input
+// }
+// @endcode
+// Normally test replays every file of corpus directory '<corpus>/<test name>' (regression mode). With
+// '--fuzz=<test name>' option the test mutates corpus inputs instead, until time or runs limit. Inputs, which
+// reach new coverage, are saved into corpus directory; input, which fails target, is minimized and written
+// into 'crash-<test name>-<hash>' file of current directory.
+//
+// Coverage is collected by SanitizerCoverage hooks of fuzz_coverage.cpp (CMake object library
+// 'yunit_fuzz_coverage'), so link it into test program and compile code under test with
+// '-fsanitize-coverage=trace-pc-guard' (Clang) or '-fsanitize-coverage=trace-pc' (GCC). Do not link hooks into
+// program, which has other SanitizerCoverage runtime ('-fsanitize=fuzzer' and so on). Without coverage
+// mutations are random. Coverage map is common for all threads, so fuzz with one worker ('--jobs=1').
+//
+// Mutations are drawn from PRNG, seeded from clock or by '--fuzz-seed=<n>'; seed is printed by fuzzing, so run
+// with the same seed and binary repeats it.
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#ifndef _FUZZ_YUNIT_HEADER_
+#define _FUZZ_YUNIT_HEADER_
+
+#include "tests.h"
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+YUNIT_NS_BEGIN
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#define FUZZ_TEST(name)\
+    static void FuzzTarget__##name(const uint8_t *data, size_t size);\
+    struct TestCase__##name : YUNIT_NS_PREF(Test)\
+    {\
+        virtual void testBody()\
+        {\
+            YUNIT_NS_PREF(runFuzzTarget)(#name, &FuzzTarget__##name);\
+        }\
+    };\
+    registerTest(name, __FILE__, __LINE__)\
+    static void FuzzTarget__##name
+
+typedef void (*FuzzTarget)(const uint8_t *data, size_t size);
+
+enum
+{
+    fuzzMaxInputSize = 4096,        ///< mutations do not make inputs longer
+    fuzzDefaultTimeSec = 60,
+    fuzzMinimizeAttempts = 10000,
+    fuzzCoverageMapSize = 64 * 1024
+};
+
+extern const char *defaultFuzzCorpus;
+
+/// @brief Hit counters of instrumented edges (or basic blocks for 'trace-pc'), filled by coverage hooks
+extern uint8_t fuzzCoverage[fuzzCoverageMapSize];
+
+/// @brief Fuzz test 'name' instead of corpus replay ('--fuzz=<name>'), NULL disables fuzzing
+void setFuzzTarget(const char *name);
+
+/// @brief Root of corpus directories ('--fuzz-corpus=<dir>'), corpus of test is '<dir>/<test name>'
+void setFuzzCorpus(const char *dir);
+
+/// @brief Fuzzing limits ('--fuzz-runs=<n>', '--fuzz-time=<seconds>'), zero means no limit
+void setFuzzRuns(unsigned long long runs);
+void setFuzzTime(unsigned int seconds);
+
+/// @brief Seed of mutations ('--fuzz-seed=<n>'), zero takes seed from clock
+void setFuzzSeed(unsigned long long seed);
+
+/// @brief Minimize crash input 'path' of '--fuzz' target instead of fuzzing ('--fuzz-minimize=<path>'). Every
+/// attempt is executed in child process, so inputs, which kill process, are minimized too. Result is written
+/// into '<path>.min'.
+void setFuzzMinimize(const char *path);
+
+/// @brief Body of FUZZ_TEST: replay corpus, fuzz or minimize crash according to options
+void runFuzzTarget(const char *name, FuzzTarget target);
+
+/// @brief Execute 'target' with every file of 'dir'; files are mapped into memory, not read
+/// @return number of replayed files; target failure is rethrown with name of file
+unsigned int replayCorpus(const char *dir, FuzzTarget target);
+
+/// @brief Coverage-guided mutation of 'dir' corpus inputs
+/// @return number of inputs, added to corpus; target failure is thrown with name of minimized crash file
+unsigned int fuzz(const char *name, FuzzTarget target, const char *dir);
+
+/// @brief Remove chunks of 'input' while 'fails' returns true for rest of input
+typedef bool (*FuzzPredicate)(void *ctx, const std::vector<uint8_t> &input);
+std::vector<uint8_t> minimizeInput(const std::vector<uint8_t> &input, FuzzPredicate fails, void *ctx);
+
+YUNIT_NS_END
+
+#endif // _FUZZ_YUNIT_HEADER_
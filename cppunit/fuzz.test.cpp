@@ -0,0 +1,135 @@
+#include "asserts.h"
+#include "fuzz.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#ifndef _WIN32
+#  include <dirent.h>
+#  include <sys/stat.h>
+#endif
+
+FUZZ_TEST(fuzzMagicPrefix)(const uint8_t *data, size_t size)
+{
+    // nested branches give coverage feedback for every byte of prefix
+    if (size > 0 && 'F' == data[0])
+        if (size > 1 && 'U' == data[1])
+            if (size > 2 && 'Z' == data[2])
+                throw std::logic_error("magic prefix");
+}
+
+static unsigned int replayedInputs = 0;
+
+FUZZ_TEST(fuzzAnyInput)(const uint8_t * /*data*/, size_t /*size*/)
+{
+    ++replayedInputs;
+}
+
+static bool containsX(void * /*ctx*/, const std::vector<uint8_t> &input)
+{
+    return input.end() != std::find(input.begin(), input.end(), 'X');
+}
+
+static void writeFile(const std::string &path, const char *content)
+{
+    FILE *file = ::fopen(path.c_str(), "wb");
+    isNotNull(file);
+    ::fwrite(content, 1, ::strlen(content), file);
+    ::fclose(file);
+}
+
+static std::string readFile(const std::string &path)
+{
+    std::string content;
+    FILE *file = ::fopen(path.c_str(), "rb");
+    if (NULL == file)
+        return content;
+    char buf[256];
+    for (size_t read; 0 < (read = ::fread(buf, 1, sizeof(buf), file)); )
+        content.append(buf, read);
+    ::fclose(file);
+    return content;
+}
+
+static void removeDirectory(const std::string &path)
+{
+#ifndef _WIN32
+    if (DIR *dir = ::opendir(path.c_str()))
+    {
+        while (const struct dirent *entry = ::readdir(dir))
+            if (0 != ::strcmp(entry->d_name, ".") && 0 != ::strcmp(entry->d_name, ".."))
+                ::remove((path + "/" + entry->d_name).c_str());
+        ::closedir(dir);
+    }
+#endif
+    ::remove(path.c_str());
+}
+
+int main(int /*argc*/, char ** /*argv*/)
+{
+    using namespace YUNIT_NS;
+
+    const std::string corpus = "fuzz_test.corpus";
+    const std::string anyInputCorpus = corpus + "/fuzzAnyInput";
+    const std::string magicCorpus = corpus + "/fuzzMagicPrefix";
+    removeDirectory(anyInputCorpus);
+    removeDirectory(magicCorpus);
+    removeDirectory(corpus);
+    setFuzzCorpus(corpus.c_str());
+
+    // empty corpus: target is executed with empty input
+    runFuzzTarget("fuzzAnyInput", FuzzTarget__fuzzAnyInput);
+    areEq(1u, replayedInputs);
+
+#ifndef _WIN32
+    ::mkdir(corpus.c_str(), 0755);
+    ::mkdir(anyInputCorpus.c_str(), 0755);
+#endif
+    writeFile(anyInputCorpus + "/first", "first");
+    writeFile(anyInputCorpus + "/empty", "");
+    areEq(2u, replayCorpus(anyInputCorpus.c_str(), FuzzTarget__fuzzAnyInput));
+
+    std::vector<uint8_t> input(100, 'a');
+    input[57] = 'X';
+    const std::vector<uint8_t> minimized = minimizeInput(input, containsX, NULL);
+    areEq(1u, minimized.size());
+    areEq('X', minimized[0]);
+
+#ifdef YUNIT_FUZZ_COVERAGE
+    // fixed seed makes fuzzing reproducible, so it is bounded by runs only
+    setFuzzTarget("fuzzMagicPrefix");
+    setFuzzSeed(1);
+    setFuzzRuns(1000000);
+    setFuzzTime(0);
+
+    std::string failure;
+    try
+    {
+        runFuzzTarget("fuzzMagicPrefix", FuzzTarget__fuzzMagicPrefix);
+    }
+    catch (std::logic_error &ex)
+    {
+        failure = ex.what();
+    }
+    setFuzzTarget(NULL);
+    setFuzzSeed(0);
+
+    const char *crashFile = ::strstr(failure.c_str(), "crash-fuzzMagicPrefix-");
+    isNotNull(crashFile);
+    const std::string crashPath(crashFile, ::strcspn(crashFile, ":"));
+    areEq("FUZ", readFile(crashPath));
+
+    // crash is a regression test, when it is added to corpus
+    writeFile(magicCorpus + "/crash", "FUZ");
+    willThrow(runFuzzTarget("fuzzMagicPrefix", FuzzTarget__fuzzMagicPrefix), std::logic_error);
+    ::remove(crashPath.c_str());
+#else
+    ::printf("fuzzing is skipped, compiler does not support -fsanitize-coverage\n");
+#endif
+
+    removeDirectory(anyInputCorpus);
+    removeDirectory(magicCorpus);
+    removeDirectory(corpus);
+    return 0;
+}
@@ -0,0 +1,32 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// fuzz_coverage.cpp
+//
+// SanitizerCoverage hooks of FUZZ_TEST, see fuzz.h. Do not compile this file with '-fsanitize-coverage'.
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "fuzz.h"
+
+#ifdef __GNUC__
+
+static uint32_t fuzzGuards = 0;
+
+extern "C" void __sanitizer_cov_trace_pc_guard_init(uint32_t *start, uint32_t *stop)
+{
+    if (start == stop || 0 != *start) // module has been initialized already
+        return;
+    for (uint32_t *guard = start; guard < stop; ++guard)
+        *guard = ++fuzzGuards;
+}
+
+extern "C" void __sanitizer_cov_trace_pc_guard(uint32_t *guard)
+{
+    ++YUNIT_NS_PREF(fuzzCoverage)[*guard % YUNIT_NS_PREF(fuzzCoverageMapSize)];
+}
+
+extern "C" void __sanitizer_cov_trace_pc()
+{
+    const uintptr_t pc = reinterpret_cast<uintptr_t>(__builtin_return_address(0));
+    ++YUNIT_NS_PREF(fuzzCoverage)[(pc ^ (pc >> 16)) % YUNIT_NS_PREF(fuzzCoverageMapSize)];
+}
+
+#endif // __GNUC__
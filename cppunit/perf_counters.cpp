@@ -0,0 +1,295 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// perf_counters.cpp
+//
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "perf_counters.h"
+#include <cstring>
+
+#ifdef __linux__
+#  define YUNIT_PERF_EVENTS
+#  include <linux/perf_event.h>
+#  include <sys/ioctl.h>
+#  include <sys/resource.h>
+#  include <sys/syscall.h>
+#  include <unistd.h>
+#endif
+
+YUNIT_NS_BEGIN
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+PerfCounters::PerfCounters()
+: source_(sourceNone)
+, leader_(-1)
+, available_(0)
+{
+    for (int idx = 0; idx < perfCountersNumber; ++idx)
+    {
+        fds_[idx] = -1;
+        startValues_[idx] = 0;
+    }
+}
+
+PerfCounters::~PerfCounters()
+{
+    close();
+}
+
+const char* PerfCounters::name(PerfCounter counter)
+{
+    static const char *names[perfCountersNumber] =
+    {
+        "cycles", "instructions", "cache-misses", "branch-misses", "page-faults", "cpu-time-ns"
+    };
+    return (counter >= 0 && counter < perfCountersNumber) ? names[counter] : "";
+}
+
+#ifdef YUNIT_PERF_EVENTS
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+struct PerfEvent
+{
+    unsigned int type_;
+    unsigned long long config_;
+};
+
+// indexed by PerfCounter
+static const PerfEvent perfEvents[perfCountersNumber] =
+{
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+    {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS},
+    {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK}
+};
+
+static int perfEventOpen(const PerfEvent &event, int groupFd)
+{
+    struct perf_event_attr attr;
+    ::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = event.type_;
+    attr.config = event.config_;
+    attr.disabled = (-1 == groupFd) ? 1 : 0; // members follow leader state
+    // user space only, so default perf_event_paranoid level (2) allows counting
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+    return static_cast<int>(::syscall(__NR_perf_event_open, &attr, 0/* calling thread */, -1/* any CPU */, groupFd, 0));
+}
+
+bool PerfCounters::openGroup(bool hardware)
+{
+    bool hardwareOpened = false;
+    for (int idx = 0; idx < perfCountersNumber; ++idx)
+    {
+        const bool isHardware = PERF_TYPE_HARDWARE == perfEvents[idx].type_;
+        if (isHardware && !hardware)
+            continue;
+
+        const int fd = perfEventOpen(perfEvents[idx], leader_);
+        if (fd < 0)
+            continue;
+
+        fds_[idx] = fd;
+        available_ |= 1u << idx;
+        if (-1 == leader_)
+            leader_ = fd;
+        hardwareOpened = hardwareOpened || isHardware;
+    }
+
+    if (hardware && !hardwareOpened)
+    {
+        close();
+        return false;
+    }
+
+    return -1 != leader_;
+}
+
+PerfCounters::Source PerfCounters::open()
+{
+    close();
+
+    if (openGroup(true))
+        source_ = sourceHardware;
+    else if (openGroup(false))
+        source_ = sourceSoftware;
+    else
+    {
+        source_ = sourceRusage;
+        available_ = (1u << perfPageFaults) | (1u << perfCpuTimeNs);
+    }
+
+    return source_;
+}
+
+void PerfCounters::close()
+{
+    for (int idx = 0; idx < perfCountersNumber; ++idx)
+    {
+        if (-1 != fds_[idx])
+            ::close(fds_[idx]);
+        fds_[idx] = -1;
+    }
+
+    leader_ = -1;
+    available_ = 0;
+    source_ = sourceNone;
+}
+
+void PerfCounters::start()
+{
+    if (-1 != leader_)
+    {
+        ::ioctl(leader_, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ::ioctl(leader_, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+    else if (sourceRusage == source_)
+        readRusage(startValues_);
+}
+
+unsigned int PerfCounters::stop(unsigned long long values[perfCountersNumber])
+{
+    for (int idx = 0; idx < perfCountersNumber; ++idx)
+        values[idx] = 0;
+
+    if (sourceRusage == source_)
+    {
+        readRusage(values);
+        for (int idx = 0; idx < perfCountersNumber; ++idx)
+            values[idx] -= startValues_[idx];
+        return available_;
+    }
+
+    if (-1 == leader_)
+        return 0;
+
+    ::ioctl(leader_, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+
+    // {nr, time_enabled, time_running, values[nr]}, values are in order of opening
+    unsigned long long buf[3 + perfCountersNumber];
+    const ssize_t size = ::read(leader_, buf, sizeof(buf));
+    if (size < static_cast<ssize_t>(3 * sizeof(buf[0])))
+        return 0;
+
+    const unsigned long long number = buf[0];
+    const unsigned long long enabled = buf[1];
+    const unsigned long long running = buf[2];
+
+    unsigned long long valueIdx = 0;
+    for (int idx = 0; idx < perfCountersNumber && valueIdx < number; ++idx)
+    {
+        if (-1 == fds_[idx])
+            continue;
+
+        unsigned long long value = buf[3 + valueIdx++];
+        // group has been multiplexed with other events, so it was counting part of time only
+        if (running > 0 && running < enabled)
+            value = static_cast<unsigned long long>(static_cast<double>(value) * enabled / running);
+        values[idx] = value;
+    }
+
+    return available_;
+}
+
+void PerfCounters::readRusage(unsigned long long values[perfCountersNumber]) const
+{
+    for (int idx = 0; idx < perfCountersNumber; ++idx)
+        values[idx] = 0;
+
+    struct rusage usage;
+    if (0 != ::getrusage(RUSAGE_THREAD, &usage))
+        return;
+
+    values[perfPageFaults] = usage.ru_minflt + usage.ru_majflt;
+    values[perfCpuTimeNs] = (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000000ULL
+                          + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) * 1000ULL;
+}
+
+#else // YUNIT_PERF_EVENTS
+
+bool PerfCounters::openGroup(bool /*hardware*/)
+{
+    return false;
+}
+
+PerfCounters::Source PerfCounters::open()
+{
+    return source_;
+}
+
+void PerfCounters::close()
+{
+}
+
+void PerfCounters::start()
+{
+}
+
+unsigned int PerfCounters::stop(unsigned long long values[perfCountersNumber])
+{
+    for (int idx = 0; idx < perfCountersNumber; ++idx)
+        values[idx] = 0;
+    return 0;
+}
+
+void PerfCounters::readRusage(unsigned long long values[perfCountersNumber]) const
+{
+    for (int idx = 0; idx < perfCountersNumber; ++idx)
+        values[idx] = 0;
+}
+
+#endif // YUNIT_PERF_EVENTS
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+static bool perfCountersEnabled = false;
+
+void setPerfCounters(bool enable)
+{
+    perfCountersEnabled = enable;
+}
+
+struct PerfCountersExtension : TestExtension
+{
+    virtual bool parseOption(const char *arg)
+    {
+        if (0 != ::strcmp(arg, "--perf-counters"))
+            return false;
+        setPerfCounters(true);
+        return true;
+    }
+
+    virtual bool startExecution()
+    {
+        return perfCountersEnabled;
+    }
+
+    virtual void* openWorker()
+    {
+        PerfCounters *counters = new PerfCounters;
+        counters->open();
+        return counters;
+    }
+
+    virtual void closeWorker(void *worker)
+    {
+        delete static_cast<PerfCounters*>(worker);
+    }
+
+    virtual void startBody(void *worker, TestCase * /*test*/)
+    {
+        static_cast<PerfCounters*>(worker)->start();
+    }
+
+    virtual void stopBody(void *worker, TestCase *test)
+    {
+        test->stats_.perfAvailable_ = static_cast<PerfCounters*>(worker)->stop(test->stats_.perf_);
+    }
+};
+
+static PerfCountersExtension perfCountersExtension;
+
+YUNIT_NS_END
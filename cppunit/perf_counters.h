@@ -0,0 +1,71 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// @file perf_counters.h
+//
+// Performance counters of calling thread: cycles, instructions, cache misses, branch misses, page faults and
+// CPU time. Linux implementation uses perf_event_open group and degrades to software perf events and then to
+// getrusage, when hardware counters are not accessible.
+//
+// Link perf_counters.cpp (CMake object library 'yunit_perf_counters') into test program to measure test bodies
+// with '--perf-counters' option; results are stored in TestCase::stats_ and written into 'perf' field of results
+// file (see test_results.h).
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#ifndef _PERF_COUNTERS_YUNIT_HEADER_
+#define _PERF_COUNTERS_YUNIT_HEADER_
+
+#include "tests.h"
+
+YUNIT_NS_BEGIN
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief Counters group of the thread, which has called 'open'. Object must be used by this thread only.
+class PerfCounters
+{
+public:
+    enum Source
+    {
+        sourceNone,     ///< not opened or not supported
+        sourceHardware, ///< hardware perf events (some of them may be unavailable)
+        sourceSoftware, ///< software perf events: task clock and page faults
+        sourceRusage    ///< getrusage(RUSAGE_THREAD): CPU time and page faults
+    };
+
+    PerfCounters();
+    ~PerfCounters();
+
+    /// @return Source of counters, which will be used
+    Source open();
+    void close();
+
+    Source source() const
+    {
+        return source_;
+    }
+
+    void start();
+
+    /// @param[out] values Counters difference since 'start', indexed by PerfCounter
+    /// @return Bit mask of available counters: (1 << PerfCounter)
+    unsigned int stop(unsigned long long values[perfCountersNumber]);
+
+    static const char* name(PerfCounter counter);
+
+private:
+    PerfCounters(const PerfCounters&);
+    PerfCounters& operator=(const PerfCounters&);
+
+    bool openGroup(bool hardware);
+    void readRusage(unsigned long long values[perfCountersNumber]) const;
+
+    Source source_;
+    int fds_[perfCountersNumber];             ///< -1 for unavailable counter; the first opened one is leader
+    int leader_;
+    unsigned int available_;
+    unsigned long long startValues_[perfCountersNumber]; ///< getrusage values at 'start'
+};
+
+/// @brief Measure 'testBody' of every test by counters of its worker thread ('--perf-counters')
+void setPerfCounters(bool enable);
+
+YUNIT_NS_END
+
+#endif // _PERF_COUNTERS_YUNIT_HEADER_
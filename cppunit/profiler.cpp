@@ -0,0 +1,446 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// profiler.cpp
+//
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "profiler.h"
+#include "signal_safe.h"
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <string>
+
+#if defined(__linux__) && defined(__GLIBC__)
+#  define YUNIT_PROFILER
+#  include <cxxabi.h>
+#  include <dlfcn.h>
+#  include <execinfo.h>
+#  include <signal.h>
+#  include <sys/syscall.h>
+#  include <time.h>
+#  include <unistd.h>
+#endif
+
+YUNIT_NS_BEGIN
+
+#ifdef YUNIT_PROFILER
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// buffer of current thread; handler ignores signals of threads without armed profiler
+static __thread ThreadProfiler::Buffer *threadBuffer __attribute__ ((tls_model("initial-exec")));
+
+static unsigned long long threadCpuTimeNs()
+{
+    struct timespec ts;
+    ::clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return static_cast<unsigned long long>(ts.tv_sec) * 1000000000ULL + ts.tv_nsec;
+}
+
+static void onProfilingSignal(int /*signal*/)
+{
+    ThreadProfiler::Buffer *buffer = threadBuffer;
+    if (NULL == buffer)
+        return;
+
+    const int savedErrno = errno;
+    const unsigned long long startTime = threadCpuTimeNs();
+
+    const unsigned int idx = buffer->samples_;
+    if (idx < ThreadProfiler::maxSamples)
+    {
+        buffer->depths_[idx] = static_cast<unsigned char>(::backtrace(buffer->stacks_[idx],
+                                                                      ThreadProfiler::maxStackDepth));
+        buffer->samples_ = idx + 1;
+    }
+    else
+        ++buffer->dropped_;
+
+    buffer->overheadNs_ += threadCpuTimeNs() - startTime;
+    errno = savedErrno;
+}
+
+static bool installSignalHandler()
+{
+    preloadUnwinder();
+
+    struct sigaction action;
+    ::memset(&action, 0, sizeof(action));
+    action.sa_handler = onProfilingSignal;
+    action.sa_flags = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    return 0 == ::sigaction(SIGPROF, &action, NULL);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+ThreadProfiler::ThreadProfiler()
+: buffer_(NULL)
+, timer_(NULL)
+, opened_(false)
+, intervalUs_(defaultIntervalUs)
+{
+}
+
+ThreadProfiler::~ThreadProfiler()
+{
+    close();
+}
+
+bool ThreadProfiler::open(unsigned int intervalUs)
+{
+    close();
+
+    static const bool handlerInstalled = installSignalHandler();
+    if (!handlerInstalled)
+        return false;
+
+    // signal is delivered to the thread, whose CPU time is measured
+    struct sigevent event;
+    ::memset(&event, 0, sizeof(event));
+    event.sigev_notify = SIGEV_THREAD_ID;
+    event.sigev_signo = SIGPROF;
+    event._sigev_un._tid = static_cast<pid_t>(::syscall(SYS_gettid));
+
+    timer_t timer;
+    if (0 != ::timer_create(CLOCK_THREAD_CPUTIME_ID, &event, &timer))
+        return false;
+
+    static_assert(sizeof(timer_t) <= sizeof(void*), "timer_t is stored as void*");
+    ::memcpy(&timer_, &timer, sizeof(timer));
+
+    buffer_ = static_cast<Buffer*>(::calloc(1, sizeof(Buffer)));
+    if (NULL == buffer_)
+    {
+        ::timer_delete(timer);
+        return false;
+    }
+
+    intervalUs_ = (0 == intervalUs) ? static_cast<unsigned int>(defaultIntervalUs) : intervalUs;
+    opened_ = true;
+    return true;
+}
+
+void ThreadProfiler::close()
+{
+    if (!opened_)
+        return;
+
+    stop();
+
+    timer_t timer;
+    ::memcpy(&timer, &timer_, sizeof(timer));
+    ::timer_delete(timer);
+
+    ::free(buffer_);
+    buffer_ = NULL;
+    opened_ = false;
+}
+
+void ThreadProfiler::start()
+{
+    if (!opened_)
+        return;
+
+    buffer_->samples_ = 0;
+    buffer_->dropped_ = 0;
+    buffer_->overheadNs_ = 0;
+    threadBuffer = buffer_;
+
+    timer_t timer;
+    ::memcpy(&timer, &timer_, sizeof(timer));
+
+    struct itimerspec spec;
+    spec.it_interval.tv_sec = intervalUs_ / 1000000;
+    spec.it_interval.tv_nsec = (intervalUs_ % 1000000) * 1000;
+    spec.it_value = spec.it_interval;
+    ::timer_settime(timer, 0, &spec, NULL);
+}
+
+void ThreadProfiler::stop()
+{
+    if (!opened_)
+        return;
+
+    timer_t timer;
+    ::memcpy(&timer, &timer_, sizeof(timer));
+
+    struct itimerspec spec;
+    ::memset(&spec, 0, sizeof(spec));
+    ::timer_settime(timer, 0, &spec, NULL);
+
+    threadBuffer = NULL;
+}
+
+unsigned int ThreadProfiler::samples() const
+{
+    return opened_ ? buffer_->samples_ : 0;
+}
+
+unsigned int ThreadProfiler::droppedSamples() const
+{
+    return opened_ ? buffer_->dropped_ : 0;
+}
+
+unsigned long long ThreadProfiler::overheadNs() const
+{
+    return opened_ ? buffer_->overheadNs_ : 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+static std::string symbolName(void *address)
+{
+    Dl_info info;
+    if (0 == ::dladdr(address, &info) || NULL == info.dli_fname)
+    {
+        char buf[32];
+        TS_SNPRINTF(buf, sizeof(buf), "%p", address);
+        buf[sizeof(buf) - 1] = '\0';
+        return buf;
+    }
+
+    std::string res;
+    if (NULL != info.dli_sname)
+    {
+        int status = -1;
+        char *demangled = abi::__cxa_demangle(info.dli_sname, NULL, NULL, &status);
+        res = (0 == status && NULL != demangled) ? demangled : info.dli_sname;
+        ::free(demangled);
+    }
+    else
+    {
+        // static functions have no dynamic symbols, so module and offset are written (use addr2line for them)
+        const char *module = ::strrchr(info.dli_fname, '/');
+        char buf[32];
+        TS_SNPRINTF(buf, sizeof(buf), "+0x%lx", static_cast<unsigned long>(static_cast<char*>(address)
+                                                                           - static_cast<char*>(info.dli_fbase)));
+        buf[sizeof(buf) - 1] = '\0';
+        res = (NULL != module) ? module + 1 : info.dli_fname;
+        res += buf;
+    }
+
+    // ';' separates frames in folded format
+    for (size_t idx = 0, size = res.size(); idx < size; ++idx)
+        if (';' == res[idx])
+            res[idx] = ':';
+    return res;
+}
+
+void ThreadProfiler::writeFolded(FILE *file, const char *root) const
+{
+    if (!opened_)
+        return;
+
+    enum {skippedFrames = 2}; // signal handler and signal trampoline
+
+    typedef std::map<void*, std::string> Symbols;
+    typedef std::map<std::string, unsigned int> Stacks;
+    Symbols symbols;
+    Stacks stacks;
+
+    for (unsigned int sampleIdx = 0, samplesNumber = buffer_->samples_; sampleIdx < samplesNumber; ++sampleIdx)
+    {
+        std::string stack(root);
+        void * const *frames = buffer_->stacks_[sampleIdx];
+
+        for (int frameIdx = buffer_->depths_[sampleIdx] - 1; frameIdx >= skippedFrames; --frameIdx)
+        {
+            // return addresses point after call instruction, interrupted instruction address is exact
+            void *address = (skippedFrames == frameIdx) ? frames[frameIdx]
+                                                        : static_cast<char*>(frames[frameIdx]) - 1;
+
+            Symbols::iterator it = symbols.find(address);
+            if (symbols.end() == it)
+                it = symbols.insert(std::make_pair(address, symbolName(address))).first;
+
+            stack += ';';
+            stack += it->second;
+        }
+
+        ++stacks[stack];
+    }
+
+    for (Stacks::const_iterator it = stacks.begin(), endIt = stacks.end(); it != endIt; ++it)
+        ::fprintf(file, "%s %u\n", it->first.c_str(), it->second);
+}
+
+#else // YUNIT_PROFILER
+
+ThreadProfiler::ThreadProfiler()
+: buffer_(NULL)
+, timer_(NULL)
+, opened_(false)
+, intervalUs_(defaultIntervalUs)
+{
+}
+
+ThreadProfiler::~ThreadProfiler()
+{
+}
+
+bool ThreadProfiler::open(unsigned int /*intervalUs*/)
+{
+    return false;
+}
+
+void ThreadProfiler::close()
+{
+}
+
+void ThreadProfiler::start()
+{
+}
+
+void ThreadProfiler::stop()
+{
+}
+
+unsigned int ThreadProfiler::samples() const
+{
+    return 0;
+}
+
+unsigned int ThreadProfiler::droppedSamples() const
+{
+    return 0;
+}
+
+unsigned long long ThreadProfiler::overheadNs() const
+{
+    return 0;
+}
+
+void ThreadProfiler::writeFolded(FILE * /*file*/, const char * /*root*/) const
+{
+}
+
+#endif // YUNIT_PROFILER
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+const char *defaultProfileFile = "yunit.folded";
+
+static std::string profileFilter;
+static std::string profileFile(defaultProfileFile);
+
+void setProfileFilter(const char *filter)
+{
+    profileFilter = (NULL != filter) ? filter : "";
+}
+
+void setProfileFile(const char *path)
+{
+    profileFile = (NULL != path) ? path : defaultProfileFile;
+}
+
+struct ProfilerExtension : TestExtension
+{
+    struct Worker
+    {
+        ThreadProfiler profiler_;
+        bool profiled_;
+        unsigned long long bodyStartTime_;
+    };
+
+    ProfilerExtension()
+    : file_(NULL)
+    {
+    }
+
+    virtual bool parseOption(const char *arg)
+    {
+        const char *value;
+        if (NULL != (value = optionValue(arg, "--profile=")))
+            setProfileFilter(value);
+        else if (NULL != (value = optionValue(arg, "--profile-output=")))
+            setProfileFile(value);
+        else
+            return false;
+        return true;
+    }
+
+    virtual bool startExecution()
+    {
+        if (profileFilter.empty())
+            return false;
+
+        file_ = ::fopen(profileFile.c_str(), "w");
+        if (NULL == file_)
+        {
+            ::fprintf(stderr, "Can not open profile file '%s'\n", profileFile.c_str());
+            return false;
+        }
+
+        tests_ = 0;
+        samples_ = 0;
+        dropped_ = 0;
+        overheadNs_ = 0;
+        profiledTimeNs_ = 0;
+        return true;
+    }
+
+    virtual void finishExecution()
+    {
+        ::fclose(file_);
+        file_ = NULL;
+        ::fprintf(stderr, "Profile of %u tests has been written to '%s': %llu samples (%llu dropped), "
+                          "profiler overhead %.3f ms (%.2f%% of profiled time)\n",
+                  tests_, profileFile.c_str(), samples_, dropped_, overheadNs_ / 1e6,
+                  0 == profiledTimeNs_ ? 0. : 100. * overheadNs_ / profiledTimeNs_);
+    }
+
+    virtual void* openWorker()
+    {
+        Worker *worker = new Worker;
+        worker->profiler_.open();
+        worker->profiled_ = false;
+        return worker;
+    }
+
+    virtual void closeWorker(void *worker)
+    {
+        delete static_cast<Worker*>(worker);
+    }
+
+    virtual void startBody(void *ctx, TestCase *test)
+    {
+        Worker *worker = static_cast<Worker*>(ctx);
+        worker->profiled_ = "*" == profileFilter || NULL != ::strstr(test->name_, profileFilter.c_str());
+        if (!worker->profiled_)
+            return;
+
+        worker->bodyStartTime_ = currentTimeNs();
+        worker->profiler_.start();
+    }
+
+    virtual void stopBody(void *ctx, TestCase *test)
+    {
+        Worker *worker = static_cast<Worker*>(ctx);
+        if (!worker->profiled_)
+            return;
+
+        const ThreadProfiler &profiler = worker->profiler_;
+        worker->profiler_.stop();
+        test->stats_.profileSamples_ = profiler.samples();
+        test->stats_.profileOverheadNs_ = profiler.overheadNs();
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        profiler.writeFolded(file_, test->name_);
+        ++tests_;
+        samples_ += profiler.samples();
+        dropped_ += profiler.droppedSamples();
+        overheadNs_ += profiler.overheadNs();
+        profiledTimeNs_ += currentTimeNs() - worker->bodyStartTime_;
+    }
+
+    std::mutex mutex_;
+    FILE *file_;
+    unsigned int tests_;
+    unsigned long long samples_;
+    unsigned long long dropped_;
+    unsigned long long overheadNs_;
+    unsigned long long profiledTimeNs_;
+};
+
+static ProfilerExtension profilerExtension;
+
+YUNIT_NS_END
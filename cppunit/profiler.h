@@ -0,0 +1,84 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// @file profiler.h
+//
+// Sampling profiler of test bodies (test program '--profile=<filter>' option). Linux implementation samples
+// CPU time of calling thread with SIGPROF, delivered by per-thread POSIX timer, and unwinds stack with
+// 'backtrace'. Stacks are written in folded format, ready for flame graph tools:
+// @code
+// <test name>;<outermost function>;...;<innermost function> <number of samples>
+// @endcode
+// Functions are named with dladdr, so link test program with '-rdynamic' to see names of its own functions.
+//
+// Link profiler.cpp (CMake object library 'yunit_profiler') into test program to use '--profile' options.
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#ifndef _PROFILER_YUNIT_HEADER_
+#define _PROFILER_YUNIT_HEADER_
+
+#include "tests.h"
+#include <cstdio>
+
+YUNIT_NS_BEGIN
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief Sampler of the thread, which has called 'open'. Object must be used by this thread only.
+class ThreadProfiler
+{
+public:
+    enum
+    {
+        defaultIntervalUs = 1000,
+        maxStackDepth = 64,
+        maxSamples = 8192   ///< samples of one 'start'...'stop' interval, extra ones are dropped
+    };
+
+    ThreadProfiler();
+    ~ThreadProfiler();
+
+    /// @return false if sampling is not supported or timer can not be created
+    bool open(unsigned int intervalUs = defaultIntervalUs);
+    void close();
+
+    /// @brief Arm timer; samples of previous interval are discarded
+    void start();
+    void stop();
+
+    unsigned int samples() const;
+    unsigned int droppedSamples() const;
+
+    /// @brief Time, spent by signal handler (stack unwinding and so on) during last interval
+    unsigned long long overheadNs() const;
+
+    /// @brief Append folded stacks of last interval to 'file', 'root' is added as the outermost frame
+    void writeFolded(FILE *file, const char *root) const;
+
+    /// @brief Profiler state of one thread, it is accessed from signal handler
+    struct Buffer
+    {
+        volatile unsigned int samples_;
+        volatile unsigned int dropped_;
+        volatile unsigned long long overheadNs_;
+        unsigned char depths_[maxSamples];
+        void *stacks_[maxSamples][maxStackDepth];
+    };
+
+private:
+    ThreadProfiler(const ThreadProfiler&);
+    ThreadProfiler& operator=(const ThreadProfiler&);
+
+    Buffer *buffer_;
+    void *timer_;       ///< timer_t of POSIX timer
+    bool opened_;
+    unsigned int intervalUs_;
+};
+
+extern const char *defaultProfileFile;
+
+/// @brief Sample stacks of 'testBody' of tests, whose names contain 'filter' ("*" matches all tests), and write
+/// them into profile file in folded format with test name as the outermost frame. Number of samples and
+/// profiler overhead are printed to stderr after execution. NULL 'filter' disables profiling.
+void setProfileFilter(const char *filter);
+void setProfileFile(const char *path);
+
+YUNIT_NS_END
+
+#endif // _PROFILER_YUNIT_HEADER_
@@ -0,0 +1,203 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// property.cpp
+//
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "property.h"
+#include <atomic>
+#include <cstdio>
+#include <thread>
+
+YUNIT_NS_BEGIN
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+static std::atomic<unsigned int> casesNumber(propertyDefaultCases);
+static std::atomic<unsigned int> threadsNumber(1);
+static std::atomic<bool> seedIsSet(false);
+static std::atomic<unsigned long long> seedValue(0);
+
+void setPropertyCases(unsigned int cases)
+{
+    casesNumber = (0 == cases) ? static_cast<unsigned int>(propertyDefaultCases) : cases;
+}
+
+unsigned int propertyCases()
+{
+    return casesNumber;
+}
+
+void setPropertySeed(unsigned long long seed)
+{
+    seedValue = seed;
+    seedIsSet = true;
+}
+
+void resetPropertySeed()
+{
+    seedIsSet = false;
+}
+
+unsigned long long propertySeed()
+{
+    // one seed for all properties of the run, so it is enough to reproduce any of their failures
+    static const unsigned long long clockSeed = currentTimeNs();
+    return seedIsSet ? seedValue.load() : clockSeed;
+}
+
+void setPropertyThreads(unsigned int threads)
+{
+    threadsNumber = (0 == threads) ? 1 : threads;
+}
+
+unsigned int propertyThreads()
+{
+    return threadsNumber;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+static unsigned long long splitMix64(unsigned long long &state)
+{
+    unsigned long long value = (state += 0x9E3779B97F4A7C15ULL);
+    value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    value = (value ^ (value >> 27)) * 0x94D049BB133111EBULL;
+    return value ^ (value >> 31);
+}
+
+static unsigned long long rotateLeft(unsigned long long value, int bits)
+{
+    return (value << bits) | (value >> (64 - bits));
+}
+
+Random::Random(unsigned long long seed)
+{
+    for (int idx = 0; idx < 4; ++idx)
+        state_[idx] = splitMix64(seed);
+}
+
+unsigned long long Random::next()
+{
+    const unsigned long long result = rotateLeft(state_[1] * 5, 7) * 9;
+    const unsigned long long shifted = state_[1] << 17;
+
+    state_[2] ^= state_[0];
+    state_[3] ^= state_[1];
+    state_[1] ^= state_[2];
+    state_[0] ^= state_[3];
+    state_[2] ^= shifted;
+    state_[3] = rotateLeft(state_[3], 45);
+
+    return result;
+}
+
+unsigned long long Random::below(unsigned long long bound)
+{
+    // modulo bias is negligible for sizes of generated values
+    return (0 == bound) ? 0 : next() % bound;
+}
+
+double Random::uniform()
+{
+    return (next() >> 11) * (1.0 / (1ULL << 53));
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+struct CaseSearch
+{
+    unsigned int cases_;
+    unsigned int threads_;
+    bool (*checkCase_)(void *ctx, unsigned int idx);
+    void *ctx_;
+    std::atomic<unsigned int> failedCase_;
+
+    // thread checks cases in ascending order and skips ones after already failed case, so all cases before
+    // found one are checked, and result is the same for any number of threads
+    void work(unsigned int firstCase)
+    {
+        for (unsigned int idx = firstCase; idx < failedCase_.load(std::memory_order_relaxed); idx += threads_)
+        {
+            if (checkCase_(ctx_, idx))
+                continue;
+
+            unsigned int failed = failedCase_.load();
+            while (idx < failed && !failedCase_.compare_exchange_weak(failed, idx))
+                ;
+            return;
+        }
+    }
+};
+
+unsigned int findFailedCase(unsigned int cases, unsigned int threads, bool (*checkCase)(void *ctx, unsigned int idx),
+                            void *ctx)
+{
+    CaseSearch search;
+    search.cases_ = cases;
+    search.threads_ = (threads > cases) ? cases : threads;
+    search.checkCase_ = checkCase;
+    search.ctx_ = ctx;
+    search.failedCase_ = cases;
+
+    if (search.threads_ <= 1)
+    {
+        search.threads_ = 1;
+        search.work(0);
+        return search.failedCase_;
+    }
+
+    std::vector<std::thread> threadPool;
+    threadPool.reserve(search.threads_ - 1);
+    for (unsigned int threadIdx = 1; threadIdx < search.threads_; ++threadIdx)
+        threadPool.push_back(std::thread(&CaseSearch::work, &search, threadIdx));
+
+    search.work(0);
+    for (size_t idx = 0; idx < threadPool.size(); ++idx)
+        threadPool[idx].join();
+
+    return search.failedCase_;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void throwPropertyFailure(const char *prefix, unsigned long long seed, unsigned int failedCase, unsigned int shrinks,
+                          const std::string &counterexample, const std::string &error)
+{
+    enum {headerSize = 512};
+    char header[headerSize];
+    TS_SNPRINTF(header, headerSize, "%s is falsified by case %u (reproduce with --property-seed=%llu), "
+                "counterexample after %u shrinks: ", prefix, failedCase, seed, shrinks);
+    header[headerSize - 1] = '\0';
+
+    std::string msg(header);
+    msg += counterexample;
+    if (!error.empty())
+    {
+        msg += "\n    ";
+        msg += error;
+    }
+
+    throw std::logic_error(msg);
+}
+
+void printSigned(long long value, std::string &out)
+{
+    char buf[32];
+    TS_SNPRINTF(buf, sizeof(buf), "%lld", value);
+    buf[sizeof(buf) - 1] = '\0';
+    out += buf;
+}
+
+void printUnsigned(unsigned long long value, std::string &out)
+{
+    char buf[32];
+    TS_SNPRINTF(buf, sizeof(buf), "%llu", value);
+    buf[sizeof(buf) - 1] = '\0';
+    out += buf;
+}
+
+void printDouble(double value, std::string &out)
+{
+    char buf[32];
+    TS_SNPRINTF(buf, sizeof(buf), "%.17g", value);
+    buf[sizeof(buf) - 1] = '\0';
+    out += buf;
+}
+
+YUNIT_NS_END
@@ -0,0 +1,500 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// @file property.h
+//
+// Property-based tests: property is a predicate, which must hold for all values of its arguments. Arguments
+// are drawn by generators from seeded PRNG, so every run checks thousands of new cases, and failed case is
+// shrunk to minimal counterexample, which is reported with seed of the run:
+// @code
+// PROPERTY(reverseTwiceIsIdentity, Gen<std::vector<int> >)(const std::vector<int> &values)
+// {
+//     std::vector<int> copy(values.rbegin(), values.rend());
+//     std::reverse(copy.begin(), copy.end());
+//     return copy == values;
+// }
+// @endcode
+// Property arguments are taken by constant reference, property fails if it returns false or throws exception
+// (so asserts may be used inside it). Generator of type T is any class with members:
+// @code
+// typedef T Value;
+// static T generate(Random &random, size_t size);                  // size grows from 1 to propertyMaxSize
+// static void shrink(const T &value, std::vector<T> &candidates); // simpler values, the simplest first
+// static void print(const T &value, std::string &out);
+// @endcode
+// Gen<T> is defined for arithmetic types, std::string and std::vector of them.
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#ifndef _PROPERTY_YUNIT_HEADER_
+#define _PROPERTY_YUNIT_HEADER_
+
+#include "tests.h"
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <vector>
+
+YUNIT_NS_BEGIN
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#define PROPERTY(name, ...)\
+    static YUNIT_NS_PREF(Property)<__VA_ARGS__>::Function Property__##name;\
+    struct TestCase__##name : YUNIT_NS_PREF(Test)\
+    {\
+        virtual void testBody()\
+        {\
+            YUNIT_NS_PREF(Property)<__VA_ARGS__>::check(ASSERT_MESSAGE_PREFIX(__FILE__, __LINE__) "property '" #name "'",\
+                                                        &Property__##name);\
+        }\
+    };\
+    registerTest(name, __FILE__, __LINE__)\
+    static bool Property__##name
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+enum
+{
+    propertyDefaultCases = 1000,
+    propertyMaxSize = 100,      ///< size of the last cases: length of containers, magnitude of numbers
+    propertyMaxShrinks = 1000   ///< shrinking stops after so many successful steps
+};
+
+/// @brief Number of cases of every property ('--property-cases=<n>')
+void setPropertyCases(unsigned int cases);
+unsigned int propertyCases();
+
+/// @brief Seed of all properties ('--property-seed=<n>'), run with seed of failed run reproduces its cases.
+/// Seed is taken from clock, if it has not been set.
+void setPropertySeed(unsigned long long seed);
+unsigned long long propertySeed();
+
+/// @brief Unset seed of 'setPropertySeed', so clock seed of the run is used again
+void resetPropertySeed();
+
+/// @brief Check cases in 'threads' threads ('--property-threads=<n>'), properties must be pure to use it.
+/// Case values depend on seed and case index only, so failed case and its counterexample do not depend on
+/// number of threads.
+void setPropertyThreads(unsigned int threads);
+unsigned int propertyThreads();
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief Fast PRNG (xoshiro256**), seeded with splitmix64
+class Random
+{
+public:
+    explicit Random(unsigned long long seed);
+
+    unsigned long long next();
+
+    /// @return value in [0, bound)
+    unsigned long long below(unsigned long long bound);
+
+    /// @return value in [0, 1)
+    double uniform();
+
+private:
+    unsigned long long state_[4];
+};
+
+/// @brief Execute 'checkCase(ctx, idx)' for indices [0, cases) in 'threads' threads
+/// @return the smallest index, for which 'checkCase' has returned false, or 'cases' if all cases hold
+unsigned int findFailedCase(unsigned int cases, unsigned int threads, bool (*checkCase)(void *ctx, unsigned int idx),
+                            void *ctx);
+
+void throwPropertyFailure(const char *prefix, unsigned long long seed, unsigned int failedCase, unsigned int shrinks,
+                          const std::string &counterexample, const std::string &error);
+
+void printSigned(long long value, std::string &out);
+void printUnsigned(unsigned long long value, std::string &out);
+void printDouble(double value, std::string &out);
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template<typename T, typename Enable = void>
+struct Gen;
+
+template<typename T>
+struct Gen<T, typename std::enable_if<std::is_integral<T>::value>::type>
+{
+    typedef T Value;
+
+    static T generate(Random &random, size_t size)
+    {
+        // boundary values are rare in uniform distribution, but they break code often
+        switch (random.below(32))
+        {
+        case 0:
+            return std::numeric_limits<T>::min();
+        case 1:
+            return std::numeric_limits<T>::max();
+        case 2:
+            return static_cast<T>(random.next());
+        }
+
+        unsigned long long magnitude = random.below(size + 1);
+        if (magnitude > static_cast<unsigned long long>(std::numeric_limits<T>::max()))
+            magnitude = static_cast<unsigned long long>(std::numeric_limits<T>::max());
+
+        const T value = static_cast<T>(magnitude);
+        return (std::numeric_limits<T>::is_signed && random.below(2)) ? static_cast<T>(T(0) - value) : value;
+    }
+
+    static void shrink(const T &value, std::vector<T> &candidates)
+    {
+        if (T(0) == value)
+            return;
+
+        candidates.push_back(T(0));
+        if (T(value / 2) != T(0))
+            candidates.push_back(T(value / 2));
+
+        const T closer = (value > T(0)) ? T(value - 1) : T(value + 1);
+        if (T(0) != closer && T(value / 2) != closer)
+            candidates.push_back(closer);
+    }
+
+    static void print(const T &value, std::string &out)
+    {
+        if (std::numeric_limits<T>::is_signed)
+            printSigned(static_cast<long long>(value), out);
+        else
+            printUnsigned(static_cast<unsigned long long>(value), out);
+    }
+};
+
+template<>
+struct Gen<bool>
+{
+    typedef bool Value;
+
+    static bool generate(Random &random, size_t /*size*/)
+    {
+        return 0 != random.below(2);
+    }
+
+    static void shrink(const bool &value, std::vector<bool> &candidates)
+    {
+        if (value)
+            candidates.push_back(false);
+    }
+
+    static void print(const bool &value, std::string &out)
+    {
+        out += value ? "true" : "false";
+    }
+};
+
+template<typename T>
+struct Gen<T, typename std::enable_if<std::is_floating_point<T>::value>::type>
+{
+    typedef T Value;
+
+    static T generate(Random &random, size_t size)
+    {
+        if (0 == random.below(16))
+            return T(0);
+        return static_cast<T>((random.uniform() * 2 - 1) * size);
+    }
+
+    static void shrink(const T &value, std::vector<T> &candidates)
+    {
+        if (T(0) == value)
+            return;
+
+        candidates.push_back(T(0));
+        const T truncated = static_cast<T>(value < 0 ? ::ceil(value) : ::floor(value));
+        if (truncated != value && T(0) != truncated)
+            candidates.push_back(truncated);
+        if (::fabs(value) >= 1)
+            candidates.push_back(value / 2);
+    }
+
+    static void print(const T &value, std::string &out)
+    {
+        printDouble(static_cast<double>(value), out);
+    }
+};
+
+/// @brief Shrink sequence: remove all, halves and single elements, then shrink single elements
+template<typename Sequence, typename ElementGen>
+void shrinkSequence(const Sequence &value, std::vector<Sequence> &candidates)
+{
+    const size_t size = value.size();
+    if (0 == size)
+        return;
+
+    candidates.push_back(Sequence());
+    if (size > 1)
+    {
+        candidates.push_back(Sequence(value.begin(), value.begin() + size / 2));
+        candidates.push_back(Sequence(value.begin() + size / 2, value.end()));
+    }
+
+    for (size_t idx = 0; idx < size && size > 1; ++idx)
+    {
+        candidates.push_back(value);
+        candidates.back().erase(candidates.back().begin() + idx);
+    }
+
+    std::vector<typename ElementGen::Value> elements;
+    for (size_t idx = 0; idx < size; ++idx)
+    {
+        elements.clear();
+        ElementGen::shrink(value[idx], elements);
+        for (size_t elementIdx = 0; elementIdx < elements.size(); ++elementIdx)
+        {
+            candidates.push_back(value);
+            candidates.back()[idx] = elements[elementIdx];
+        }
+    }
+}
+
+/// @brief Printable ASCII strings
+template<>
+struct Gen<std::string>
+{
+    typedef std::string Value;
+
+    struct Char
+    {
+        typedef char Value;
+
+        static void shrink(const char &value, std::vector<char> &candidates)
+        {
+            if ('a' != value)
+                candidates.push_back('a');
+        }
+    };
+
+    static std::string generate(Random &random, size_t size)
+    {
+        std::string value(static_cast<size_t>(random.below(size + 1)), ' ');
+        for (size_t idx = 0; idx < value.size(); ++idx)
+            value[idx] = static_cast<char>(' ' + random.below('~' - ' ' + 1));
+        return value;
+    }
+
+    static void shrink(const std::string &value, std::vector<std::string> &candidates)
+    {
+        shrinkSequence<std::string, Char>(value, candidates);
+    }
+
+    static void print(const std::string &value, std::string &out)
+    {
+        out += '"';
+        for (size_t idx = 0; idx < value.size(); ++idx)
+        {
+            if ('"' == value[idx] || '\\' == value[idx])
+                out += '\\';
+            out += value[idx];
+        }
+        out += '"';
+    }
+};
+
+template<typename T>
+struct Gen<std::vector<T> >
+{
+    typedef std::vector<T> Value;
+
+    static Value generate(Random &random, size_t size)
+    {
+        Value value(static_cast<size_t>(random.below(size + 1)));
+        for (size_t idx = 0; idx < value.size(); ++idx)
+            value[idx] = Gen<T>::generate(random, size);
+        return value;
+    }
+
+    static void shrink(const Value &value, std::vector<Value> &candidates)
+    {
+        shrinkSequence<Value, Gen<T> >(value, candidates);
+    }
+
+    static void print(const Value &value, std::string &out)
+    {
+        out += '[';
+        for (size_t idx = 0; idx < value.size(); ++idx)
+        {
+            if (idx > 0)
+                out += ", ";
+            Gen<T>::print(value[idx], out);
+        }
+        out += ']';
+    }
+};
+
+/// @brief Integers of [Min, Max] range, they are shrunk to Min
+template<typename T, T Min, T Max>
+struct GenRange
+{
+    typedef T Value;
+
+    static T generate(Random &random, size_t /*size*/)
+    {
+        const unsigned long long width = static_cast<unsigned long long>(Max) - static_cast<unsigned long long>(Min);
+        const unsigned long long offset = (width == std::numeric_limits<unsigned long long>::max())
+                                        ? random.next() : random.below(width + 1);
+        return static_cast<T>(static_cast<unsigned long long>(Min) + offset);
+    }
+
+    static void shrink(const T &value, std::vector<T> &candidates)
+    {
+        if (Min == value)
+            return;
+
+        candidates.push_back(Min);
+        const T middle = static_cast<T>(Min + (value - Min) / 2);
+        if (Min != middle)
+            candidates.push_back(middle);
+        if (Min != T(value - 1) && middle != T(value - 1))
+            candidates.push_back(T(value - 1));
+    }
+
+    static void print(const T &value, std::string &out)
+    {
+        Gen<T>::print(value, out);
+    }
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template<size_t... Idx>
+struct Indices
+{
+};
+
+template<size_t N, size_t... Idx>
+struct MakeIndices : MakeIndices<N - 1, N - 1, Idx...>
+{
+};
+
+template<size_t... Idx>
+struct MakeIndices<0, Idx...>
+{
+    typedef Indices<Idx...> Type;
+};
+
+/// @brief Check of property with arguments, produced by generators 'Gens'
+template<typename... Gens>
+struct Property
+{
+    typedef bool Function(const typename Gens::Value&...);
+    typedef std::tuple<typename Gens::Value...> Values;
+    typedef typename MakeIndices<sizeof...(Gens)>::Type AllIndices;
+    typedef std::integral_constant<size_t, sizeof...(Gens)> LastArgument;
+
+    /// @brief Throw std::logic_error with shrunk counterexample, if property fails for any of propertyCases()
+    static void check(const char *prefix, Function *function)
+    {
+        Context ctx = {function, propertySeed(), propertyCases()};
+
+        const unsigned int failedCase = findFailedCase(ctx.cases_, propertyThreads(), checkCase, &ctx);
+        if (failedCase >= ctx.cases_)
+            return;
+
+        Values values(generate(ctx, failedCase));
+        std::string error;
+        holds(function, values, error);
+
+        unsigned int shrinks = 0;
+        while (shrinks < propertyMaxShrinks && shrinkArgument(function, values, error, std::integral_constant<size_t, 0>()))
+            ++shrinks;
+
+        std::string counterexample;
+        print(values, counterexample, AllIndices());
+        throwPropertyFailure(prefix, ctx.seed_, failedCase, shrinks, counterexample, error);
+    }
+
+private:
+    struct Context
+    {
+        Function *function_;
+        unsigned long long seed_;
+        unsigned int cases_;
+    };
+
+    // values of case depend on seed and its index only, so cases are checked in any order and in any thread
+    static Values generate(const Context &ctx, unsigned int idx)
+    {
+        Random random(ctx.seed_ + idx * 0x9E3779B97F4A7C15ULL);
+        const size_t size = 1 + static_cast<size_t>(static_cast<unsigned long long>(idx) * propertyMaxSize / ctx.cases_);
+        return Values{Gens::generate(random, size)...}; // braced list is evaluated from left to right
+    }
+
+    static bool checkCase(void *ctx, unsigned int idx)
+    {
+        const Context &context = *static_cast<const Context*>(ctx);
+        std::string error;
+        return holds(context.function_, generate(context, idx), error);
+    }
+
+    static bool holds(Function *function, const Values &values, std::string &error)
+    {
+        try
+        {
+            if (call(function, values, AllIndices()))
+                return true;
+            error.clear();
+        }
+        catch (std::exception &ex)
+        {
+            error = ex.what();
+        }
+        catch (...)
+        {
+            error = "unknown C++ exception";
+        }
+        return false;
+    }
+
+    template<size_t... Idx>
+    static bool call(Function *function, const Values &values, Indices<Idx...>)
+    {
+        return function(std::get<Idx>(values)...);
+    }
+
+    /// @brief Replace argument 'K' or one of next ones with the first simpler value, which still fails property
+    template<size_t K>
+    static bool shrinkArgument(Function *function, Values &values, std::string &error, std::integral_constant<size_t, K>)
+    {
+        typedef typename std::tuple_element<K, std::tuple<Gens...> >::type Generator;
+
+        std::vector<typename Generator::Value> candidates;
+        Generator::shrink(std::get<K>(values), candidates);
+
+        for (size_t idx = 0; idx < candidates.size(); ++idx)
+        {
+            Values shrunk(values);
+            std::get<K>(shrunk) = candidates[idx];
+            if (!holds(function, shrunk, error))
+            {
+                values.swap(shrunk);
+                return true;
+            }
+        }
+
+        return shrinkArgument(function, values, error, std::integral_constant<size_t, K + 1>());
+    }
+
+    static bool shrinkArgument(Function * /*function*/, Values &/*values*/, std::string &/*error*/, LastArgument)
+    {
+        return false;
+    }
+
+    template<size_t... Idx>
+    static void print(const Values &values, std::string &out, Indices<Idx...>)
+    {
+        const int expand[] = {0, (printArgument<Idx>(values, out), 0)...};
+        (void)expand;
+    }
+
+    template<size_t K>
+    static void printArgument(const Values &values, std::string &out)
+    {
+        typedef typename std::tuple_element<K, std::tuple<Gens...> >::type Generator;
+        out += (0 == K) ? "(" : ", ";
+        Generator::print(std::get<K>(values), out);
+        if (sizeof...(Gens) - 1 == K)
+            out += ")";
+    }
+};
+
+YUNIT_NS_END
+
+#endif // _PROPERTY_YUNIT_HEADER_
@@ -0,0 +1,132 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// signal_safe.cpp
+//
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "signal_safe.h"
+#include <cstdio>
+#include <cstring>
+
+#ifdef __GLIBC__
+#  include <execinfo.h>
+#endif
+
+#ifdef YUNIT_STACK_UNWINDER
+#  include <errno.h>
+#  include <stdint.h>
+#  include <sys/uio.h>
+#  include <ucontext.h>
+#endif
+
+#ifndef _WIN32
+#  include <unistd.h>
+#endif
+
+YUNIT_NS_BEGIN
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void appendString(char *buf, size_t bufSize, const char *str)
+{
+    size_t len = ::strlen(buf);
+    while (len + 1 < bufSize && '\0' != *str)
+        buf[len++] = *str++;
+    buf[len] = '\0';
+}
+
+void appendNumber(char *buf, size_t bufSize, unsigned long long value)
+{
+    char digits[32];
+    int idx = sizeof(digits) - 1;
+    digits[idx] = '\0';
+    do
+    {
+        digits[--idx] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    }
+    while (0 != value && idx > 0);
+    appendString(buf, bufSize, digits + idx);
+}
+
+void appendHex(char *buf, size_t bufSize, unsigned long long value)
+{
+    size_t len = ::strlen(buf);
+    for (int shift = 60; shift >= 0 && len + 1 < bufSize; shift -= 4)
+        buf[len++] = "0123456789abcdef"[(value >> shift) & 0xf];
+    buf[len] = '\0';
+}
+
+void writeStderr(const char *str)
+{
+#ifdef _WIN32
+    ::fputs(str, stderr);
+#else
+    if (::write(STDERR_FILENO, str, ::strlen(str)) < 0)
+        return;
+#endif
+}
+
+void preloadUnwinder()
+{
+#ifdef __GLIBC__
+    void *frame;
+    ::backtrace(&frame, 1);
+#endif
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#ifdef YUNIT_STACK_UNWINDER
+
+static bool readMemory(uintptr_t address, void *data, size_t size)
+{
+    struct iovec local = {data, size};
+    struct iovec remote = {reinterpret_cast<void*>(address), size};
+    return static_cast<ssize_t>(size) == ::process_vm_readv(::getpid(), &local, 1, &remote, 1, 0);
+}
+
+int unwindStack(const void *context, void **frames, int maxFrames)
+{
+    const ucontext_t *ucontext = static_cast<const ucontext_t*>(context);
+#if defined(__x86_64__)
+    const uintptr_t pc = static_cast<uintptr_t>(ucontext->uc_mcontext.gregs[REG_RIP]);
+    uintptr_t fp = static_cast<uintptr_t>(ucontext->uc_mcontext.gregs[REG_RBP]);
+    uintptr_t sp = static_cast<uintptr_t>(ucontext->uc_mcontext.gregs[REG_RSP]);
+#elif defined(__i386__)
+    const uintptr_t pc = static_cast<uintptr_t>(ucontext->uc_mcontext.gregs[REG_EIP]);
+    uintptr_t fp = static_cast<uintptr_t>(ucontext->uc_mcontext.gregs[REG_EBP]);
+    uintptr_t sp = static_cast<uintptr_t>(ucontext->uc_mcontext.gregs[REG_ESP]);
+#elif defined(__aarch64__)
+    const uintptr_t pc = static_cast<uintptr_t>(ucontext->uc_mcontext.pc);
+    uintptr_t fp = static_cast<uintptr_t>(ucontext->uc_mcontext.regs[29]);
+    uintptr_t sp = static_cast<uintptr_t>(ucontext->uc_mcontext.sp);
+#else
+    (void)ucontext;
+    (void)frames;
+    (void)maxFrames;
+    return 0;
+#endif
+
+#if defined(__x86_64__) || defined(__i386__) || defined(__aarch64__)
+    const int savedErrno = errno;
+    int depth = 0;
+    if (0 != pc && depth < maxFrames)
+        frames[depth++] = reinterpret_cast<void*>(pc);
+
+    // frame record is saved frame pointer and return address, records of callers are higher on the stack
+    while (depth < maxFrames && 0 != fp && fp >= sp && 0 == fp % sizeof(uintptr_t))
+    {
+        uintptr_t record[2];
+        if (!readMemory(fp, record, sizeof(record)) || 0 == record[1])
+            break;
+        frames[depth++] = reinterpret_cast<void*>(record[1]);
+        sp = fp + sizeof(record);
+        fp = record[0];
+    }
+
+    errno = savedErrno;
+    return depth;
+#endif
+}
+
+#endif // YUNIT_STACK_UNWINDER
+
+YUNIT_NS_END
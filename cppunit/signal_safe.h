@@ -0,0 +1,45 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// @file signal_safe.h
+//
+// Internal helpers of crash and profiling signal handlers: formatting without snprintf, output without stdio
+// and call stack of interrupted code. All functions except preloadUnwinder are async-signal-safe.
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#ifndef _SIGNAL_SAFE_YUNIT_HEADER_
+#define _SIGNAL_SAFE_YUNIT_HEADER_
+
+#include "../yunit/yunit.h"
+#include <cstddef>
+
+#if defined(__linux__)
+#  define YUNIT_STACK_UNWINDER
+#endif
+
+YUNIT_NS_BEGIN
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief Append 'str' to zero-terminated 'buf', result is truncated to 'bufSize'
+void appendString(char *buf, size_t bufSize, const char *str);
+
+/// @brief Append decimal 'value' to zero-terminated 'buf'
+void appendNumber(char *buf, size_t bufSize, unsigned long long value);
+
+/// @brief Append 16 hexadecimal digits of 'value' to zero-terminated 'buf'
+void appendHex(char *buf, size_t bufSize, unsigned long long value);
+
+void writeStderr(const char *str);
+
+/// @brief Load unwinder library of 'backtrace' by its first call; it allocates memory and takes locks, so it
+/// must not happen inside signal handler or allocation counting
+void preloadUnwinder();
+
+#ifdef YUNIT_STACK_UNWINDER
+/// @brief Call stack of code, interrupted by signal with 'context' (ucontext_t), the first frame is interrupted
+/// instruction, so frames of signal handler are not included. Stack is walked by frame pointers, so walk stops at
+/// code, compiled without them; memory is read by process_vm_readv, so broken chain ends walk instead of fault.
+/// @return number of frames, written into 'frames'
+int unwindStack(const void *context, void **frames, int maxFrames);
+#endif
+
+YUNIT_NS_END
+
+#endif // _SIGNAL_SAFE_YUNIT_HEADER_
@@ -0,0 +1,267 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// test_history.cpp
+//
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "test_history.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <set>
+#include <sys/stat.h>
+
+YUNIT_NS_BEGIN
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+TestHistory::Record::Record()
+: runs_(0)
+, failures_(0)
+, flips_(0)
+, runsSinceFailure_(0)
+, durationNs_(0)
+, lastRunTime_(0)
+{
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+TestHistory::TestHistory()
+: missingSourceReported_(false)
+{
+}
+
+void TestHistory::setSourceRoot(const char *dir)
+{
+    sourceRoot_ = (NULL != dir) ? dir : "";
+}
+
+std::string TestHistory::sourcePath(const TestCase *test) const
+{
+    const char *fileName = test->fileName_;
+    const bool absolute = '/' == fileName[0] || '\\' == fileName[0] || (fileName[0] && ':' == fileName[1]);
+    if (absolute || sourceRoot_.empty())
+        return fileName;
+    return sourceRoot_ + '/' + fileName;
+}
+
+std::string TestHistory::key(const TestCase *test)
+{
+    std::string res(test->fileName_);
+    res += '\t';
+    res += test->name_;
+    return res;
+}
+
+bool TestHistory::load(const char *path)
+{
+    records_.clear();
+
+    FILE *file = ::fopen(path, "r");
+    if (NULL == file)
+        return false;
+
+    enum {lineSize = 4 * 1024};
+    char line[lineSize];
+    bool res = true;
+
+    while (::fgets(line, lineSize, file))
+    {
+        // <file>\t<name>\t<numbers...>
+        char *nameEnd = NULL;
+        char *fileEnd = ::strchr(line, '\t');
+        if (NULL != fileEnd)
+            nameEnd = ::strchr(fileEnd + 1, '\t');
+
+        if (NULL == nameEnd)
+        {
+            res = false;
+            break;
+        }
+
+        Record record;
+        unsigned long long lastRunTime = 0;
+        if (6 != ::sscanf(nameEnd + 1, "%u\t%u\t%u\t%u\t%llu\t%llu",
+                          &record.runs_, &record.failures_, &record.flips_, &record.runsSinceFailure_,
+                          &record.durationNs_, &lastRunTime))
+        {
+            res = false;
+            break;
+        }
+        record.lastRunTime_ = static_cast<time_t>(lastRunTime);
+
+        records_[std::string(line, nameEnd - line)] = record;
+    }
+
+    ::fclose(file);
+
+    if (!res)
+        records_.clear();
+    return res;
+}
+
+bool TestHistory::save(const char *path) const
+{
+    FILE *file = ::fopen(path, "w");
+    if (NULL == file)
+        return false;
+
+    for (Records::const_iterator it = records_.begin(), endIt = records_.end(); it != endIt; ++it)
+    {
+        const Record &record = it->second;
+        ::fprintf(file, "%s\t%u\t%u\t%u\t%u\t%llu\t%llu\n", it->first.c_str(),
+                  record.runs_, record.failures_, record.flips_, record.runsSinceFailure_,
+                  record.durationNs_, static_cast<unsigned long long>(record.lastRunTime_));
+    }
+
+    return 0 == ::fclose(file);
+}
+
+void TestHistory::record(const TestCase *test, bool success, unsigned long long durationNs)
+{
+    Record &record = records_[key(test)];
+
+    if (record.runs_ > 0)
+    {
+        const bool failedLastTime = 0 == record.runsSinceFailure_;
+        if (failedLastTime == success)
+            ++record.flips_;
+
+        // recent runs are more representative, than old ones (machine, test body and so on changes)
+        record.durationNs_ = (3 * record.durationNs_ + durationNs) / 4;
+    }
+    else
+        record.durationNs_ = durationNs;
+
+    ++record.runs_;
+    if (success)
+        ++record.runsSinceFailure_;
+    else
+    {
+        ++record.failures_;
+        record.runsSinceFailure_ = 0;
+    }
+
+    record.lastRunTime_ = ::time(NULL);
+}
+
+TestHistory::Priority TestHistory::priority(const TestCase *test) const
+{
+    Records::const_iterator it = records_.find(key(test));
+    if (records_.end() == it)
+        return recentlyChanged;
+
+    const Record &record = it->second;
+    if (record.failures_ > 0 && record.runsSinceFailure_ < recentRuns)
+        return recentlyFailed;
+
+    // source, which is not found, is treated as unchanged, but it is reported once per run
+    const std::string path = sourcePath(test);
+    struct stat st;
+    if (0 != ::stat(path.c_str(), &st))
+    {
+        if (!missingSourceReported_)
+            ::fprintf(stderr, "source file '%s' is not found, so changes of tests are not detected "
+                      "(see '--source-root')\n", path.c_str());
+        missingSourceReported_ = true;
+    }
+    else if (st.st_mtime > record.lastRunTime_)
+        return recentlyChanged;
+
+    if (record.flips_ >= flakyFlips)
+        return flaky;
+
+    return usual;
+}
+
+bool TestHistory::duration(const TestCase *test, unsigned long long &durationNs) const
+{
+    Records::const_iterator it = records_.find(key(test));
+    if (records_.end() == it)
+        return false;
+
+    durationNs = it->second.durationNs_;
+    return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void orderByHistory(const TestHistory &history, std::vector<TestCase*> &tests)
+{
+    orderLongestFirst(history, 0, tests);
+}
+
+// priority group, then expected duration, then registration index
+struct TestRank
+{
+    int priority_;
+    unsigned long long durationNs_; ///< zero keeps order of registration
+    size_t idx_;
+
+    bool operator<(const TestRank &rank) const
+    {
+        if (priority_ != rank.priority_)
+            return priority_ < rank.priority_;
+        if (durationNs_ != rank.durationNs_)
+            return durationNs_ > rank.durationNs_;
+        return idx_ < rank.idx_;
+    }
+};
+
+static bool lessRank(const std::pair<TestRank, TestCase*> &lhs, const std::pair<TestRank, TestCase*> &rhs)
+{
+    return lhs.first < rhs.first;
+}
+
+void orderLongestFirst(const TestHistory &history, unsigned long long defaultDurationNs,
+                       std::vector<TestCase*> &tests)
+{
+    std::vector<std::pair<TestRank, TestCase*> > ranked;
+    ranked.reserve(tests.size());
+
+    for (size_t idx = 0, size = tests.size(); idx < size; ++idx)
+    {
+        TestRank rank;
+        rank.priority_ = history.priority(tests[idx]);
+        rank.durationNs_ = 0;
+        if (0 != defaultDurationNs && !history.duration(tests[idx], rank.durationNs_))
+            rank.durationNs_ = defaultDurationNs;
+        rank.idx_ = idx;
+
+        ranked.push_back(std::make_pair(rank, tests[idx]));
+    }
+
+    std::sort(ranked.begin(), ranked.end(), lessRank);
+
+    for (size_t idx = 0, size = ranked.size(); idx < size; ++idx)
+        tests[idx] = ranked[idx].second;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+bool selectListed(const char *path, std::vector<TestCase*> &tests)
+{
+    FILE *file = ::fopen(path, "r");
+    if (NULL == file)
+        return false;
+
+    std::set<std::string> keys;
+    char line[1024];
+    while (::fgets(line, sizeof(line), file))
+    {
+        line[::strcspn(line, "\r\n")] = '\0';
+        keys.insert(line);
+    }
+    ::fclose(file);
+
+    std::vector<TestCase*> listed;
+    for (std::vector<TestCase*>::const_iterator it = tests.begin(), endIt = tests.end(); it != endIt; ++it)
+    {
+        const std::string key = TestHistory::key(*it);
+        const char *familyEnd = ::strchr((*it)->name_, '/');
+        if (keys.count(key)
+            || (NULL != familyEnd && keys.count(key.substr(0, key.size() - ::strlen(familyEnd)))))
+            listed.push_back(*it);
+    }
+    tests.swap(listed);
+    return true;
+}
+
+YUNIT_NS_END
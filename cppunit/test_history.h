@@ -0,0 +1,96 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// @file test_history.h
+//
+// Per-test outcome and duration history, persisted between test runs. Used by test registry to run the tests,
+// which most probably fail, at first.
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#ifndef _TEST_HISTORY_YUNIT_HEADER_
+#define _TEST_HISTORY_YUNIT_HEADER_
+
+#include "tests.h"
+#include <ctime>
+#include <map>
+#include <string>
+#include <vector>
+
+YUNIT_NS_BEGIN
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief History of previous runs. File format is text, one test per line:
+/// @code
+/// <file>\t<name>\t<runs>\t<failures>\t<flips>\t<runsSinceFailure>\t<durationNs>\t<lastRunTime>
+/// @endcode
+class TestHistory
+{
+public:
+    /// @brief Order of test execution, tests with less priority value are executed earlier
+    enum Priority
+    {
+        recentlyFailed  = 0, ///< test has failed during last 'recentRuns' runs
+        recentlyChanged = 1, ///< test is new or its source file has been modified after last run
+        flaky           = 2, ///< test has changed its outcome at least 'flakyFlips' times
+        usual           = 3
+    };
+
+    enum {recentRuns = 3, flakyFlips = 2};
+
+    TestHistory();
+
+    /// @brief Directory, relative '__FILE__' of tests is resolved against to detect changes of their sources.
+    /// Without it such paths are resolved against current directory.
+    void setSourceRoot(const char *dir);
+
+    /// @return false if file does not exist or has wrong format; history stays empty in such case
+    bool load(const char *path);
+    bool save(const char *path) const;
+
+    void record(const TestCase *test, bool success, unsigned long long durationNs);
+
+    Priority priority(const TestCase *test) const;
+
+    /// @param[out] durationNs Average duration of previous runs
+    /// @return false if test has never been run before
+    bool duration(const TestCase *test, unsigned long long &durationNs) const;
+
+    /// @brief '<file>\t<name>', key of test in history and results files
+    static std::string key(const TestCase *test);
+
+private:
+    struct Record
+    {
+        Record();
+
+        unsigned int runs_;
+        unsigned int failures_;
+        unsigned int flips_;            ///< number of outcome changes (success -> fail and vice versa)
+        unsigned int runsSinceFailure_; ///< zero means, that test has failed last time
+        unsigned long long durationNs_; ///< exponential moving average of test duration
+        time_t lastRunTime_;
+    };
+
+    std::string sourcePath(const TestCase *test) const;
+
+    typedef std::map<std::string, Record> Records;
+    Records records_;
+    std::string sourceRoot_;
+    mutable bool missingSourceReported_;
+};
+
+/// @brief Order of one worker: recently failed, changed and flaky tests go first, registration order is kept
+/// inside every priority group
+void orderByHistory(const TestHistory &history, std::vector<TestCase*> &tests);
+
+/// @brief Order of several workers: priority groups go as in orderByHistory, tests of every group are ordered by
+/// descending of their expected duration, so the longest ones do not finish the run alone
+/// @param defaultDurationNs Expected duration of test without history
+void orderLongestFirst(const TestHistory &history, unsigned long long defaultDurationNs,
+                       std::vector<TestCase*> &tests);
+
+/// @brief Keep only tests, listed in file 'path' by their keys, one per line; key of generated family selects all
+/// its cases. Used by shards and work units ('--test-list=<path>').
+/// @return false if file can not be read, 'tests' are not changed then
+bool selectListed(const char *path, std::vector<TestCase*> &tests);
+
+YUNIT_NS_END
+
+#endif // _TEST_HISTORY_YUNIT_HEADER_
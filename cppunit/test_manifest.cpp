@@ -0,0 +1,185 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// test_manifest.cpp
+//
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "test_manifest.h"
+#include <cstring>
+
+#if defined(YUNIT_MANIFEST_SECTION) && (defined(__linux__) || defined(__FreeBSD__))
+#  define YUNIT_ELF_MANIFEST
+#  include <elf.h>
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#endif
+
+YUNIT_NS_BEGIN
+
+#ifdef YUNIT_ELF_MANIFEST
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief Read-only mapping of the whole file
+class FileMapping
+{
+public:
+    explicit FileMapping(const char *path)
+    : data_(NULL)
+    , size_(0)
+    {
+        const int fd = ::open(path, O_RDONLY);
+        if (fd < 0)
+            return;
+
+        struct stat info;
+        if (0 == ::fstat(fd, &info) && info.st_size > 0)
+        {
+            void *memory = ::mmap(NULL, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+            if (MAP_FAILED != memory)
+            {
+                data_ = static_cast<const unsigned char*>(memory);
+                size_ = static_cast<size_t>(info.st_size);
+            }
+        }
+        ::close(fd);
+    }
+
+    ~FileMapping()
+    {
+        if (NULL != data_)
+            ::munmap(const_cast<unsigned char*>(data_), size_);
+    }
+
+    const unsigned char *data_;
+    size_t size_;
+
+private:
+    FileMapping(const FileMapping&);
+    FileMapping& operator=(const FileMapping&);
+};
+
+static bool parseRecords(const unsigned char *section, size_t size, std::vector<ManifestTest> &tests,
+                         std::string &error)
+{
+    enum {alignment = 4, headerSize = 2 * sizeof(unsigned int)};
+
+    for (size_t offset = 0; offset + headerSize <= size; )
+    {
+        unsigned int line, flags;
+        ::memcpy(&line, section + offset, sizeof(line));
+        ::memcpy(&flags, section + offset + sizeof(line), sizeof(flags));
+
+        const char *name = reinterpret_cast<const char*>(section + offset + headerSize);
+        const char *end = reinterpret_cast<const char*>(section + size);
+        const char *nameEnd = static_cast<const char*>(::memchr(name, '\0', end - name));
+        const char *fileEnd = (NULL != nameEnd) ? static_cast<const char*>(::memchr(nameEnd + 1, '\0', end - nameEnd - 1)) : NULL;
+        if (NULL == fileEnd)
+        {
+            error = "manifest record is truncated";
+            return false;
+        }
+
+        ManifestTest test;
+        test.name_.assign(name, nameEnd);
+        test.fileName_.assign(nameEnd + 1, fileEnd);
+        test.lineNumber_ = static_cast<int>(line);
+        test.flags_ = flags;
+        tests.push_back(test);
+
+        offset = (reinterpret_cast<const unsigned char*>(fileEnd + 1) - section + alignment - 1) / alignment * alignment;
+    }
+
+    return true;
+}
+
+template<typename Ehdr, typename Shdr>
+static bool readSections(const FileMapping &file, std::vector<ManifestTest> &tests, std::string &error)
+{
+    if (file.size_ < sizeof(Ehdr))
+    {
+        error = "ELF header is truncated";
+        return false;
+    }
+
+    Ehdr header;
+    ::memcpy(&header, file.data_, sizeof(header));
+
+    const unsigned long long tableEnd = header.e_shoff + static_cast<unsigned long long>(header.e_shnum) * sizeof(Shdr);
+    if (header.e_shentsize != sizeof(Shdr) || tableEnd > file.size_ || header.e_shstrndx >= header.e_shnum)
+    {
+        error = "ELF section headers are broken";
+        return false;
+    }
+
+    const unsigned char *table = file.data_ + header.e_shoff;
+    Shdr names;
+    ::memcpy(&names, table + header.e_shstrndx * sizeof(Shdr), sizeof(names));
+    if (names.sh_offset + names.sh_size > file.size_)
+    {
+        error = "ELF section names are broken";
+        return false;
+    }
+
+    const size_t manifestNameSize = sizeof(YUNIT_MANIFEST_SECTION);
+    for (unsigned int idx = 0; idx < header.e_shnum; ++idx)
+    {
+        Shdr section;
+        ::memcpy(&section, table + idx * sizeof(Shdr), sizeof(section));
+
+        if (section.sh_name + manifestNameSize > names.sh_size
+            || 0 != ::memcmp(file.data_ + names.sh_offset + section.sh_name, YUNIT_MANIFEST_SECTION, manifestNameSize))
+            continue;
+
+        if (SHT_NOBITS == section.sh_type || section.sh_offset + section.sh_size > file.size_)
+        {
+            error = "manifest section is broken";
+            return false;
+        }
+
+        return parseRecords(file.data_ + section.sh_offset, static_cast<size_t>(section.sh_size), tests, error);
+    }
+
+    return true;
+}
+
+bool readTestManifest(const char *path, std::vector<ManifestTest> &tests, std::string &error)
+{
+    FileMapping file(path);
+    if (NULL == file.data_)
+    {
+        error = std::string("can not map file ") + path;
+        return false;
+    }
+
+    if (file.size_ < EI_NIDENT || 0 != ::memcmp(file.data_, ELFMAG, SELFMAG))
+    {
+        error = std::string(path) + " is not ELF file";
+        return false;
+    }
+
+    // records are written by the same machine, which reads them, so byte order is native
+    bool res = false;
+    if (ELFCLASS64 == file.data_[EI_CLASS])
+        res = readSections<Elf64_Ehdr, Elf64_Shdr>(file, tests, error);
+    else if (ELFCLASS32 == file.data_[EI_CLASS])
+        res = readSections<Elf32_Ehdr, Elf32_Shdr>(file, tests, error);
+    else
+        error = "unknown ELF class";
+
+    if (!res)
+        error = std::string(path) + ": " + error;
+    return res;
+}
+
+#else // YUNIT_ELF_MANIFEST
+
+bool readTestManifest(const char *path, std::vector<ManifestTest> & /*tests*/, std::string &error)
+{
+    error = std::string(path) + ": test manifest is supported for ELF files only";
+    return false;
+}
+
+#endif // YUNIT_ELF_MANIFEST
+
+YUNIT_NS_END
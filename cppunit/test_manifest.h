@@ -0,0 +1,33 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// @file test_manifest.h
+//
+// Reader of "yunit_manifest" section of test container (see YUNIT_MANIFEST_SECTION in tests.h). Container
+// file is mapped and its section headers are parsed, so neither container code is loaded nor its static
+// initializers are executed. It is used by runner for run planning: listing, sharding, tests selection.
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#ifndef _TEST_MANIFEST_YUNIT_HEADER_
+#define _TEST_MANIFEST_YUNIT_HEADER_
+
+#include "tests.h"
+#include <string>
+#include <vector>
+
+YUNIT_NS_BEGIN
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+struct ManifestTest
+{
+    std::string name_;
+    std::string fileName_;
+    int lineNumber_;
+    unsigned int flags_;    ///< YUNIT_TEST_IGNORED, YUNIT_TEST_GENERATED
+};
+
+/// @brief Append tests of ELF file 'path' manifest to 'tests'
+/// @return false and 'error' description, if file can not be read or it is not ELF file; file without manifest
+/// section is not an error, it just has no tests
+bool readTestManifest(const char *path, std::vector<ManifestTest> &tests, std::string &error);
+
+YUNIT_NS_END
+
+#endif // _TEST_MANIFEST_YUNIT_HEADER_
@@ -0,0 +1,137 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// test_results.cpp
+//
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "test_results.h"
+#include <cstdlib>
+#include <cstring>
+
+YUNIT_NS_BEGIN
+
+static const char *outcomeNames[outcomesNumber] = {"ignored", "success", "fail", "crashed"};
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+TestResult::TestResult()
+: lineNumber_(0)
+, outcome_(outcomeSuccess)
+, attempts_(1)
+, durationNs_(0)
+, allocations_(0)
+, allocatedBytes_(0)
+, perfAvailable_(0)
+{
+    ::memset(perf_, 0, sizeof(perf_));
+}
+
+const char* outcomeName(TestOutcome outcome)
+{
+    return (outcome >= 0 && outcome < outcomesNumber) ? outcomeNames[outcome] : "unknown";
+}
+
+bool writeTestResult(FILE *file, const TestResult &result)
+{
+    if (0 >= ::fprintf(file, "%s\t%d\t%s\t%u\t%llu\t%llu\t%llu", result.key_.c_str(), result.lineNumber_,
+                       outcomeName(result.outcome_), result.attempts_, result.durationNs_, result.allocations_,
+                       result.allocatedBytes_))
+        return false;
+
+    if (0 != result.perfAvailable_)
+    {
+        for (int counter = 0; counter < perfCountersNumber; ++counter)
+        {
+            const char *separator = (0 == counter) ? "\tperf=" : ",";
+            const bool res = (0 != (result.perfAvailable_ & (1u << counter)))
+                           ? 0 < ::fprintf(file, "%s%llu", separator, result.perf_[counter])
+                           : 0 < ::fprintf(file, "%s-", separator);
+            if (!res)
+                return false;
+        }
+    }
+
+    return 0 < ::fprintf(file, "\n");
+}
+
+// 'perf=<counters>' field, 'pos' points after its name
+static bool parsePerfCounters(const char *&pos, TestResult &result)
+{
+    for (int counter = 0; counter < perfCountersNumber; ++counter)
+    {
+        if (counter > 0 && ',' != *pos++)
+            return false;
+
+        if ('-' == *pos)
+        {
+            ++pos;
+            continue;
+        }
+
+        char *end = NULL;
+        result.perf_[counter] = ::strtoull(pos, &end, 10);
+        if (pos == end)
+            return false;
+        result.perfAvailable_ |= 1u << counter;
+        pos = end;
+    }
+    return true;
+}
+
+bool parseTestResult(const char *line, TestResult &result, const char **end)
+{
+    // <file>\t<name>\t<numbers and outcome...>
+    const char *fileEnd = ::strchr(line, '\t');
+    const char *nameEnd = (NULL != fileEnd) ? ::strchr(fileEnd + 1, '\t') : NULL;
+    if (NULL == nameEnd)
+        return false;
+    result.key_.assign(line, nameEnd);
+
+    char *pos = NULL;
+    result.lineNumber_ = static_cast<int>(::strtol(nameEnd + 1, &pos, 10));
+    if ('\t' != *pos)
+        return false;
+
+    const char *outcome = pos + 1;
+    const size_t outcomeSize = ::strcspn(outcome, "\t");
+    int outcomeIdx = 0;
+    for (; outcomeIdx < outcomesNumber; ++outcomeIdx)
+        if (outcomeSize == ::strlen(outcomeNames[outcomeIdx]) && 0 == ::strncmp(outcome, outcomeNames[outcomeIdx], outcomeSize))
+            break;
+    if (outcomesNumber == outcomeIdx || '\t' != outcome[outcomeSize])
+        return false;
+    result.outcome_ = static_cast<TestOutcome>(outcomeIdx);
+
+    unsigned long long *numbers[] = {NULL, &result.durationNs_, &result.allocations_, &result.allocatedBytes_};
+    pos = const_cast<char*>(outcome + outcomeSize);
+    for (size_t idx = 0; idx < sizeof(numbers) / sizeof(numbers[0]); ++idx)
+    {
+        if ('\t' != *pos)
+            return false;
+        const char *number = pos + 1;
+        const unsigned long long value = ::strtoull(number, &pos, 10);
+        if (number == pos)
+            return false;
+
+        if (NULL == numbers[idx])
+            result.attempts_ = static_cast<unsigned int>(value);
+        else
+            *numbers[idx] = value;
+    }
+
+    static const char perfField[] = "\tperf=";
+    const char *fieldsEnd = pos;
+    result.perfAvailable_ = 0;
+    ::memset(result.perf_, 0, sizeof(result.perf_));
+    if (0 == ::strncmp(pos, perfField, sizeof(perfField) - 1))
+    {
+        fieldsEnd += sizeof(perfField) - 1;
+        if (!parsePerfCounters(fieldsEnd, result))
+            return false;
+    }
+    pos = const_cast<char*>(fieldsEnd);
+
+    if (NULL != end)
+        *end = pos;
+    return '\0' == *pos || '\n' == *pos || '\r' == *pos || '\t' == *pos;
+}
+
+YUNIT_NS_END
@@ -0,0 +1,60 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// @file test_results.h
+//
+// Results file of test program ('--results=<path>'), text, one executed test per line:
+// @code
+// <file>\t<name>\t<line>\t<outcome>\t<attempts>\t<durationNs>\t<allocations>\t<allocatedBytes>[\tperf=<counters>]
+// @endcode
+// Optional 'perf' field is written for tests measured with '--perf-counters': comma separated values of all
+// PerfCounter items in enum order, '-' for counter, which has not been measured.
+// Key of test is '<file>\t<name>', as in history file. Results files of shards and worker processes are
+// combined by runner ('--merge-results' mode), so the same test may be met several times.
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#ifndef _TEST_RESULTS_YUNIT_HEADER_
+#define _TEST_RESULTS_YUNIT_HEADER_
+
+#include "tests.h"
+#include <cstdio>
+#include <string>
+
+YUNIT_NS_BEGIN
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief Outcome of test, values are ordered by severity
+enum TestOutcome
+{
+    outcomeIgnored,
+    outcomeSuccess,
+    outcomeFail,
+    outcomeCrashed,
+    outcomesNumber
+};
+
+struct TestResult
+{
+    TestResult();
+
+    std::string key_;                   ///< '<file>\t<name>'
+    int lineNumber_;
+    TestOutcome outcome_;
+    unsigned int attempts_;             ///< number of executions, greater than 1 for merged retries
+    unsigned long long durationNs_;     ///< total duration of all attempts
+    unsigned long long allocations_;
+    unsigned long long allocatedBytes_;
+    unsigned long long perf_[perfCountersNumber];   ///< total of all attempts, indexed by PerfCounter
+    unsigned int perfAvailable_;                    ///< bit mask of measured counters: (1 << PerfCounter)
+};
+
+const char* outcomeName(TestOutcome outcome);
+
+/// @return false if 'file' can not be written
+bool writeTestResult(FILE *file, const TestResult &result);
+
+/// @brief Parse one line of results file ('\n' at the end is allowed)
+/// @param[out] end Position after parsed result, if it is not NULL, so line may have additional fields
+/// @return false if line has wrong format
+bool parseTestResult(const char *line, TestResult &result, const char **end = NULL);
+
+YUNIT_NS_END
+
+#endif // _TEST_RESULTS_YUNIT_HEADER_
@@ -4,8 +4,36 @@
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 #include "tests.h"
+#include "test_history.h"
+#include "test_results.h"
+#include "alloc_counter.h"
+#include "benchmark.h"
+#include "crash_isolation.h"
+#include "crash_record.h"
+#include "property.h"
+#include "trace.h"
 #include <stdexcept>
+#include <cctype>
 #include <cstring>
+#include <cstdlib>
+#include <deque>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <thread>
+
+#ifdef __GNUC__
+#  include <cxxabi.h>
+#endif
+
+#ifdef _WIN32
+#  include <windows.h>
+#else
+#  include <time.h>
+#endif
 
 YUNIT_NS_BEGIN
 
@@ -71,8 +99,23 @@ private:
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////
 static bool catchCppExceptions(TestCase *testCase, Thunk thunk, char **data);
 
+static char* crashMessage(const TestCase *testCase, const std::string &crash);
+
 static bool callTestCaseThunk(TestCase *testCase, Thunk thunk, char **data)
 {
+#ifdef YUNIT_CRASH_ISOLATION
+    if (crashIsolationEnabled())
+    {
+        CrashTrap trap(testCase->name_);
+        if (0 == sigsetjmp(trap.jump_, 1))
+            return !catchCppExceptions(testCase, thunk, data);
+
+        testCase->stats_.crashed_ = true;
+        *data = crashMessage(testCase, trap.message());
+        return false;
+    }
+#endif
+
     bool caught = false;
 #ifdef _MSC_VER
     __try
@@ -126,6 +169,20 @@ static bool catchCppExceptions(TestCase *testCase, Thunk thunk, char **data)
 	return false;
 }
 
+static char* crashMessage(const TestCase *testCase, const std::string &crash)
+{
+    enum {headerSize = 512};
+    char header[headerSize];
+    TS_SNPRINTF(header, headerSize, "%s:%d:0: error: test \"%s\" has crashed", testCase->fileName_,
+                testCase->lineNumber_, testCase->name_);
+    header[headerSize - 1] = '\0';
+
+    const std::string msg = crash.empty() ? std::string(header) : std::string(header) + " with " + crash;
+    char *data = new char[msg.size() + 1];
+    ::memcpy(data, msg.c_str(), msg.size() + 1);
+    return data;
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////
 Thunk::Thunk()
 : thunkPtr_(0)
@@ -165,58 +222,637 @@ TestCase::TestCase(const char* name, const char *fileName, const int lineNumber)
 , fileName_(fileName)
 , lineNumber_(lineNumber)
 {
+    ::memset(&stats_, 0, sizeof(stats_));
 }
 
 TestCase::~TestCase()
 {}
 
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void typeName(const std::type_info &type, char *buf, size_t bufSize)
+{
+    const char *name = type.name();
+#ifdef __GNUC__
+    int status = -1;
+    char *demangled = abi::__cxa_demangle(name, NULL, NULL, &status);
+    if (0 == status && NULL != demangled)
+        name = demangled;
+#endif
+
+    ::strncpy(buf, name, bufSize - 1);
+    buf[bufSize - 1] = '\0';
+
+#ifdef __GNUC__
+    ::free(demangled);
+#endif
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+YUNIT_NS_END
+
+#ifdef YUNIT_TEST_SECTION
+// defined by linker, when there is at least one test in section
+extern "C" const YUNIT_NS_PREF(TestDescriptor) *const __start_yunit_tests[] __attribute__((weak, visibility("hidden")));
+extern "C" const YUNIT_NS_PREF(TestDescriptor) *const __stop_yunit_tests[] __attribute__((weak, visibility("hidden")));
+#endif
+
+YUNIT_NS_BEGIN
+
+const TestDescriptor* const* testDescriptors(size_t &count)
+{
+#ifdef YUNIT_TEST_SECTION
+    if (NULL != __start_yunit_tests && NULL != __stop_yunit_tests)
+    {
+        count = static_cast<size_t>(__stop_yunit_tests - __start_yunit_tests);
+        return __start_yunit_tests;
+    }
+#endif
+    count = 0;
+    return NULL;
+}
+
+void indexCaseName(size_t idx, char *buf, size_t bufSize)
+{
+    TS_SNPRINTF(buf, bufSize, "%u", static_cast<unsigned int>(idx));
+    buf[bufSize - 1] = '\0';
+}
+
+/// @brief Test case of descriptor; test object is created by 'setUp' only, as for RegisterTestCase. Case 'idx'
+/// of generated family owns its name, so test case is not copyable.
+class DescribedTestCase : public TestCase
+{
+public:
+    DescribedTestCase(const TestDescriptor &descriptor, size_t idx)
+    : TestCase(descriptor.name_, descriptor.fileName_, descriptor.lineNumber_)
+    , descriptor_(&descriptor)
+    , idx_(idx)
+    , test_(NULL)
+    {
+        if (!generated())
+            return;
+
+        enum {suffixSize = 256};
+        char suffix[suffixSize] = "";
+        descriptor.caseName_(idx, suffix, suffixSize);
+        suffix[suffixSize - 1] = '\0';
+        fullName_ = std::string(descriptor.name_) + '/' + suffix;
+        name_ = fullName_.c_str();
+    }
+
+    ~DescribedTestCase()
+    {
+        delete test_;
+    }
+
+    virtual bool ignored()
+    {
+        return 0 != (descriptor_->flags_ & TestDescriptor::ignored);
+    }
+
+    virtual void setUp()
+    {
+        test_ = generated() ? descriptor_->createCase_(idx_) : descriptor_->create_();
+    }
+
+    virtual void testBody()
+    {
+        test_->testBody();
+    }
+
+    virtual void tearDown()
+    {
+        delete test_;
+        test_ = NULL;
+    }
+
+private:
+    DescribedTestCase(const DescribedTestCase&);
+    DescribedTestCase& operator=(const DescribedTestCase&);
+
+    bool generated() const
+    {
+        return 0 != (descriptor_->flags_ & TestDescriptor::generated);
+    }
+
+    const TestDescriptor *descriptor_;
+    size_t idx_;
+    Test *test_;
+    std::string fullName_;
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+TestExtension *TestExtension::first_ = NULL;
+
+TestExtension::TestExtension()
+: next_(first_)
+{
+    first_ = this;
+}
+
+bool TestExtension::parseOption(const char * /*arg*/)
+{
+    return false;
+}
+
+bool TestExtension::startExecution()
+{
+    return false;
+}
+
+void TestExtension::finishExecution()
+{
+}
+
+void* TestExtension::openWorker()
+{
+    return NULL;
+}
+
+void TestExtension::closeWorker(void * /*worker*/)
+{
+}
+
+void TestExtension::startBody(void * /*worker*/, TestCase * /*test*/)
+{
+}
+
+void TestExtension::stopBody(void * /*worker*/, TestCase * /*test*/)
+{
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////
 TestRegistry *testRegistry = NULL;
 
 const char* TestRegistry::ignored = "ignored";
 const char* TestRegistry::success = "success";
 const char* TestRegistry::fail = "fail";
+const char* TestRegistry::warning = "warning";
+
+const char* TestRegistry::defaultHistoryFile = ".yunit_history";
 
 struct TestRegistryImpl : TestRegistry
 {
+    typedef void (*Callback)(void *ctx, void *arg, void *data);
+
+    TestRegistryImpl()
+    : workers_(1)
+    , defaultDurationNs_(defaultDurationMs * 1000000ULL)
+    , leakCheck_(leakCheckOff)
+    , crashIsolation_(false)
+    {
+    }
+
     virtual void add(TestCase* testCase)
     {
         tests_ << testCase;
     }
 
-    virtual void executeAllTests(void (*callback)(void *ctx, void *arg, void *data), void *ctx)
+    virtual void setHistoryFile(const char *path)
+    {
+        historyFile_ = (NULL != path) ? path : "";
+    }
+
+    virtual void setSourceRoot(const char *dir)
+    {
+        sourceRoot_ = (NULL != dir) ? dir : "";
+    }
+
+    virtual void setNumberOfWorkers(unsigned int workers)
+    {
+        workers_ = (0 == workers) ? 1 : workers;
+    }
+
+    virtual void setDefaultDuration(unsigned long long durationNs)
+    {
+        defaultDurationNs_ = durationNs;
+    }
+
+    virtual void setLeakCheck(LeakCheck mode)
+    {
+        leakCheck_ = allocCounterEnabled() ? mode : leakCheckOff;
+    }
+
+    virtual void setTraceFile(const char *path)
+    {
+        traceFile_ = (NULL != path) ? path : "";
+    }
+
+    virtual void setCrashIsolation(bool enable)
+    {
+        crashIsolation_ = enable && crashIsolationSupported();
+    }
+
+    virtual void setResumeAfter(const char *name)
+    {
+        resumeAfter_ = (NULL != name) ? name : "";
+    }
+
+    virtual void setResumeResults(const char *path)
+    {
+        resumeResults_ = (NULL != path) ? path : "";
+    }
+
+    virtual void setResultsFile(const char *path)
     {
+        resultsFile_ = (NULL != path) ? path : "";
+    }
+
+    virtual void setTestList(const char *path)
+    {
+        testList_ = (NULL != path) ? path : "";
+    }
+
+    virtual void executeAllTests(Callback callback, void *ctx)
+    {
+        loadDescribedTests();
+
+        std::vector<TestCase*> tests;
+        tests.reserve(describedTests_.size() + tests_.size());
+        for (size_t idx = describedTests_.size(); idx > 0; --idx)
+            tests.push_back(&describedTests_[idx - 1]);
         for (Chain<TestCase*>::ReverseIterator it = tests_.rbegin(), endIt = tests_.rend(); it != endIt; ++it)
+            tests.push_back(*it);
+
+        // tests, which are not listed, belong to other shards or units, so they must not be executed instead
+        if (!testList_.empty() && !selectListed(testList_.c_str(), tests))
+            throw std::runtime_error("test list '" + testList_ + "' can not be read");
+
+        TestHistory history;
+        const bool useHistory = !historyFile_.empty();
+        if (useHistory)
+        {
+            history.setSourceRoot(sourceRoot_.c_str());
+            history.load(historyFile_.c_str());
+            if (workers_ > 1)
+                orderLongestFirst(history, defaultDurationNs_, tests);
+            else
+                orderByHistory(history, tests);
+        }
+
+        // results are passed to process, restarted after crash, so they are written into temporary file
+        // without results file of user
+        const bool restartable = crashIsolation_ && 1 == workers_;
+        std::string resultsPath = resultsFile_;
+        if (resultsPath.empty())
+            resultsPath = !resumeResults_.empty() ? resumeResults_ : restartable ? crashRestartResultsPath() : "";
+        const bool temporaryResults = resultsFile_.empty() && !resultsPath.empty();
+
+        // results of tests, executed before restart of crashed process, are kept; line buffering flushes result
+        // of every test, so they are not lost by exec
+        FILE *resultsFile = NULL;
+        if (!resultsPath.empty())
+        {
+            resultsFile = ::fopen(resultsPath.c_str(), resumeAfter_.empty() ? "w" : "a");
+            if (NULL == resultsFile)
+                ::fprintf(stderr, "Can not open results file '%s'\n", resultsPath.c_str());
+            else
+                ::setvbuf(resultsFile, NULL, _IOLBF, BUFSIZ);
+        }
+
+        if (!resumeAfter_.empty())
+            skipUpToCrashed(callback, ctx, useHistory ? &history : NULL, resultsFile, tests);
+
+        if (!traceFile_.empty() && !openTraceFile(traceFile_.c_str()))
+            ::fprintf(stderr, "Can not open trace file '%s'\n", traceFile_.c_str());
+
+        std::vector<TestExtension*> extensions;
+        for (TestExtension *extension = TestExtension::first_; NULL != extension; extension = extension->next_)
+            if (extension->startExecution())
+                extensions.push_back(extension);
+
+        CrashHandlers crashHandlers(crashIsolation_, restartable,
+                                    NULL != resultsFile ? resultsPath.c_str() : NULL);
+        TestExecution execution(tests, callback, ctx, useHistory ? &history : NULL, leakCheck_, extensions);
+        execution.resultsFile_ = resultsFile;
+        execution.run(workers_);
+
+        for (size_t idx = 0; idx < extensions.size(); ++idx)
+            extensions[idx]->finishExecution();
+
+        if (!traceFile_.empty())
+            closeTraceFile();
+
+        if (NULL != resultsFile)
+            ::fclose(resultsFile);
+        if (temporaryResults)
+            ::remove(resultsPath.c_str());
+
+        if (useHistory)
+            history.save(historyFile_.c_str());
+    }
+
+    // process has been restarted after crash of test 'resumeAfter_', tests before it have been reported by
+    // previous process; order of tests is the same, because history is not saved yet
+    void skipUpToCrashed(Callback callback, void *ctx, TestHistory *history, FILE *resultsFile,
+                         std::vector<TestCase*> &tests)
+    {
+        std::vector<TestCase*>::iterator crashed = tests.begin();
+        for (std::vector<TestCase*>::iterator endIt = tests.end(); crashed != endIt; ++crashed)
+            if (resumeAfter_ == (*crashed)->name_)
+                break;
+
+        if (tests.end() == crashed)
+        {
+            ::fprintf(stderr, "Crashed test '%s' is not found, all tests are executed\n", resumeAfter_.c_str());
+            return;
+        }
+
+        if (!resumeResults_.empty())
+            reportResumedResults(callback, ctx, history, std::vector<TestCase*>(tests.begin(), crashed));
+
+        TestCase *test = *crashed;
+        ::memset(&test->stats_, 0, sizeof(test->stats_));
+        test->stats_.crashed_ = true;
+        callback(ctx, const_cast<char*>(TestRegistry::fail), new TestRegistry::FailCtx(test, crashMessage(test, "")));
+        if (NULL != history)
+            history->record(test, false, 0);
+        if (NULL != resultsFile)
+            writeResult(resultsFile, test, outcomeCrashed);
+
+        tests.erase(tests.begin(), crashed + 1);
+    }
+
+    // tests of crashed process are reported with their outcomes and measurements, failure messages have been
+    // printed by that process already
+    void reportResumedResults(Callback callback, void *ctx, TestHistory *history,
+                              const std::vector<TestCase*> &tests)
+    {
+        FILE *file = ::fopen(resumeResults_.c_str(), "r");
+        if (NULL == file)
+        {
+            ::fprintf(stderr, "Can not read results of crashed process '%s'\n", resumeResults_.c_str());
+            return;
+        }
+
+        std::map<std::string, TestCase*> executed;
+        for (std::vector<TestCase*>::const_iterator it = tests.begin(), endIt = tests.end(); it != endIt; ++it)
+            executed[TestHistory::key(*it)] = *it;
+
+        enum {lineSize = 4096};
+        char line[lineSize];
+        while (::fgets(line, lineSize, file))
+        {
+            TestResult result;
+            if (!parseTestResult(line, result))
+                continue;
+            std::map<std::string, TestCase*>::const_iterator found = executed.find(result.key_);
+            if (executed.end() == found)
+                continue;
+
+            TestCase *test = found->second;
+            if (outcomeIgnored == result.outcome_)
+            {
+                callback(ctx, const_cast<char*>(TestRegistry::ignored), test);
+                continue;
+            }
+
+            ::memset(&test->stats_, 0, sizeof(test->stats_));
+            test->stats_.durationNs_ = result.durationNs_;
+            test->stats_.allocations_ = result.allocations_;
+            test->stats_.allocatedBytes_ = result.allocatedBytes_;
+            test->stats_.crashed_ = (outcomeCrashed == result.outcome_);
+
+            if (outcomeSuccess == result.outcome_)
+                callback(ctx, const_cast<char*>(TestRegistry::success), test);
+            else
+            {
+                char *msg = test->stats_.crashed_ ? crashMessage(test, "") : resumedFailMessage(test);
+                callback(ctx, const_cast<char*>(TestRegistry::fail), new TestRegistry::FailCtx(test, msg));
+            }
+
+            if (NULL != history)
+                history->record(test, outcomeSuccess == result.outcome_, result.durationNs_);
+        }
+        ::fclose(file);
+    }
+
+    static char* resumedFailMessage(const TestCase *test)
+    {
+        enum {msgSize = 512};
+        char *msg = new char[msgSize];
+        TS_SNPRINTF(msg, msgSize, "%s:%d:0: error: test \"%s\" has failed before restart of process",
+                    test->fileName_, test->lineNumber_, test->name_);
+        msg[msgSize - 1] = '\0';
+        return msg;
+    }
+
+    // generated test "<family>/<case>" is selected by key of its family, as it is written in manifest
+    static void writeResult(FILE *file, const TestCase *test, TestOutcome outcome)
+    {
+        TestResult result;
+        result.key_ = TestHistory::key(test);
+        result.lineNumber_ = test->lineNumber_;
+        result.outcome_ = outcome;
+        if (outcomeIgnored != outcome)
+        {
+            result.durationNs_ = test->stats_.durationNs_;
+            result.allocations_ = test->stats_.allocations_;
+            result.allocatedBytes_ = test->stats_.allocatedBytes_;
+            result.perfAvailable_ = test->stats_.perfAvailable_;
+            for (int counter = 0; counter < perfCountersNumber; ++counter)
+                result.perf_[counter] = test->stats_.perf_[counter];
+        }
+        writeTestResult(file, result);
+    }
+
+    // test cases of section descriptors are created by the first execution; deque keeps their addresses
+    void loadDescribedTests()
+    {
+        size_t count = 0;
+        const TestDescriptor* const* descriptors = testDescriptors(count);
+        if (!describedTests_.empty())
+            return;
+
+        for (size_t idx = 0; idx < count; ++idx)
+        {
+            const TestDescriptor &descriptor = *descriptors[idx];
+            const bool generated = 0 != (descriptor.flags_ & TestDescriptor::generated);
+            for (size_t caseIdx = 0, cases = generated ? descriptor.cases_ : 1; caseIdx < cases; ++caseIdx)
+                describedTests_.emplace_back(descriptor, caseIdx);
+        }
+    }
+
+    // Tests are taken from shared queue by the worker, which has finished its previous test at first, so with
+    // longest-first order of queue it is a greedy LPT schedule.
+    struct TestExecution
+    {
+        TestExecution(const std::vector<TestCase*> &tests, Callback callback, void *ctx, TestHistory *history,
+                      LeakCheck leakCheck, const std::vector<TestExtension*> &extensions)
+        : tests_(tests)
+        , next_(0)
+        , callback_(callback)
+        , ctx_(ctx)
+        , history_(history)
+        , leakCheck_(leakCheck)
+        , extensions_(extensions)
+        , resultsFile_(NULL)
+        {
+        }
+
+        void run(unsigned int workers)
+        {
+            if (workers > tests_.size())
+                workers = static_cast<unsigned int>(tests_.size());
+
+            std::vector<std::thread> threads;
+            for (unsigned int idx = 1; idx < workers; ++idx)
+                threads.push_back(std::thread(&TestExecution::work, this));
+
+            work(); // current thread is a worker too
+
+            for (std::vector<std::thread>::iterator it = threads.begin(), endIt = threads.end(); it != endIt; ++it)
+                it->join();
+        }
+
+        void work()
+        {
+            // extensions measure calling thread only (counters group, profiler timer), so every worker has own
+            // states of them
+            Worker worker(extensions_.size());
+            CrashAltStack altStack(crashIsolationEnabled());
+            for (size_t idx = 0; idx < extensions_.size(); ++idx)
+                worker[idx] = extensions_[idx]->openWorker();
+
+            for (size_t idx = next_++; idx < tests_.size(); idx = next_++)
+            {
+                TestCase *test = tests_[idx];
+                const bool testSuccess = executeTest(test, worker);
+
+                if (NULL != history_ && !test->ignored())
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    history_->record(test, testSuccess, test->stats_.durationNs_);
+                }
+
+                if (NULL != resultsFile_)
+                {
+                    const TestOutcome outcome = test->ignored() ? outcomeIgnored
+                                              : test->stats_.crashed_ ? outcomeCrashed
+                                              : testSuccess ? outcomeSuccess : outcomeFail;
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    writeResult(resultsFile_, test, outcome);
+                }
+            }
+
+            for (size_t idx = 0; idx < extensions_.size(); ++idx)
+                extensions_[idx]->closeWorker(worker[idx]);
+        }
+
+        typedef std::vector<void*> Worker; // states of extensions
+
+        // @return false if test has failed
+        bool executeTest(TestCase *test, Worker &worker)
         {
-            TestCase *test = *it;
             char *errmsg = NULL;
             bool testRes = false;
             bool tearDownRes = false;
 
             if (test->ignored())
-                callback(ctx, const_cast<char*>(TestRegistry::ignored), test);
-            else
             {
-                if (callTestCaseThunk(test, Thunk::create<TestCase, &TestCase::setUp>(test), &errmsg))
-                {
-                    testRes = callTestCaseThunk(test, Thunk::create<Test, &Test::testBody>(dynamic_cast<Test*>(test)), &errmsg);
-                    if (!testRes)
-                        callback(ctx, const_cast<char*>(TestRegistry::fail), new TestRegistry::FailCtx(test, errmsg));
+                notify(TestRegistry::ignored, test);
+                return true;
+            }
 
-                    tearDownRes = callTestCaseThunk(test, Thunk::create<TestCase, &TestCase::tearDown>(test), &errmsg);
-                    if (!tearDownRes)
-                        callback(ctx, const_cast<char*>(TestRegistry::fail), new TestRegistry::FailCtx(test, errmsg));
+            // the first trace call of thread allocates its buffer, so it is done before allocations counting
+            traceBegin(test->name_);
+            test->stats_.crashed_ = false;
+            test->stats_.perfAvailable_ = 0;
 
-                    if (testRes && tearDownRes)
-                        callback(ctx, const_cast<char*>(TestRegistry::success), test);
-                }
-                else
-                    callback(ctx, const_cast<char*>(TestRegistry::fail), new TestRegistry::FailCtx(test, errmsg));
+            const AllocStats allocStart = threadAllocStats();
+            const unsigned long long startTime = currentTimeNs();
+
+            if (callTestCaseThunk(test, Thunk::create<TestCase, &TestCase::setUp>(test), &errmsg))
+            {
+                for (size_t idx = 0; idx < extensions_.size(); ++idx)
+                    extensions_[idx]->startBody(worker[idx], test);
+                testRes = callTestCaseThunk(test, Thunk::create<Test, &Test::testBody>(dynamic_cast<Test*>(test)), &errmsg);
+                for (size_t idx = extensions_.size(); idx > 0; --idx)
+                    extensions_[idx - 1]->stopBody(worker[idx - 1], test);
+
+                if (!testRes)
+                    notify(TestRegistry::fail, new TestRegistry::FailCtx(test, errmsg));
+
+                // objects of crashed test may be broken, so they are not destroyed
+                tearDownRes = test->stats_.crashed_
+                           || callTestCaseThunk(test, Thunk::create<TestCase, &TestCase::tearDown>(test), &errmsg);
+                if (!tearDownRes)
+                    notify(TestRegistry::fail, new TestRegistry::FailCtx(test, errmsg));
             }
+            else
+                notify(TestRegistry::fail, new TestRegistry::FailCtx(test, errmsg));
+
+            TestStats &stats = test->stats_;
+            stats.durationNs_ = currentTimeNs() - startTime;
+
+            const AllocStats allocFinish = threadAllocStats();
+            stats.allocations_ = allocFinish.allocations_ - allocStart.allocations_;
+            stats.allocatedBytes_ = allocFinish.allocatedBytes_ - allocStart.allocatedBytes_;
+            stats.leakedBytes_ = allocFinish.outstandingBytes_ - allocStart.outstandingBytes_;
+
+            traceEnd(test->name_);
+            if (traceEnabled())
+                flushTrace();
+
+            if (!testRes || !tearDownRes)
+                return false;
+
+            // failed tests are not checked, because their error messages are allocated inside checked interval
+            if (leakCheckOff != leakCheck_ && stats.leakedBytes_ > 0)
+            {
+                const char *leakCheckEvent = (leakCheckFail == leakCheck_) ? TestRegistry::fail : TestRegistry::warning;
+                notify(leakCheckEvent, new TestRegistry::FailCtx(test, leakMessage(test, allocStart, allocFinish)));
+                if (leakCheckFail == leakCheck_)
+                    return false;
+            }
+
+            notify(TestRegistry::success, test);
+            return true;
+        }
+
+        static char* leakMessage(const TestCase *test, const AllocStats &start, const AllocStats &finish)
+        {
+            const long long notFreed = static_cast<long long>(finish.allocations_ - start.allocations_)
+                                     - static_cast<long long>(finish.deallocations_ - start.deallocations_);
+            enum {msgSize = 512};
+            char *msg = new char[msgSize];
+            TS_SNPRINTF(msg, msgSize, "%s:%d:0: error: test \"%s\" has leaked %lld bytes in %lld allocations",
+                        test->fileName_, test->lineNumber_, test->name_,
+                        test->stats_.leakedBytes_, notFreed);
+            msg[msgSize - 1] = '\0';
+            return msg;
         }
-    }
+
+        // client callback is not obliged to be thread safe
+        void notify(const char *event, void *data)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            callback_(ctx_, const_cast<char*>(event), data);
+        }
+
+        const std::vector<TestCase*> &tests_;
+        std::atomic<size_t> next_;
+        std::mutex mutex_;
+        Callback callback_;
+        void *ctx_;
+        TestHistory *history_;
+        LeakCheck leakCheck_;
+        const std::vector<TestExtension*> &extensions_;
+        FILE *resultsFile_;
+    };
 
     Chain<TestCase*> tests_;
+    std::deque<DescribedTestCase> describedTests_;
+    std::string historyFile_;
+    std::string sourceRoot_;
+    unsigned int workers_;
+    unsigned long long defaultDurationNs_;
+    LeakCheck leakCheck_;
+    std::string traceFile_;
+    bool crashIsolation_;
+    std::string resumeAfter_;
+    std::string resumeResults_;
+    std::string resultsFile_;
+    std::string testList_;
 };
 
 void initTestRegistry()
@@ -231,6 +867,119 @@ void delTestRegistry()
     testRegistry = NULL;
 }
 
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+bool parseCommandLine(int argc, char **argv)
+{
+    initTestRegistry();
+    setCrashRestartCommandLine(argc, argv);
+
+    bool res = true;
+    for (int argIdx = 1/* skip program path */; argIdx < argc; ++argIdx)
+    {
+        const char *arg = argv[argIdx];
+        const char *value;
+
+        if (NULL != (value = optionValue(arg, "--history=")))
+            testRegistry->setHistoryFile(value);
+        else if (0 == ::strcmp(arg, "--history"))
+            testRegistry->setHistoryFile(TestRegistry::defaultHistoryFile);
+        else if (0 == ::strcmp(arg, "--no-history"))
+            testRegistry->setHistoryFile(NULL);
+        else if (NULL != (value = optionValue(arg, "--source-root=")))
+            testRegistry->setSourceRoot(value);
+        else if (NULL != (value = optionValue(arg, "--jobs=")))
+        {
+            char *end = NULL;
+            const unsigned long jobs = isdigit(static_cast<unsigned char>(*value)) ? ::strtoul(value, &end, 10) : 0;
+            if (0 == jobs || '\0' != *end || static_cast<unsigned int>(jobs) != jobs)
+            {
+                fprintf(stderr, "Wrong number of jobs '%s', it must be positive number\n", value);
+                res = false;
+            }
+            else
+                testRegistry->setNumberOfWorkers(static_cast<unsigned int>(jobs));
+        }
+        else if (NULL != (value = optionValue(arg, "--default-duration=")))
+            testRegistry->setDefaultDuration(::strtoull(value, NULL, 10) * 1000000ULL);
+        else if (0 == ::strcmp(arg, "--leak-check=warn"))
+            testRegistry->setLeakCheck(TestRegistry::leakCheckWarn);
+        else if (0 == ::strcmp(arg, "--leak-check=fail"))
+            testRegistry->setLeakCheck(TestRegistry::leakCheckFail);
+        else if (NULL != (value = optionValue(arg, "--baselines=")))
+            setBaselineFile(value);
+        else if (0 == ::strcmp(arg, "--baselines"))
+            setBaselineFile(defaultBaselineFile);
+        else if (0 == ::strcmp(arg, "--update-baselines"))
+            setUpdateBaselines(true);
+        else if (NULL != (value = optionValue(arg, "--benchmark-history=")))
+            setBenchmarkHistoryFile(value);
+        else if (0 == ::strcmp(arg, "--benchmark-history"))
+            setBenchmarkHistoryFile(defaultBenchmarkHistoryFile);
+        else if (0 == ::strcmp(arg, "--no-benchmark-history"))
+            setBenchmarkHistoryFile(NULL);
+        else if (NULL != (value = optionValue(arg, "--commit=")))
+            setBenchmarkCommit(value);
+        else if (NULL != (value = optionValue(arg, "--trace=")))
+            testRegistry->setTraceFile(value);
+        else if (NULL != (value = optionValue(arg, "--property-cases=")))
+            setPropertyCases(static_cast<unsigned int>(::strtoul(value, NULL, 10)));
+        else if (NULL != (value = optionValue(arg, "--property-seed=")))
+            setPropertySeed(::strtoull(value, NULL, 0));
+        else if (NULL != (value = optionValue(arg, "--property-threads=")))
+            setPropertyThreads(static_cast<unsigned int>(::strtoul(value, NULL, 10)));
+        else if (0 == ::strcmp(arg, "--crash-isolation"))
+            testRegistry->setCrashIsolation(true);
+        else if (NULL != (value = optionValue(arg, "--resume-after=")))
+            testRegistry->setResumeAfter(value);
+        else if (NULL != (value = optionValue(arg, "--resume-results=")))
+            testRegistry->setResumeResults(value);
+        else if (NULL != (value = optionValue(arg, "--results=")))
+            testRegistry->setResultsFile(value);
+        else if (NULL != (value = optionValue(arg, "--test-list=")))
+            testRegistry->setTestList(value);
+        else if (NULL != (value = optionValue(arg, "--crash-record=")))
+        {
+            setCrashRecordDir(value);
+            testRegistry->setCrashIsolation(true);
+        }
+        else
+        {
+            TestExtension *extension = TestExtension::first_;
+            while (NULL != extension && !extension->parseOption(arg))
+                extension = extension->next_;
+
+            if (NULL == extension)
+            {
+                fprintf(stderr, "Unknown option '%s'\n", arg);
+                res = false;
+            }
+        }
+    }
+
+    return res;
+}
+
+const char* optionValue(const char *arg, const char *option)
+{
+    const size_t len = ::strlen(option);
+    return 0 == ::strncmp(arg, option, len) ? arg + len : NULL;
+}
+
+unsigned long long currentTimeNs()
+{
+#ifdef _WIN32
+    LARGE_INTEGER frequency, counter;
+    ::QueryPerformanceFrequency(&frequency);
+    ::QueryPerformanceCounter(&counter);
+    return static_cast<unsigned long long>(counter.QuadPart / frequency.QuadPart) * 1000000000ULL
+         + static_cast<unsigned long long>(counter.QuadPart % frequency.QuadPart) * 1000000000ULL / frequency.QuadPart;
+#else
+    struct timespec ts;
+    ::clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<unsigned long long>(ts.tv_sec) * 1000000000ULL + ts.tv_nsec;
+#endif
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////////////////
 template<typename T>
 Chain<T>::Chain()
@@ -9,6 +9,9 @@
 #include "../yunit/yunit.h"
 #include <cstddef>
 #include <cstdio>
+#include <new>
+#include <type_traits>
+#include <typeinfo>
 
 YUNIT_NS_BEGIN
 
@@ -55,11 +58,141 @@ YUNIT_NS_BEGIN
 
 /// @brief Register ignored test
 #define _TEST(name)\
-    YUNIT_NS_PREF(RegisterIgnoredTestCase) UNIQUENAME(name)(#name, __FILE__, __LINE__);\
+    registerIgnoredTest(name, __FILE__, __LINE__)\
     template<typename T> void TestCase ## name ## Fake()
     
-#define registerTest(name, fileName, lineNumber)\
-    YUNIT_NS_PREF(RegisterTestCase)<TestCase__##name> UNIQUENAME(name)(#name, fileName, lineNumber);\
+/// On ELF platforms test is registered by constant descriptor in "yunit_tests" section: registry enumerates
+/// section between '__start_yunit_tests' and '__stop_yunit_tests' symbols, so registration has neither
+/// static constructor nor heap allocation. Tests must be linked into the same module as tests.cpp then.
+/// Parameterized and typed families are described by one descriptor, which creates their cases by index.
+#if defined(__ELF__)
+#   define YUNIT_TEST_SECTION "yunit_tests"
+
+#   define registerTest(name, fileName, lineNumber)\
+    describeTest(name, fileName, lineNumber, 0, &YUNIT_NS_PREF(createTest)<TestCase__##name>, 0, NULL, NULL)
+
+#   define registerIgnoredTest(name, fileName, lineNumber)\
+    describeTest(name, fileName, lineNumber, YUNIT_TEST_IGNORED, NULL, 0, NULL, NULL)
+
+#   define registerParamTest(name, source, count)\
+    static YUNIT_NS_PREF(Test)* TestCreate__##name(size_t idx)\
+    {\
+        return new TestCase__##name(source(idx));\
+    }\
+    describeTest(name, __FILE__, __LINE__, YUNIT_TEST_GENERATED, NULL, (count), &TestCreate__##name,\
+                 &YUNIT_NS_PREF(indexCaseName))
+
+#   define registerTypedTest(name, ...)\
+    typedef YUNIT_NS_PREF(TypedTestFactory)<TestCase__##name, __VA_ARGS__> TestFactory__##name;\
+    describeTest(name, __FILE__, __LINE__, YUNIT_TEST_GENERATED, NULL, TestFactory__##name::count,\
+                 &TestFactory__##name::create, &TestFactory__##name::caseName)
+
+#   define describeTest(name, fileName, lineNumber, flags, create, cases, createCase, caseName)\
+    static const YUNIT_NS_PREF(TestDescriptor) TestDescriptor__##name =\
+        {#name, fileName, lineNumber, flags, create, cases, createCase, caseName};\
+    static const YUNIT_NS_PREF(TestDescriptor) *const UNIQUENAME(name)\
+        __attribute__((section(YUNIT_TEST_SECTION), used)) = &TestDescriptor__##name;\
+    manifestTest(name, fileName, lineNumber, flags)
+
+/// Every test is also written into non-allocated "yunit_manifest" section, which is not loaded into memory,
+/// so runner reads list of tests from file without its loading (see test_manifest.h). Record format:
+/// <uint32 line><uint32 flags><name>\0<file>\0, aligned by 4 bytes.
+#   define YUNIT_MANIFEST_SECTION "yunit_manifest"
+
+#   define manifestTest(name, fileName, lineNumber, flags)\
+    __asm__(".pushsection " YUNIT_MANIFEST_SECTION ",\"\"\n"\
+            ".balign 4\n"\
+            ".long " TOSTR(lineNumber) "\n"\
+            ".long " TOSTR(flags) "\n"\
+            ".asciz \"" #name "\"\n"\
+            ".asciz \"" fileName "\"\n"\
+            ".popsection\n");
+#else
+#   define registerTest(name, fileName, lineNumber)\
+    YUNIT_NS_PREF(RegisterTestCase)<TestCase__##name> UNIQUENAME(name)(#name, fileName, lineNumber);
+
+#   define registerIgnoredTest(name, fileName, lineNumber)\
+    YUNIT_NS_PREF(RegisterIgnoredTestCase) UNIQUENAME(name)(#name, fileName, lineNumber);
+
+#   define registerParamTest(name, source, count)\
+    YUNIT_NS_PREF(RegisterParamTestCases)<TestCase__##name, decltype(source), (count)>\
+        UNIQUENAME(name)(#name, __FILE__, __LINE__, source);
+
+#   define registerTypedTest(name, ...)\
+    YUNIT_NS_PREF(RegisterTypedTestCases)<TestCase__##name, __VA_ARGS__> UNIQUENAME(name)(#name, __FILE__, __LINE__);
+
+#   define manifestTest(name, fileName, lineNumber, flags)
+#endif
+
+/// Flags of test descriptor and manifest record; they are literals, because manifest is written by assembler
+#define YUNIT_TEST_IGNORED 1
+#define YUNIT_TEST_GENERATED 2  ///< family of parameterized or typed tests, which names are built at run time
+
+/// @brief Register parameterized test: every value is a separate test case with name "<name>/<index>", so it
+/// is executed, ordered and reported independently. Value is accessible inside test body as 'param'.
+/// Without test section test cases are expanded at compile time and stored statically, test objects are created
+/// with placement new then.
+/// @code
+/// TEST_P(primeIsOdd, int, 3, 5, 7, 11)
+/// {
+///     areEq(1, param % 2);
+/// }
+/// @endcode
+#define TEST_P(name, ParamType, ...)\
+    declareParamTest(name, ParamType)\
+    static const ParamType TestParams__##name[] = {__VA_ARGS__};\
+    registerParamTest(name, YUNIT_NS_PREF(ParamArray)<ParamType>(TestParams__##name),\
+                      sizeof(TestParams__##name) / sizeof(TestParams__##name[0]))\
+    void TestCase__##name::testBody()
+
+/// @brief Parameterized test over existing (for example, constexpr) array
+#define TEST_P_ARRAY(name, array)\
+    declareParamTest(name, YUNIT_NS_PREF(ArrayElement)<decltype(array)>::Type)\
+    registerParamTest(name, YUNIT_NS_PREF(ParamArray)<TestCase__##name::Param>(array), sizeof(array) / sizeof(array[0]))\
+    void TestCase__##name::testBody()
+
+/// @brief Parameterized test, which 'count' values are produced by 'generator' call with index of value
+/// (function or lambda expression). Generator is called right before test execution.
+/// @code
+/// TEST_P_GEN(powerOfTwo, unsigned int, 8, [](size_t idx) { return 1u << idx; })
+/// {
+///     areEq(0u, param & (param - 1));
+/// }
+/// @endcode
+#define TEST_P_GEN(name, ParamType, count, generator)\
+    declareParamTest(name, ParamType)\
+    static auto TestParamsGenerator__##name = generator;\
+    registerParamTest(name, TestParamsGenerator__##name, count)\
+    void TestCase__##name::testBody()
+
+/// @brief Register test for every type of type list: test case of type T is named "<name>/<T>", the type is
+/// accessible inside test body as 'TypeParam'.
+/// @code
+/// TYPED_TEST(containerIsEmptyByDefault, TypeList<std::vector<int>, std::list<int> >)
+/// {
+///     TypeParam container;
+///     isTrue(container.empty());
+/// }
+/// @endcode
+#define TYPED_TEST(name, ...)\
+    template<typename Type>\
+    struct TestCase__##name : YUNIT_NS_PREF(Test)\
+    {\
+        typedef Type TypeParam;\
+        virtual void testBody();\
+    };\
+    registerTypedTest(name, __VA_ARGS__)\
+    template<typename Type>\
+    void TestCase__##name<Type>::testBody()
+
+#define declareParamTest(name, ParamType)\
+    struct TestCase__##name : YUNIT_NS_PREF(Test)\
+    {\
+        typedef ParamType Param;\
+        explicit TestCase__##name(const Param &value) : param(value) {}\
+        virtual void testBody();\
+        const Param param;\
+    };
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////
 #define CONCAT(a, b) a ## b
@@ -73,9 +206,45 @@ YUNIT_NS_BEGIN
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////
 struct Test
 {
+    // fixture destructors play 'tearDown' role, so test object is deleted through this class pointer
+    virtual ~Test() {}
     virtual void testBody() = 0;
 };
 
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Hardware and OS counters of test body, measured by perf_counters.cpp
+enum PerfCounter
+{
+    perfCycles,
+    perfInstructions,
+    perfCacheMisses,
+    perfBranchMisses,
+    perfPageFaults,
+    perfCpuTimeNs,
+    perfCountersNumber
+};
+
+// Measurements of the last test execution (from 'setUp' start until 'tearDown' finish). They are valid inside
+// 'executeAllTests' callback.
+struct TestStats
+{
+    unsigned long long durationNs_;
+    unsigned long long allocations_;     // number of heap allocations
+    unsigned long long allocatedBytes_;
+    long long leakedBytes_;              // allocated and not freed bytes
+
+    // performance counters of 'testBody' (see perf_counters.h), indexed by PerfCounter
+    unsigned long long perf_[perfCountersNumber];
+    unsigned int perfAvailable_;         // bit mask of measured counters: (1 << PerfCounter)
+
+    // sampling profiler of 'testBody' (see profiler.h)
+    unsigned int profileSamples_;
+    unsigned long long profileOverheadNs_; // CPU time, spent by profiler itself
+
+    // 'setUp' or 'testBody' has been interrupted by crash signal (see TestRegistry::setCrashIsolation)
+    bool crashed_;
+};
+
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////
 struct TestCase : Test
 {
@@ -91,6 +260,8 @@ struct TestCase : Test
     const char* fileName_;
     const int lineNumber_;
 
+    TestStats stats_;
+
     static const char* unknownFileName_;
     static const int unknownLineNumber_;
     
@@ -106,9 +277,59 @@ struct TestRegistry
     virtual void add(TestCase* testCase) = 0;
     virtual void executeAllTests(void (*callback)(void *ctx, void *arg, void *data), void *ctx) = 0;
 
+    // Outcome and duration of every test are stored in history file after 'executeAllTests'. Tests, which have
+    // failed recently, have been changed or are flaky, are executed at first (see TestHistory::Priority).
+    // NULL disables history usage, so tests are executed in registration order; history is disabled by default.
+    virtual void setHistoryFile(const char *path) = 0;
+
+    // Directory, relative source paths of tests are resolved against to detect their changes for history (see
+    // TestHistory::setSourceRoot). NULL resolves them against current directory.
+    virtual void setSourceRoot(const char *dir) = 0;
+
+    // Execute tests in 'workers' threads; 'callback' calls are serialized. With history, tests are ordered
+    // longest first (LPT schedule) using their average duration; tests without history are expected to last
+    // 'setDefaultDuration' nanoseconds.
+    virtual void setNumberOfWorkers(unsigned int workers) = 0;
+    virtual void setDefaultDuration(unsigned long long durationNs) = 0;
+
+    // Successful test, which has not freed all memory, allocated by its thread between 'setUp' and 'tearDown',
+    // is reported with 'warning' event before 'success' one (leakCheckWarn) or as failed (leakCheckFail).
+    // Mode stays leakCheckOff, if allocator interposer is not linked into test program (see alloc_counter.h).
+    enum LeakCheck {leakCheckOff, leakCheckWarn, leakCheckFail};
+    virtual void setLeakCheck(LeakCheck mode) = 0;
+
+    // Write events of trace buffers (see trace.h) into 'path' in Chrome trace-event format. Every test is traced
+    // as span, buffers are flushed after every test. NULL disables tracing.
+    virtual void setTraceFile(const char *path) = 0;
+
+    // Convert crash signals of tests into failures (see crash_isolation.h). Crash, which can not be caught in
+    // process, restarts it with 'setResumeAfter' of crashed test, if tests are executed by one worker.
+    virtual void setCrashIsolation(bool enable) = 0;
+
+    // Report test 'name' as crashed and skip it with all tests, which are executed before it
+    virtual void setResumeAfter(const char *name) = 0;
+
+    // Results file of crashed process (see setResumeAfter), its tests are reported again, so summary and
+    // history of restarted process cover the whole run. File is reused as results file of this process, if
+    // 'setResultsFile' is not set, and it is removed at the end then.
+    virtual void setResumeResults(const char *path) = 0;
+
+    // Write outcome, duration and allocations of every executed test into 'path' (see test_results.h). NULL
+    // disables results file.
+    virtual void setResultsFile(const char *path) = 0;
+
+    // Execute only tests, which keys ('<file>\t<name>', one per line) are listed in file 'path'; key of
+    // parameterized or typed test family selects all its cases. NULL executes all tests. 'executeAllTests'
+    // throws std::runtime_error and executes nothing, if file can not be read.
+    virtual void setTestList(const char *path) = 0;
+
+    static const char *defaultHistoryFile;
+    enum {defaultDurationMs = 100};
+
     static const char *ignored; // const TestCase* will be passed as 'data' argument of 'callback'
     static const char *success; // const TestCase* will be passed as 'data' argument of 'callback'
     static const char *fail;    // FailCtx* will be passed as 'data' argument of 'callback'
+    static const char *warning; // FailCtx* will be passed as 'data' argument of 'callback'
 
     // FailCtx object will be passed as 'data' argument of 'callback' function, that must delete 'errmsg_' and 'FailCtx'
     struct FailCtx
@@ -123,6 +344,35 @@ struct TestRegistry
     };
 };
 
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Optional subsystem of test program (performance counters, profiler, fuzzing). Registry does not reference
+// subsystems: every one registers its extension by static object of own translation unit, so extension parses
+// its options and takes part in execution only, if subsystem is linked into test program.
+struct TestExtension
+{
+    TestExtension();
+
+    // @return true if command line option 'arg' belongs to extension
+    virtual bool parseOption(const char *arg);
+
+    // Called before the first test of 'executeAllTests'; @return false, if extension has nothing to do in this
+    // execution, then it is not called until the next one
+    virtual bool startExecution();
+    virtual void finishExecution();
+
+    // State of extension in worker thread, it is created before the first test of worker and destroyed after
+    // the last one by this thread
+    virtual void* openWorker();
+    virtual void closeWorker(void *worker);
+
+    // Called by worker thread around 'testBody' of every executed test
+    virtual void startBody(void *worker, TestCase *test);
+    virtual void stopBody(void *worker, TestCase *test);
+
+    TestExtension *next_;
+    static TestExtension *first_;   // list of registered extensions
+};
+
 // instead of pattern 'Monotone' use 'Singleton' pattern with public pointer to singleton object, because it is
 // more simple to change architecture for sintax 'singleton->method()', than 'Singleton::method()'
 extern TestRegistry *testRegistry;
@@ -134,6 +384,53 @@ void initTestRegistry();
 // destroy TestReginsty singleton object, for example, at exiting process
 void delTestRegistry();
 
+// configure test registry with command line options of test program:
+//   --history          store results of tests in TestRegistry::defaultHistoryFile and execute tests, which have
+//                      failed or have been changed recently, at first
+//   --history=<path>   the same as '--history' with <path> as history file
+//   --no-history       execute tests in registration order and do not store their results (default)
+//   --source-root=<dir> resolve relative source paths of tests against <dir> to detect their changes
+//   --jobs=<n>         execute tests in <n> threads
+//   --default-duration=<ms> expected duration of test, which has no history
+//   --leak-check=warn|fail  report tests, which leak heap memory (needs allocator interposer)
+//   --baselines        load and store 'assertNotSlowerThan' baselines in defaultBaselineFile, otherwise baselines
+//                      live in memory of process only
+//   --baselines=<path> the same as '--baselines' with <path> as baselines file
+//   --update-baselines record new baselines instead of comparison with stored ones
+//   --benchmark-history append benchmark results to defaultBenchmarkHistoryFile
+//   --benchmark-history=<path> the same as '--benchmark-history' with <path> as history file
+//   --no-benchmark-history     do not store benchmark results (default)
+//   --commit=<id>      revision of tested sources, stored with benchmark results
+//   --trace=<path>     write trace events of tests into <path>
+//   --property-cases=<n>   check every PROPERTY with <n> cases instead of propertyDefaultCases
+//   --property-seed=<n>    seed of PROPERTY cases generation, printed by failed property
+//   --property-threads=<n> check cases of every PROPERTY in <n> threads
+//   --crash-isolation      report crashed tests as failed and continue with the next test (Linux)
+//   --resume-after=<name>  skip tests up to crashed test <name>, used by restart of crashed process
+//   --resume-results=<path> results of tests before crash, used by restart of crashed process
+//   --results=<path>       write results of tests into <path>, they are merged by runner '--merge-results'
+//   --test-list=<path>     execute only tests, listed in <path>, used by runner '--work-for' worker
+//   --crash-record=<dir>   write record of crash, which kills process, into <dir> (implies --crash-isolation)
+// options of extensions, which are parsed only if extension is linked into test program:
+//   --perf-counters    measure hardware performance counters of every test body (perf_counters.cpp)
+//   --profile=<filter> sample stacks of tests, whose names contain <filter> (profiler.cpp)
+//   --profile-output=<path> write folded stacks to <path> instead of defaultProfileFile (profiler.cpp)
+//   --fuzz=<name>          mutate inputs of FUZZ_TEST <name> instead of its corpus replay (fuzz.cpp)
+//   --fuzz-corpus=<dir>    root of FUZZ_TEST corpus directories instead of defaultFuzzCorpus
+//   --fuzz-runs=<n>        stop fuzzing after <n> runs
+//   --fuzz-time=<seconds>  stop fuzzing after <seconds> instead of fuzzDefaultTimeSec (0 - no limit)
+//   --fuzz-minimize=<path> minimize crash input <path> of '--fuzz' target
+//   --fuzz-seed=<n>        seed of '--fuzz' mutations instead of clock
+// option, which is parsed neither by registry nor by linked extension, is reported as unknown
+// @return false, if some option is unknown or has wrong value (such options are reported on stderr and ignored)
+bool parseCommandLine(int argc, char **argv);
+
+// @return value of command line argument 'arg' of option 'option' ("--name="), or NULL for other option
+const char* optionValue(const char *arg, const char *option);
+
+// monotonic clock, used for test duration measurement
+unsigned long long currentTimeNs();
+
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /// @brief Register test case and delay original type object creation until execution
 /// @param TestClass type of real test class
@@ -177,6 +474,42 @@ struct RegisterTestCase : TestCase
     Test *test_;
 };
 
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief Constant data of test, which is registered without static constructor (see YUNIT_TEST_SECTION)
+struct TestDescriptor
+{
+    enum Flags
+    {
+        ignored = YUNIT_TEST_IGNORED,
+        generated = YUNIT_TEST_GENERATED
+    };
+
+    const char *name_;
+    const char *fileName_;
+    int lineNumber_;
+    unsigned int flags_;
+    Test* (*create_)();     ///< NULL for ignored test and generated family
+
+    // generated family (YUNIT_TEST_GENERATED) has 'cases_' test cases named "<name>/<suffix>", where suffix of
+    // case 'idx' is written by 'caseName_'
+    size_t cases_;
+    Test* (*createCase_)(size_t idx);
+    void (*caseName_)(size_t idx, char *buf, size_t bufSize);
+};
+
+template<typename TestClass>
+Test* createTest()
+{
+    return new TestClass;
+}
+
+/// @brief Case name suffix of parameterized test: index of its value
+void indexCaseName(size_t idx, char *buf, size_t bufSize);
+
+/// @brief Descriptors of all tests of "yunit_tests" section (in order of linkage)
+/// @return pointer to array of 'count' descriptor pointers
+const TestDescriptor* const* testDescriptors(size_t &count);
+
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Ignored test must not execute, so we may create stub TestCase instead of original type
 struct RegisterIgnoredTestCase : TestCase
@@ -198,6 +531,197 @@ struct RegisterIgnoredTestCase : TestCase
     virtual void tearDown() {}
 };
 
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Parameters source of TEST_P and TEST_P_ARRAY
+template<typename T>
+struct ParamArray
+{
+    explicit ParamArray(const T *values)
+    : values_(values)
+    {}
+
+    const T& operator()(size_t idx) const
+    {
+        return values_[idx];
+    }
+
+    const T *values_;
+};
+
+template<typename Array>
+struct ArrayElement
+{
+    typedef typename std::remove_cv<typename std::remove_reference<decltype(std::declval<Array>()[0])>::type>::type Type;
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief One value of parameterized test. Test object is created in own storage, so registration and
+/// execution of test case do not allocate heap memory.
+template<typename TestClass, typename Source>
+struct ParamTestCase : TestCase
+{
+    enum {maxNameSize = 128};
+
+    ParamTestCase(const char* name, const char* fileName, const int lineNumber, const Source &source, size_t idx)
+    : TestCase(fullName_, fileName, lineNumber)
+    , source_(source)
+    , idx_(idx)
+    , test_(NULL)
+    {
+        TS_SNPRINTF(fullName_, maxNameSize, "%s/%u", name, static_cast<unsigned int>(idx));
+        fullName_[maxNameSize - 1] = '\0';
+
+        initTestRegistry();
+        testRegistry->add(this);
+    }
+
+    ~ParamTestCase()
+    {
+        tearDown();
+    }
+
+    virtual bool ignored()
+    {
+        return false;
+    }
+
+    virtual void setUp()
+    {
+        test_ = new (&storage_) TestClass(source_(idx_));
+    }
+
+    virtual void testBody()
+    {
+        test_->testBody();
+    }
+
+    virtual void tearDown()
+    {
+        if (NULL != test_)
+            test_->~TestClass();
+        test_ = NULL;
+    }
+
+    char fullName_[maxNameSize];
+    Source source_;
+    size_t idx_;
+    TestClass *test_;
+    typename std::aligned_storage<sizeof(TestClass), std::alignment_of<TestClass>::value>::type storage_;
+};
+
+/// @brief Compile time expansion of 'Count' ParamTestCase members, the first value is registered at first
+template<typename TestClass, typename Source, size_t Count>
+struct RegisterParamTestCases : RegisterParamTestCases<TestClass, Source, Count - 1>
+{
+    typedef RegisterParamTestCases<TestClass, Source, Count - 1> Parent;
+
+    RegisterParamTestCases(const char* name, const char* fileName, const int lineNumber, const Source &source)
+    : Parent(name, fileName, lineNumber, source)
+    , case_(name, fileName, lineNumber, source, Count - 1)
+    {}
+
+    ParamTestCase<TestClass, Source> case_;
+};
+
+template<typename TestClass, typename Source>
+struct RegisterParamTestCases<TestClass, Source, 0>
+{
+    RegisterParamTestCases(const char* /*name*/, const char* /*fileName*/, const int /*lineNumber*/,
+                           const Source &/*source*/)
+    {}
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+template<typename... Types>
+struct TypeList
+{
+};
+
+// human readable name of type (demangled on GCC and Clang)
+void typeName(const std::type_info &type, char *buf, size_t bufSize);
+
+/// @brief Test case of one type of TYPED_TEST
+template<typename TestClass>
+struct RegisterTypedTestCase : RegisterTestCase<TestClass>
+{
+    enum {maxNameSize = 256};
+
+    RegisterTypedTestCase(const char* name, const char* fileName, const int lineNumber)
+    : RegisterTestCase<TestClass>(fullName_, fileName, lineNumber)
+    {
+        const int size = TS_SNPRINTF(fullName_, maxNameSize, "%s/", name);
+        if (size > 0 && size < maxNameSize)
+            typeName(typeid(typename TestClass::TypeParam), fullName_ + size, maxNameSize - size);
+        fullName_[maxNameSize - 1] = '\0';
+    }
+
+    char fullName_[maxNameSize];
+};
+
+/// @brief Compile time expansion of RegisterTypedTestCase members, one per type of list
+template<template<typename> class TestTemplate, typename List>
+struct RegisterTypedTestCases;
+
+template<template<typename> class TestTemplate, typename Type, typename... Types>
+struct RegisterTypedTestCases<TestTemplate, TypeList<Type, Types...> >
+{
+    RegisterTypedTestCases(const char* name, const char* fileName, const int lineNumber)
+    : case_(name, fileName, lineNumber)
+    , rest_(name, fileName, lineNumber)
+    {}
+
+    RegisterTypedTestCase<TestTemplate<Type> > case_;
+    RegisterTypedTestCases<TestTemplate, TypeList<Types...> > rest_;
+};
+
+template<template<typename> class TestTemplate>
+struct RegisterTypedTestCases<TestTemplate, TypeList<> >
+{
+    RegisterTypedTestCases(const char* /*name*/, const char* /*fileName*/, const int /*lineNumber*/)
+    {}
+};
+
+/// @brief Cases of TYPED_TEST family descriptor (see YUNIT_TEST_SECTION), case 'idx' is test of type 'idx' of list
+template<template<typename> class TestTemplate, typename List>
+struct TypedTestFactory;
+
+template<template<typename> class TestTemplate, typename Type, typename... Types>
+struct TypedTestFactory<TestTemplate, TypeList<Type, Types...> >
+{
+    typedef TypedTestFactory<TestTemplate, TypeList<Types...> > Rest;
+    enum {count = 1 + Rest::count};
+
+    static Test* create(size_t idx)
+    {
+        return (0 == idx) ? new TestTemplate<Type> : Rest::create(idx - 1);
+    }
+
+    static void caseName(size_t idx, char *buf, size_t bufSize)
+    {
+        if (0 == idx)
+            typeName(typeid(Type), buf, bufSize);
+        else
+            Rest::caseName(idx - 1, buf, bufSize);
+    }
+};
+
+template<template<typename> class TestTemplate>
+struct TypedTestFactory<TestTemplate, TypeList<> >
+{
+    enum {count = 0};
+
+    static Test* create(size_t /*idx*/)
+    {
+        return NULL;
+    }
+
+    static void caseName(size_t /*idx*/, char *buf, size_t bufSize)
+    {
+        if (bufSize > 0)
+            buf[0] = '\0';
+    }
+};
+
 YUNIT_NS_END
 
 #endif // _TESTS_YUNIT_HEADER_
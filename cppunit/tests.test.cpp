@@ -1,10 +1,41 @@
 #include "tests.h"
+#include "crash_isolation.h"
+#include "crash_record.h"
+#include "test_history.h"
+#include "test_manifest.h"
+#include "test_results.h"
+#include "alloc_counter.h"
+#include "perf_counters.h"
+#include "profiler.h"
+#include "property.h"
+#include "trace.h"
 #include "asserts.h"
+#include <algorithm>
 #include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <list>
+#include <string>
+#include <limits>
+#include <new>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+#  include <dirent.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#  include <utime.h>
+#endif
+
+#ifdef __GLIBC__
+#  include <malloc.h>
+#endif
 
 using namespace YUNIT_NS;
 
-int main(int /*argc*/, char ** /*argv*/)
+int main(int argc, char **argv)
 {
     struct TestResultHandler
     {
@@ -24,9 +55,10 @@ int main(int /*argc*/, char ** /*argv*/)
                 ++(self->ignoredTestCounter_);
             else if (TestRegistry::success == arg)
                 ++(self->successTestCounter_);
-            else if (TestRegistry::fail == arg)
+            else if (TestRegistry::fail == arg || TestRegistry::warning == arg)
             {
-                ++(self->failTestCounter_);
+                if (TestRegistry::fail == arg)
+                    ++(self->failTestCounter_);
                 TestRegistry::FailCtx *failCtx = static_cast<TestRegistry::FailCtx*>(data);
                 printf("%s\n", failCtx->errmsg_);
                 delete [] failCtx->errmsg_;
@@ -40,6 +72,8 @@ int main(int /*argc*/, char ** /*argv*/)
     }
     testCtx;
 
+    if (!parseCommandLine(argc, argv))
+        return 1;
     testRegistry->executeAllTests(TestResultHandler::onTestEvent, &testCtx); 
 
     printf("ignored - %u" "\n"
@@ -88,3 +122,760 @@ TEST1(failTestWithFixture, SampleFixture)
 {
     areEq(1, value_);
 }
+
+static const TestDescriptor* findDescriptor(const char *name)
+{
+    size_t count = 0;
+    const TestDescriptor* const* descriptors = testDescriptors(count);
+    for (size_t idx = 0; idx < count; ++idx)
+        if (0 == ::strcmp(name, descriptors[idx]->name_))
+            return descriptors[idx];
+    return NULL;
+}
+
+TEST(testsAreDescribedInSection)
+{
+#ifdef YUNIT_TEST_SECTION
+    const TestDescriptor *self = findDescriptor("testsAreDescribedInSection");
+    isNotNull(self);
+    areEq(__LINE__ - 5, self->lineNumber_);
+    areEq(0, ::strcmp(__FILE__, self->fileName_));
+    areEq(0u, self->flags_);
+    isNotNull(self->create_);
+
+    const TestDescriptor *ignored = findDescriptor("ignoredTest");
+    isNotNull(ignored);
+    areEq(static_cast<unsigned int>(TestDescriptor::ignored), ignored->flags_);
+    isNull(ignored->create_);
+#endif
+}
+
+TEST(manifestIsReadWithoutLoading)
+{
+#if defined(YUNIT_MANIFEST_SECTION) && defined(__linux__)
+    std::vector<ManifestTest> tests;
+    std::string error;
+    isTrue(readTestManifest("/proc/self/exe", tests, error));
+
+    size_t found = 0;
+    for (size_t idx = 0; idx < tests.size(); ++idx)
+    {
+        const ManifestTest &test = tests[idx];
+        if ("manifestIsReadWithoutLoading" == test.name_)
+        {
+            areEq(__LINE__ - 13, test.lineNumber_);
+            areEq(__FILE__, test.fileName_);
+            areEq(0u, test.flags_);
+            ++found;
+        }
+        else if ("ignoredTest" == test.name_)
+        {
+            areEq(static_cast<unsigned int>(YUNIT_TEST_IGNORED), test.flags_);
+            ++found;
+        }
+        else if ("parameterizedPrimes" == test.name_)
+        {
+            areEq(static_cast<unsigned int>(YUNIT_TEST_GENERATED), test.flags_);
+            ++found;
+        }
+    }
+    areEq(3u, found);
+
+    isFalse(readTestManifest(__FILE__, tests, error));
+    isFalse(error.empty());
+#endif
+}
+
+// unlike RegisterTestCase it is not added into test registry
+struct UnregisteredTestCase : TestCase
+{
+    UnregisteredTestCase(const char* name, const char* fileName, const int lineNumber)
+    : TestCase(name, fileName, lineNumber)
+    {}
+
+    virtual bool ignored()  { return false; }
+    virtual void setUp()    {}
+    virtual void testBody() {}
+    virtual void tearDown() {}
+};
+
+struct HistoryFixture
+{
+    HistoryFixture()
+    : stable_("stable", __FILE__, __LINE__)
+    , broken_("broken", __FILE__, __LINE__)
+    , unknown_("unknown", __FILE__, __LINE__)
+    , long_("long", __FILE__, __LINE__)
+    {
+        for (int run = 0; run < 5; ++run)
+        {
+            history_.record(&stable_, true, 1000);
+            history_.record(&broken_, run % 2, 2000);
+            history_.record(&long_, true, 5000);
+        }
+    }
+
+    UnregisteredTestCase stable_, broken_, unknown_, long_;
+    TestHistory history_;
+};
+
+TEST1(historyPutsRecentlyFailedAndNewTestsFirst, HistoryFixture)
+{
+    areEq(TestHistory::recentlyFailed, history_.priority(&broken_));
+    areEq(TestHistory::recentlyChanged, history_.priority(&unknown_));
+    areEq(TestHistory::usual, history_.priority(&stable_));
+}
+
+TEST1(historyKeepsAverageDuration, HistoryFixture)
+{
+    unsigned long long durationNs = 0;
+    isTrue(history_.duration(&stable_, durationNs));
+    areEq(1000, durationNs);
+    isFalse(history_.duration(&unknown_, durationNs));
+}
+
+#ifndef _WIN32
+TEST(historyResolvesRelativeSourceAgainstRoot)
+{
+    char root[] = "/tmp/yunit-history-XXXXXX";
+    isTrue(NULL != ::mkdtemp(root));
+    const std::string source = std::string(root) + "/changed.cpp";
+    FILE *file = ::fopen(source.c_str(), "w");
+    isTrue(NULL != file);
+    ::fclose(file);
+
+    // source is modified after the last run
+    struct utimbuf times;
+    times.actime = times.modtime = ::time(NULL) + 100;
+    ::utime(source.c_str(), &times);
+
+    UnregisteredTestCase changed("changed", "changed.cpp", __LINE__);
+    TestHistory history;
+    history.record(&changed, true, 1000);
+    const TestHistory::Priority withoutRoot = history.priority(&changed);
+    history.setSourceRoot(root);
+    const TestHistory::Priority withRoot = history.priority(&changed);
+
+    ::unlink(source.c_str());
+    ::rmdir(root);
+    areEq(TestHistory::usual, withoutRoot);
+    areEq(TestHistory::recentlyChanged, withRoot);
+}
+#endif
+
+TEST1(longestFirstOrderKeepsHistoryPriority, HistoryFixture)
+{
+    std::vector<TestCase*> tests;
+    tests.push_back(&stable_);
+    tests.push_back(&unknown_);
+    tests.push_back(&long_);
+    tests.push_back(&broken_);
+
+    // test without history is expected to be the longest, but changed tests go after recently failed ones
+    orderLongestFirst(history_, 1000000, tests);
+    areEq(&broken_, tests[0]);
+    areEq(&unknown_, tests[1]);
+    areEq(&long_, tests[2]);
+    areEq(&stable_, tests[3]);
+
+    // one worker keeps registration order inside every priority group
+    std::swap(tests[2], tests[3]);
+    orderByHistory(history_, tests);
+    areEq(&broken_, tests[0]);
+    areEq(&unknown_, tests[1]);
+    areEq(&stable_, tests[2]);
+    areEq(&long_, tests[3]);
+}
+
+TEST(resultLineIsParsedBack)
+{
+    TestResult result;
+    isTrue(parseTestResult("a.cpp\tsum\t12\tcrashed\t3\t4500\t7\t96\n", result));
+    areEq("a.cpp\tsum", result.key_);
+    areEq(12, result.lineNumber_);
+    areEq(outcomeCrashed, result.outcome_);
+    areEq(3, result.attempts_);
+    areEq(4500, result.durationNs_);
+    areEq(96, result.allocatedBytes_);
+
+    isFalse(parseTestResult("a.cpp\tsum\t12\tbroken\t1\t0\t0\t0\n", result));
+    isFalse(parseTestResult("a.cpp\tsum\n", result));
+}
+
+TEST(perfCountersAreWrittenIntoResult)
+{
+    TestResult result;
+    result.key_ = "a.cpp\tsum";
+    result.lineNumber_ = 12;
+    result.perf_[perfCycles] = 1000;
+    result.perf_[perfInstructions] = 2000;
+    result.perf_[perfCpuTimeNs] = 300;
+    result.perfAvailable_ = (1u << perfCycles) | (1u << perfInstructions) | (1u << perfCpuTimeNs);
+
+    FILE *file = ::tmpfile();
+    isNotNull(file);
+    isTrue(writeTestResult(file, result));
+    ::rewind(file);
+    char line[256] = "";
+    isNotNull(::fgets(line, sizeof(line), file));
+    ::fclose(file);
+    areEq("a.cpp\tsum\t12\tsuccess\t1\t0\t0\t0\tperf=1000,2000,-,-,-,300\n", std::string(line));
+
+    TestResult parsed;
+    isTrue(parseTestResult(line, parsed));
+    areEq(result.perfAvailable_, parsed.perfAvailable_);
+    areEq(2000, parsed.perf_[perfInstructions]);
+    areEq(300, parsed.perf_[perfCpuTimeNs]);
+
+    // results without counters have no field
+    isTrue(parseTestResult("a.cpp\tsum\t12\tsuccess\t1\t0\t0\t0\n", parsed));
+    areEq(0u, parsed.perfAvailable_);
+    isFalse(parseTestResult("a.cpp\tsum\t12\tsuccess\t1\t0\t0\t0\tperf=1,2\n", parsed));
+}
+
+TEST1(unreadableTestListIsError, HistoryFixture)
+{
+    std::vector<TestCase*> tests(1, &stable_);
+    isFalse(selectListed("no_such_dir/test_list.txt", tests));
+    areEq(1u, tests.size());
+}
+
+TEST(allocCounterCountsNewAndDelete)
+{
+    if (!allocCounterEnabled())
+        return;
+
+    static int * volatile ptr;
+    const AllocStats start = threadAllocStats();
+    ptr = new int(1);
+    const AllocStats allocated = threadAllocStats();
+    delete ptr;
+    const AllocStats finish = threadAllocStats();
+
+    areEq(start.allocations_ + 1, allocated.allocations_);
+    isTrue(allocated.outstandingBytes_ >= start.outstandingBytes_ + static_cast<long long>(sizeof(int)));
+    areEq(start.deallocations_ + 1, finish.deallocations_);
+    areEq(start.outstandingBytes_, finish.outstandingBytes_);
+}
+
+#ifdef __GLIBC__
+TEST(pageAlignedAllocationsAreCounted)
+{
+    if (!allocCounterEnabled())
+        return;
+
+    const AllocStats start = threadAllocStats();
+    void *page = ::valloc(16);
+    void *pages = ::pvalloc(16);
+    const AllocStats allocated = threadAllocStats();
+    ::free(page);
+    ::free(pages);
+    const AllocStats finish = threadAllocStats();
+
+    areEq(start.allocations_ + 2, allocated.allocations_);
+    areEq(start.deallocations_ + 2, finish.deallocations_);
+    areEq(start.outstandingBytes_, finish.outstandingBytes_);
+}
+#endif
+
+TEST(failedReallocDoesNotChangeAllocCounters)
+{
+    if (!allocCounterEnabled())
+        return;
+
+    void *ptr = ::malloc(16);
+    static volatile size_t hugeSize = ~static_cast<size_t>(0) / 2;
+    const AllocStats start = threadAllocStats();
+    void *res = ::realloc(ptr, hugeSize);
+    const AllocStats finish = threadAllocStats();
+    ::free(NULL != res ? res : ptr);
+
+    isNull(res);
+    areEq(start.allocations_, finish.allocations_);
+    areEq(start.deallocations_, finish.deallocations_);
+    areEq(start.outstandingBytes_, finish.outstandingBytes_);
+}
+
+static int newHandlerCalls = 0;
+
+static void uninstallingNewHandler()
+{
+    ++newHandlerCalls;
+    std::set_new_handler(NULL);
+}
+
+TEST(failedOperatorNewCallsNewHandler)
+{
+    if (!allocCounterEnabled())
+        return;
+
+    static volatile size_t hugeSize = ~static_cast<size_t>(0) / 2;
+    newHandlerCalls = 0;
+    const std::new_handler previous = std::set_new_handler(uninstallingNewHandler);
+    willThrow(::operator new(hugeSize), std::bad_alloc);
+    std::set_new_handler(uninstallingNewHandler);
+    isNull(::operator new(hugeSize, std::nothrow));
+    std::set_new_handler(previous);
+
+    areEq(2, newHandlerCalls);
+}
+
+TEST(allocationBudgetAsserts)
+{
+    static int * volatile ptr;
+    int value = 0;
+
+    noAllocations(++value);
+    assertMaxAllocations(1, ptr = new int(value); delete ptr);
+
+    if (allocCounterEnabled())
+    {
+        willThrow(noAllocations(ptr = new int(value); delete ptr), std::logic_error);
+        willThrow(assertMaxAllocations(1, ptr = new int[2]; delete [] ptr; ptr = new int; delete ptr), std::logic_error);
+    }
+}
+
+TEST(nestedAllocationBudgetKeepsStackOfOuterOne)
+{
+    if (!allocCounterEnabled())
+        return;
+
+    static int * volatile ptr;
+    AllocationBudget outer(0);
+    ptr = new int(1);
+    delete ptr;
+    {
+        AllocationBudget inner(10);
+        ptr = new int(2);
+        delete ptr;
+    }
+
+    isTrue(outer.exceeded());
+    try
+    {
+        outer.check("outer");
+    }
+    catch (std::logic_error &ex)
+    {
+        isNotNull(::strstr(ex.what(), "first exceeding allocation:"));
+        return;
+    }
+    isTrue(false);
+}
+
+static void writeToStderrAndAbort(const char *message)
+{
+    ::fprintf(stderr, "%s\n", message);
+    ::abort();
+}
+
+TEST(deathAssertsRunStatementInChild)
+{
+    int value = 1;
+
+#ifndef _WIN32
+    willDie(writeToStderrAndAbort("invariant is broken"), "invariant is b.*n");
+    willDie(::exit(2), "");
+    willDie(*static_cast<volatile int*>(NULL) = value, "");
+    willExit(::exit(3), 3);
+    willExit(::_Exit(0), 0);
+
+    willThrow(willDie(writeToStderrAndAbort("invariant is broken"), "other message"), std::logic_error);
+    willThrow(willDie(++value, ""), std::logic_error);
+    willThrow(willDie(throw std::runtime_error(""), ""), std::logic_error);
+    willThrow(willExit(::exit(3), 4), std::logic_error);
+    willThrow(willExit(writeToStderrAndAbort(""), 0), std::logic_error);
+    willThrow(willExit(++value, 0), std::logic_error);
+#endif
+
+    // statement is executed in child, so it does not change state of test
+    areEq(1, value);
+}
+
+#ifndef _WIN32
+static void sleepForever(void * /*ctx*/)
+{
+    for (;;)
+        ::pause();
+}
+
+TEST(hungDeathStatementIsKilled)
+{
+    const DeathStatus status = runInChild(sleepForever, NULL, 1);
+    areEq(DeathStatus::timedOut, status.kind_);
+    willThrow(checkDeath("statement", status, ""), std::logic_error);
+}
+#endif
+
+#ifdef YUNIT_CRASH_ISOLATION
+static void overflowStack(unsigned int depth)
+{
+    volatile char frame[16 * 1024];
+    frame[0] = static_cast<char>(depth);
+    if (depth < 1000000)
+        overflowStack(depth + 1);
+    frame[1] = frame[0];
+}
+
+TEST(crashTrapCatchesFaultOfTestCode)
+{
+    CrashHandlers handlers(true, false, NULL);
+    CrashAltStack altStack(true);
+    isTrue(crashIsolationEnabled());
+
+    {
+        CrashTrap trap("crashTrapCatchesFaultOfTestCode");
+        if (0 == sigsetjmp(trap.jump_, 1))
+            *static_cast<volatile int*>(NULL) = 1;
+
+        areEq(SIGSEGV, trap.signal_);
+        isNull(trap.address_);
+        isTrue(trap.stackDepth_ > 0);
+        isTrue(std::string::npos != trap.message().find("signal 11"));
+    }
+
+    // stack overflow is caught, because handler works on alternate stack
+    {
+        CrashTrap trap("crashTrapCatchesFaultOfTestCode");
+        if (0 == sigsetjmp(trap.jump_, 1))
+            overflowStack(0);
+
+        areEq(SIGSEGV, trap.signal_);
+    }
+}
+
+static void crashInThread()
+{
+    CrashHandlers handlers(true, false, NULL);
+    std::thread crashing([]() { *static_cast<volatile int*>(NULL) = 1; });
+    crashing.join();
+}
+
+// temporary directory of crash records, it is removed with records, even if test fails
+struct CrashRecordDirFixture
+{
+    CrashRecordDirFixture()
+    {
+        ::strcpy(dir_, "/tmp/yunit-crash-XXXXXX");
+        if (NULL == ::mkdtemp(dir_))
+            throw std::runtime_error("temporary directory can not be created");
+        setCrashRecordDir(dir_);
+    }
+
+    ~CrashRecordDirFixture()
+    {
+        setCrashRecordDir(NULL);
+        const std::vector<std::string> records = this->records();
+        for (size_t idx = 0; idx < records.size(); ++idx)
+            ::remove(records[idx].c_str());
+        ::rmdir(dir_);
+    }
+
+    std::vector<std::string> records() const
+    {
+        std::vector<std::string> records;
+        if (DIR *entries = ::opendir(dir_))
+        {
+            while (const struct dirent *entry = ::readdir(entries))
+                if ('.' != entry->d_name[0])
+                    records.push_back(std::string(dir_) + "/" + entry->d_name);
+            ::closedir(entries);
+        }
+        return records;
+    }
+
+    char dir_[32];
+};
+
+TEST1(crashRecordIsWrittenByCrashedProcess, CrashRecordDirFixture)
+{
+    willDie(crashInThread(), (std::string("crash record is written into ") + dir_ + "/crash-").c_str());
+
+    const std::vector<std::string> records = this->records();
+    areEq(1u, records.size());
+
+    CrashRecord record;
+    std::string error;
+    const bool read = readCrashRecord(records[0].c_str(), record, error);
+    isTrue(read);
+    areEq(SIGSEGV, record.header_.signal_);
+    areEq(0ULL, record.header_.faultAddress_);
+    isTrue(std::string::npos != record.maps_.find("tests_test"));
+
+    // crashed thread and main thread, waiting for it
+    areEq(2u, record.threads_.size());
+    areEq(1, record.threads_[0].crashed_);
+    areEq(0, record.threads_[1].crashed_);
+    for (size_t idx = 0; idx < record.threads_.size(); ++idx)
+    {
+        isTrue(record.threads_[idx].registersNumber_ > 0);
+        isTrue(record.threads_[idx].framesNumber_ > 0);
+        isTrue(record.stacks_[idx].size() > 0);
+    }
+}
+#endif
+
+TEST(perfCountersMeasureCallingThread)
+{
+    PerfCounters counters;
+    if (PerfCounters::sourceNone == counters.open())
+        return;
+
+    enum {pageSize = 4096, pages = 256};
+    static volatile char *memory;
+    unsigned long long values[perfCountersNumber];
+
+    counters.start();
+    memory = new char[pages * pageSize];
+    for (int idx = 0; idx < pages * pageSize; idx += pageSize)
+        memory[idx] = 1;
+    delete [] memory;
+    const unsigned int available = counters.stop(values);
+
+    isTrue(0 != available);
+    if (available & (1u << perfInstructions))
+        isTrue(values[perfInstructions] > 0);
+    if (available & (1u << perfCycles))
+        isTrue(values[perfCycles] > 0);
+}
+
+static unsigned long long profiledLoop(unsigned long long iterations)
+{
+    volatile unsigned long long sum = 0;
+    for (unsigned long long idx = 0; idx < iterations; ++idx)
+        sum += idx * idx;
+    return sum;
+}
+
+TEST(profilerSamplesCallingThread)
+{
+    ThreadProfiler profiler;
+    if (!profiler.open())
+        return;
+
+    profiler.start();
+    const unsigned long long startTime = currentTimeNs();
+    while (currentTimeNs() - startTime < 50000000ULL && profiler.samples() < 10)
+        profiledLoop(100000);
+    profiler.stop();
+
+    isTrue(profiler.samples() > 0);
+
+    FILE *file = ::tmpfile();
+    isNotNull(file);
+    profiler.writeFolded(file, "profiledTest");
+    ::rewind(file);
+
+    char line[4 * 1024];
+    isNotNull(::fgets(line, sizeof(line), file));
+    ::fclose(file);
+    areEq(0, ::strncmp(line, "profiledTest;", sizeof("profiledTest;") - 1));
+}
+
+TEST(traceEventsAreWrittenAsChromeJson)
+{
+    if (traceEnabled()) // test program itself is traced
+        return;
+
+    const char *path = "tests_test.trace.json";
+    isTrue(openTraceFile(path));
+    {
+        TraceSpan span("span \"quoted\"");
+        traceCounter("counter", 42);
+        traceMessage("message");
+    }
+    flushTrace();
+    traceMessage("after flush");
+    closeTraceFile();
+    traceMessage("not traced");
+
+    FILE *file = ::fopen(path, "r");
+    isNotNull(file);
+    char content[4 * 1024];
+    const size_t size = ::fread(content, 1, sizeof(content) - 1, file);
+    content[size] = '\0';
+    ::fclose(file);
+    ::remove(path);
+
+    areEq('[', content[0]);
+    isNotNull(::strstr(content, "{\"name\":\"span \\\"quoted\\\"\",\"ph\":\"B\""));
+    isNotNull(::strstr(content, "{\"name\":\"counter\",\"ph\":\"C\""));
+    isNotNull(::strstr(content, "\"args\":{\"value\":42}"));
+    isNotNull(::strstr(content, "{\"name\":\"message\",\"ph\":\"i\""));
+    isNotNull(::strstr(content, "\"ph\":\"E\""));
+    isNotNull(::strstr(content, "after flush"));
+    isNull(::strstr(content, "not traced"));
+    areEq(0, ::strcmp(content + size - 3, "\n]\n"));
+}
+
+static bool isPrime(int value)
+{
+    for (int divider = 2; divider * divider <= value; ++divider)
+        if (0 == value % divider)
+            return false;
+    return value > 1;
+}
+
+TEST_P(parameterizedPrimes, int, 2, 3, 5, 7, 11, 13)
+{
+    isTrue(isPrime(param));
+}
+
+static const char* const paramNames[] = {"first", "second"};
+
+TEST_P_ARRAY(parameterizedArray, paramNames)
+{
+    isNotNull(param);
+    isTrue(::strlen(param) > 0);
+}
+
+TEST_P_GEN(parameterizedPowersOfTwo, unsigned int, 8, [](size_t idx) { return 1u << idx; })
+{
+    areEq(0u, param & (param - 1));
+}
+
+#ifdef YUNIT_TEST_SECTION
+// sorted names of cases of test family 'name', as they are registered by its descriptor
+static std::vector<std::string> registeredCases(const char *name)
+{
+    std::vector<std::string> names;
+    size_t count = 0;
+    const TestDescriptor* const *descriptors = testDescriptors(count);
+    for (size_t idx = 0; idx < count; ++idx)
+    {
+        const TestDescriptor *descriptor = descriptors[idx];
+        if (0 != ::strcmp(name, descriptor->name_) || !(descriptor->flags_ & TestDescriptor::generated))
+            continue;
+
+        for (size_t caseIdx = 0; caseIdx < descriptor->cases_; ++caseIdx)
+        {
+            enum {suffixSize = 256};
+            char suffix[suffixSize] = "";
+            descriptor->caseName_(caseIdx, suffix, suffixSize);
+            suffix[suffixSize - 1] = '\0';
+            names.push_back(std::string(descriptor->name_) + '/' + suffix);
+        }
+    }
+
+    std::sort(names.begin(), names.end());
+    return names;
+}
+
+TEST(parameterizedCasesAreNamedByIndex)
+{
+    const std::vector<std::string> primes = registeredCases("parameterizedPrimes");
+    areEq(6u, primes.size());
+    for (size_t idx = 0; idx < primes.size(); ++idx)
+        areEq("parameterizedPrimes/" + std::to_string(idx), primes[idx]);
+
+    const std::vector<std::string> names = registeredCases("parameterizedArray");
+    areEq(2u, names.size());
+    areEq("parameterizedArray/0", names[0]);
+    areEq("parameterizedArray/1", names[1]);
+
+    areEq(8u, registeredCases("parameterizedPowersOfTwo").size());
+}
+#endif
+
+TYPED_TEST(typedIntegersAreSigned, TypeList<signed char, short, int, long, long long>)
+{
+    isTrue(std::numeric_limits<TypeParam>::is_integer);
+    isTrue(std::numeric_limits<TypeParam>::is_signed);
+    areEq(TypeParam(-1), TypeParam(TypeParam(0) - TypeParam(1)));
+}
+
+TYPED_TEST(typedContainersKeepOrder, TypeList<std::vector<int>, std::list<int>, std::deque<int> >)
+{
+    TypeParam container;
+    isTrue(container.empty());
+
+    for (int value = 0; value < 3; ++value)
+        container.push_back(value);
+
+    areEq(3u, container.size());
+    areEq(0, container.front());
+    areEq(2, container.back());
+}
+
+#ifdef YUNIT_TEST_SECTION
+TEST(typedCasesAreNamedByType)
+{
+    const std::vector<std::string> names = registeredCases("typedIntegersAreSigned");
+    areEq(5u, names.size());
+    areEq("typedIntegersAreSigned/int", names[0]);
+    areEq("typedIntegersAreSigned/long", names[1]);
+    areEq("typedIntegersAreSigned/long long", names[2]);
+    areEq("typedIntegersAreSigned/short", names[3]);
+    areEq("typedIntegersAreSigned/signed char", names[4]);
+
+    const std::vector<std::string> containers = registeredCases("typedContainersKeepOrder");
+    areEq(3u, containers.size());
+    for (size_t idx = 0; idx < containers.size(); ++idx)
+        isTrue(0 == containers[idx].find("typedContainersKeepOrder/std::"));
+}
+#endif
+
+PROPERTY(propertyReverseTwiceIsIdentity, Gen<std::vector<int> >)(const std::vector<int> &values)
+{
+    std::vector<int> copy(values.rbegin(), values.rend());
+    std::reverse(copy.begin(), copy.end());
+    return copy == values;
+}
+
+PROPERTY(propertyAdditionCommutes, Gen<int>, GenRange<int, -1000, 1000>)(const int &left, const int &right)
+{
+    areEq(static_cast<long long>(left) + right, static_cast<long long>(right) + left);
+    return true;
+}
+
+static bool hasNoLongSequence(const std::vector<int> &values, const std::string &/*label*/)
+{
+    return values.size() < 3;
+}
+
+static std::string propertyFailure()
+{
+    try
+    {
+        Property<Gen<std::vector<int> >, Gen<std::string> >::check("short", &hasNoLongSequence);
+    }
+    catch (std::logic_error &ex)
+    {
+        return ex.what();
+    }
+    return "";
+}
+
+// seed and threads of command line are restored after test, clock seed is kept unset
+struct PropertySettingsFixture
+{
+    PropertySettingsFixture()
+    : seed_(propertySeed())
+    , threads_(propertyThreads())
+    {
+    }
+
+    ~PropertySettingsFixture()
+    {
+        resetPropertySeed();
+        if (seed_ != propertySeed())
+            setPropertySeed(seed_);
+        setPropertyThreads(threads_);
+    }
+
+    unsigned long long seed_;
+    unsigned int threads_;
+};
+
+TEST1(propertyIsShrunkToMinimalCounterexample, PropertySettingsFixture)
+{
+    setPropertySeed(42);
+    setPropertyThreads(1);
+    const std::string failure = propertyFailure();
+    setPropertyThreads(4);
+    const std::string parallelFailure = propertyFailure();
+
+    isNotNull(::strstr(failure.c_str(), "--property-seed=42"));
+    isNotNull(::strstr(failure.c_str(), ": ([0, 0, 0], \"\")"));
+    areEq(failure, parallelFailure);
+}
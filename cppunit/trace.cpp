@@ -0,0 +1,260 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// trace.cpp
+//
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "trace.h"
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+
+#ifdef _WIN32
+#  include <windows.h>
+#  include <process.h>
+#  define getpid _getpid
+#else
+#  include <sys/mman.h>
+#  include <time.h>
+#  include <unistd.h>
+#endif
+
+YUNIT_NS_BEGIN
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// one cache line per event
+struct TraceEvent
+{
+    unsigned long long timeNs_;
+    double value_;
+    char type_;                         ///< Chrome trace-event phase: 'B', 'E', 'C' or 'i'
+    char name_[traceNameSize];
+};
+
+// Single producer (owner thread) and single consumer (flushTrace under file mutex) ring. Producer never waits:
+// when buffer is full, event is dropped.
+struct TraceBuffer
+{
+    std::atomic<unsigned int> head_;    ///< written by producer
+    std::atomic<unsigned int> tail_;    ///< written by consumer
+    std::atomic<unsigned int> dropped_;
+    unsigned int threadId_;
+    TraceBuffer *next_;
+    TraceEvent events_[traceBufferEvents];
+};
+
+static std::atomic<bool> traceOn(false);
+static std::atomic<TraceBuffer*> traceBuffers(NULL);    // list of all threads buffers
+static std::atomic<unsigned int> traceThreads(0);
+
+#ifdef _WIN32
+static __declspec(thread) TraceBuffer *threadTraceBuffer = NULL;
+#else
+static __thread TraceBuffer *threadTraceBuffer = NULL;
+#endif
+
+static unsigned long long traceTimeNs()
+{
+#ifdef _WIN32
+    LARGE_INTEGER frequency, counter;
+    ::QueryPerformanceFrequency(&frequency);
+    ::QueryPerformanceCounter(&counter);
+    return static_cast<unsigned long long>(counter.QuadPart / frequency.QuadPart) * 1000000000ULL
+         + static_cast<unsigned long long>(counter.QuadPart % frequency.QuadPart) * 1000000000ULL / frequency.QuadPart;
+#else
+    struct timespec ts;
+    ::clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<unsigned long long>(ts.tv_sec) * 1000000000ULL + ts.tv_nsec;
+#endif
+}
+
+// Buffers live until process exit, so consumer never reads released memory. They are mapped directly, so
+// they are neither counted as heap allocations of traced test nor reported as its leaks.
+static TraceBuffer* threadBuffer()
+{
+    if (NULL != threadTraceBuffer)
+        return threadTraceBuffer;
+
+#ifdef _WIN32
+    void *memory = ::VirtualAlloc(NULL, sizeof(TraceBuffer), MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+#else
+    void *memory = ::mmap(NULL, sizeof(TraceBuffer), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (MAP_FAILED == memory)
+        memory = NULL;
+#endif
+    if (NULL == memory)
+        return NULL;
+
+    TraceBuffer *buffer = static_cast<TraceBuffer*>(memory); // zero filled
+
+    buffer->threadId_ = ++traceThreads;
+    TraceBuffer *head = traceBuffers.load();
+    do
+        buffer->next_ = head;
+    while (!traceBuffers.compare_exchange_weak(head, buffer));
+
+    threadTraceBuffer = buffer;
+    return buffer;
+}
+
+static void traceEvent(char type, const char *name, double value)
+{
+    if (!traceOn.load(std::memory_order_relaxed))
+        return;
+
+    TraceBuffer *buffer = threadBuffer();
+    if (NULL == buffer)
+        return;
+
+    const unsigned int head = buffer->head_.load(std::memory_order_relaxed);
+    if (head - buffer->tail_.load(std::memory_order_acquire) >= traceBufferEvents)
+    {
+        buffer->dropped_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    TraceEvent &event = buffer->events_[head % traceBufferEvents];
+    event.timeNs_ = traceTimeNs();
+    event.value_ = value;
+    event.type_ = type;
+    ::strncpy(event.name_, NULL != name ? name : "", traceNameSize - 1);
+    event.name_[traceNameSize - 1] = '\0';
+
+    buffer->head_.store(head + 1, std::memory_order_release);
+}
+
+void traceBegin(const char *name)
+{
+    traceEvent('B', name, 0);
+}
+
+void traceEnd(const char *name)
+{
+    traceEvent('E', name, 0);
+}
+
+void traceCounter(const char *name, double value)
+{
+    traceEvent('C', name, value);
+}
+
+void traceMessage(const char *message)
+{
+    traceEvent('i', message, 0);
+}
+
+bool traceEnabled()
+{
+    return traceOn.load(std::memory_order_relaxed);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+struct TraceFile
+{
+    std::mutex mutex_;
+    FILE *file_;
+    bool firstEvent_;
+    unsigned long long startTimeNs_;    ///< timestamps are written relative to file opening
+};
+
+static TraceFile traceFile;
+
+static void writeJsonString(FILE *file, const char *str)
+{
+    ::fputc('"', file);
+    for (const unsigned char *ch = reinterpret_cast<const unsigned char*>(str); '\0' != *ch; ++ch)
+    {
+        if ('"' == *ch || '\\' == *ch)
+            ::fprintf(file, "\\%c", *ch);
+        else if (*ch < 0x20)
+            ::fprintf(file, "\\u%04x", *ch);
+        else
+            ::fputc(*ch, file);
+    }
+    ::fputc('"', file);
+}
+
+static void writeEvent(const TraceEvent &event, unsigned int threadId)
+{
+    FILE *file = traceFile.file_;
+    const double timeUs = (event.timeNs_ > traceFile.startTimeNs_ ? event.timeNs_ - traceFile.startTimeNs_ : 0) / 1000.;
+
+    ::fprintf(file, "%s{\"name\":", traceFile.firstEvent_ ? "\n" : ",\n");
+    writeJsonString(file, event.name_);
+    ::fprintf(file, ",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":%d,\"tid\":%u", event.type_, timeUs,
+              static_cast<int>(::getpid()), threadId);
+    if ('C' == event.type_)
+        ::fprintf(file, ",\"args\":{\"value\":%.17g}", event.value_);
+    else if ('i' == event.type_)
+        ::fprintf(file, ",\"s\":\"t\"");
+    ::fprintf(file, "}");
+
+    traceFile.firstEvent_ = false;
+}
+
+bool openTraceFile(const char *path)
+{
+    closeTraceFile();
+
+    std::lock_guard<std::mutex> lock(traceFile.mutex_);
+    traceFile.file_ = ::fopen(path, "w");
+    if (NULL == traceFile.file_)
+        return false;
+
+    ::fprintf(traceFile.file_, "[");
+    traceFile.firstEvent_ = true;
+    traceFile.startTimeNs_ = traceTimeNs();
+    traceOn.store(true);
+    return true;
+}
+
+static void drainBuffers()
+{
+    for (TraceBuffer *buffer = traceBuffers.load(); NULL != buffer; buffer = buffer->next_)
+    {
+        const unsigned int head = buffer->head_.load(std::memory_order_acquire);
+        unsigned int tail = buffer->tail_.load(std::memory_order_relaxed);
+
+        for (; tail != head; ++tail)
+        {
+            if (NULL != traceFile.file_)
+                writeEvent(buffer->events_[tail % traceBufferEvents], buffer->threadId_);
+        }
+        buffer->tail_.store(tail, std::memory_order_release);
+
+        const unsigned int dropped = buffer->dropped_.exchange(0, std::memory_order_relaxed);
+        if (0 != dropped && NULL != traceFile.file_)
+        {
+            TraceEvent event;
+            event.timeNs_ = traceTimeNs();
+            event.value_ = dropped;
+            event.type_ = 'C';
+            ::strcpy(event.name_, "dropped events");
+            writeEvent(event, buffer->threadId_);
+        }
+    }
+}
+
+void flushTrace()
+{
+    std::lock_guard<std::mutex> lock(traceFile.mutex_);
+    drainBuffers();
+    if (NULL != traceFile.file_)
+        ::fflush(traceFile.file_);
+}
+
+void closeTraceFile()
+{
+    std::lock_guard<std::mutex> lock(traceFile.mutex_);
+    if (NULL == traceFile.file_)
+        return;
+
+    traceOn.store(false);
+    drainBuffers();
+
+    ::fprintf(traceFile.file_, "\n]\n");
+    ::fclose(traceFile.file_);
+    traceFile.file_ = NULL;
+}
+
+YUNIT_NS_END
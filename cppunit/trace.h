@@ -0,0 +1,66 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// @file trace.h
+//
+// Low overhead tracing: every thread writes timestamped events (span begin/end, counter values, instant
+// messages) into its own lock-free ring buffer, so trace call is neither syscall nor lock. Buffers are drained
+// by 'flushTrace' into trace file in Chrome trace-event JSON format (chrome://tracing, Perfetto UI).
+// Test registry flushes buffers after every test, when '--trace=<path>' option is used.
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#ifndef _TRACE_YUNIT_HEADER_
+#define _TRACE_YUNIT_HEADER_
+
+#include "../yunit/yunit.h"
+
+YUNIT_NS_BEGIN
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief Start writing of events into 'path' file; trace calls do nothing until file is opened
+bool openTraceFile(const char *path);
+
+/// @brief Flush events and finish JSON document
+void closeTraceFile();
+
+bool traceEnabled();
+
+/// @brief Move events of all threads buffers into trace file
+/// @details Buffer has place for 'traceBufferEvents' events; events, which have not been placed, are dropped
+/// and their number is written as "dropped events" counter.
+void flushTrace();
+
+enum
+{
+    traceBufferEvents = 16 * 1024,
+    traceNameSize = 47              ///< longer names and messages are truncated
+};
+
+void traceBegin(const char *name);
+void traceEnd(const char *name);
+void traceCounter(const char *name, double value);
+void traceMessage(const char *message);
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief Trace span of current scope
+class TraceSpan
+{
+public:
+    explicit TraceSpan(const char *name)
+    : name_(name)
+    {
+        traceBegin(name_);
+    }
+
+    ~TraceSpan()
+    {
+        traceEnd(name_);
+    }
+
+private:
+    TraceSpan(const TraceSpan&);
+    TraceSpan& operator=(const TraceSpan&);
+
+    const char *name_;
+};
+
+YUNIT_NS_END
+
+#endif // _TRACE_YUNIT_HEADER_
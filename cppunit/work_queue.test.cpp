@@ -0,0 +1,209 @@
+#include "tests.h"
+#include "test_results.h"
+#include "../runner/work_queue.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// Program is both coordinator of loopback run and test container, which is executed by its workers (with
+// '--test-list' option). The first test, executed by any worker, blocks until its worker is killed, so its unit
+// must be reassigned to another worker.
+
+#define WORK_DIR_VARIABLE "YUNIT_WORK_QUEUE_DIR"
+
+static void blockFirstExecution()
+{
+    const std::string marker = std::string(::getenv(WORK_DIR_VARIABLE)) + "/started";
+    if (0 != ::mkdir(marker.c_str(), 0700))
+        return;
+
+    // orphan of killed worker finishes, so it does not outlive test
+    const pid_t worker = ::getppid();
+    enum {maxWaitMs = 30000, waitStepMs = 20};
+    for (int waited = 0; waited < maxWaitMs && ::getppid() == worker; waited += waitStepMs)
+        ::usleep(waitStepMs * 1000);
+}
+
+TEST(unitTest1) { blockFirstExecution(); }
+TEST(unitTest2) { blockFirstExecution(); }
+TEST(unitTest3) { blockFirstExecution(); }
+TEST(unitTest4) { blockFirstExecution(); }
+TEST(unitTest5) { blockFirstExecution(); }
+
+enum {testsNumber = 5};
+
+static int executeAsContainer(int argc, char **argv)
+{
+    using namespace YUNIT_NS;
+
+    struct TestResultHandler
+    {
+        static void onTestEvent(void *ctx, void *arg, void *data)
+        {
+            if (TestRegistry::fail != arg)
+                return;
+            ++*static_cast<int*>(ctx);
+            TestRegistry::FailCtx *failCtx = static_cast<TestRegistry::FailCtx*>(data);
+            printf("%s\n", failCtx->errmsg_);
+            delete [] failCtx->errmsg_;
+            delete failCtx;
+        }
+    };
+
+    int failed = 0;
+    if (!parseCommandLine(argc, argv))
+        return 1;
+    testRegistry->executeAllTests(TestResultHandler::onTestEvent, &failed);
+    return failed;
+}
+
+static unsigned short freeLoopbackPort()
+{
+    const int sock = ::socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in address;
+    ::memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t size = sizeof(address);
+    if (sock < 0 || 0 != ::bind(sock, reinterpret_cast<struct sockaddr*>(&address), sizeof(address))
+        || 0 != ::getsockname(sock, reinterpret_cast<struct sockaddr*>(&address), &size))
+        return 0;
+    ::close(sock);
+    return ntohs(address.sin_port);
+}
+
+// worker waits for byte of 'startPipe', so it is started by parent at the right moment
+static pid_t startWorker(const std::string &address, int startPipe)
+{
+    const pid_t pid = ::fork();
+    if (0 != pid)
+        return pid;
+
+    char go;
+    if (1 != ::read(startPipe, &go, 1))
+        _exit(1);
+    const std::vector<const char*> testArgs;
+    _exit(workForCoordinator(address.c_str(), testArgs) > 0 ? 0 : 1);
+}
+
+static bool waitForPath(const std::string &path)
+{
+    enum {maxWaitMs = 10000, waitStepMs = 20};
+    struct stat info;
+    for (int waited = 0; waited < maxWaitMs; waited += waitStepMs)
+    {
+        if (0 == ::stat(path.c_str(), &info))
+            return true;
+        ::usleep(waitStepMs * 1000);
+    }
+    return false;
+}
+
+struct CoordinatorRun
+{
+    static void run(CoordinatorRun *self)
+    {
+        self->failed_ = coordinateTests(self->containers_, self->options_);
+    }
+
+    std::vector<const char*> containers_;
+    CoordinatorOptions options_;
+    int failed_;
+};
+
+static int check(bool condition, const char *description)
+{
+    if (!condition)
+        fprintf(stderr, "work queue test has failed: %s\n", description);
+    return condition ? 0 : 1;
+}
+
+int main(int argc, char **argv)
+{
+    using namespace YUNIT_NS;
+
+    for (int argIdx = 1; argIdx < argc; ++argIdx)
+        if (0 == ::strncmp(argv[argIdx], "--test-list=", sizeof("--test-list=") - 1))
+            return executeAsContainer(argc, argv);
+
+    // hung coordinator fails test instead of blocking it
+    ::alarm(60);
+
+    char workDir[] = "/tmp/yunit-work-queue-XXXXXX";
+    if (NULL == ::mkdtemp(workDir))
+        return check(false, "work directory is not created");
+    ::setenv(WORK_DIR_VARIABLE, workDir, 1);
+    ::setenv("TMPDIR", workDir, 1); // files of units, which are left by killed worker
+
+    const unsigned short port = freeLoopbackPort();
+    char address[32];
+    snprintf(address, sizeof(address), "127.0.0.1:%u", port);
+
+    // workers are forked before coordinator thread starts
+    int startPipes[2][2];
+    if (0 != ::pipe(startPipes[0]) || 0 != ::pipe(startPipes[1]))
+        return check(false, "pipes are not created");
+    const pid_t killedWorker = startWorker(address, startPipes[0][0]);
+    const pid_t worker = startWorker(address, startPipes[1][0]);
+
+    // worker executes container by its path, which is the same program
+    const std::string resultsPath = std::string(workDir) + "/results.txt";
+    CoordinatorRun run;
+    run.containers_.push_back("/proc/self/exe");
+    run.options_.port_ = port;
+    run.options_.unitSize_ = 2;
+    run.options_.resultsPath_ = resultsPath.c_str();
+    run.failed_ = -1;
+    std::thread coordinator(&CoordinatorRun::run, &run);
+
+    int errors = 0;
+    const char go = 1;
+    errors += check(1 == ::write(startPipes[0][1], &go, 1), "the first worker is not started");
+    errors += check(waitForPath(std::string(workDir) + "/started"), "the first worker has not started unit");
+    ::kill(killedWorker, SIGKILL);
+    ::waitpid(killedWorker, NULL, 0);
+    errors += check(1 == ::write(startPipes[1][1], &go, 1), "the second worker is not started");
+
+    coordinator.join();
+    int status = 0;
+    ::waitpid(worker, &status, 0);
+    errors += check(0 == run.failed_, "coordinator has reported failed tests");
+    errors += check(WIFEXITED(status) && 0 == WEXITSTATUS(status), "the second worker has not executed units");
+
+    // every test is reported once, tests of reassigned unit are not crashed
+    std::map<std::string, int> successes;
+    FILE *file = ::fopen(resultsPath.c_str(), "r");
+    char line[1024];
+    while (NULL != file && ::fgets(line, sizeof(line), file))
+    {
+        TestResult result;
+        if (parseTestResult(line, result) && outcomeSuccess == result.outcome_)
+            ++successes[result.key_];
+    }
+    if (NULL != file)
+        ::fclose(file);
+    errors += check(testsNumber == successes.size(), "not all tests are reported as success");
+    for (std::map<std::string, int>::const_iterator it = successes.begin(); it != successes.end(); ++it)
+        errors += check(1 == it->second, "test is reported several times");
+
+    // orphan test program of killed worker finishes by itself
+    ::usleep(200 * 1000);
+    const std::string cleanup = std::string("rm -rf ") + workDir;
+    if (0 != ::system(cleanup.c_str()))
+        fprintf(stderr, "work directory %s is not removed\n", workDir);
+
+    printf("work queue loopback test: %s\n", 0 == errors ? "success" : "fail");
+    return errors;
+}
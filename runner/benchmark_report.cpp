@@ -0,0 +1,82 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// benchmark_report.cpp
+//
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "benchmark_report.h"
+#include "../cppunit/benchmark_store.h"
+#include <stdio.h>
+#include <string>
+
+#ifdef _WIN32
+#  define ENDL "\r\n"
+#else
+#  define ENDL "\n"
+#endif
+
+using YUNIT_NS_PREF(BenchmarkDelta);
+using YUNIT_NS_PREF(BenchmarkRecord);
+using YUNIT_NS_PREF(BenchmarkStore);
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+BenchmarkReportOptions::BenchmarkReportOptions()
+: storePath_(".yunit_benchmarks")
+, baselineCommit_(NULL)
+, currentCommit_(NULL)
+, threshold_(5)
+, confidence_(0.95)
+{
+}
+
+int reportBenchmarks(const BenchmarkReportOptions &options)
+{
+    BenchmarkStore store;
+    if (!store.load(options.storePath_))
+    {
+        fprintf(stderr, "Can not read benchmark history file '%s'" ENDL, options.storePath_);
+        return -1;
+    }
+
+    const std::string &machine = BenchmarkStore::machineFingerprint();
+    const std::string current = NULL != options.currentCommit_ ? options.currentCommit_ : store.lastCommit(machine);
+    const std::string baseline = NULL != options.baselineCommit_ ? options.baselineCommit_
+                                                                 : store.previousCommit(machine, current);
+    if (current.empty() || baseline.empty())
+    {
+        fprintf(stderr, "There are no results of two commits on machine %s" ENDL, machine.c_str());
+        return -1;
+    }
+
+    printf("Benchmarks of %s against %s (machine %s, %.0f%% confidence, threshold +%.1f%%)" ENDL,
+           current.c_str(), baseline.c_str(), machine.c_str(), options.confidence_ * 100, options.threshold_);
+
+    int compared = 0, regressions = 0;
+    const BenchmarkStore::Records &records = store.records();
+    for (BenchmarkStore::Records::const_iterator it = records.begin(), endIt = records.end(); it != endIt; ++it)
+    {
+        // every benchmark is reported once, by its last record
+        const BenchmarkRecord *currentRecord = store.find(it->key_, current, machine);
+        if (currentRecord != &*it)
+            continue;
+
+        const BenchmarkRecord *baselineRecord = store.find(it->key_, baseline, machine);
+        if (NULL == baselineRecord)
+        {
+            printf("  %-40s %12.1f ns  (new)" ENDL, it->key_.c_str(), currentRecord->mean_);
+            continue;
+        }
+
+        const BenchmarkDelta delta = BenchmarkStore::compare(*baselineRecord, *currentRecord, options.confidence_);
+        const bool regressed = delta.lower_ > options.threshold_;
+        printf("  %-40s %12.1f ns -> %12.1f ns  %+7.1f%% [%+7.1f%%, %+7.1f%%]%s" ENDL, it->key_.c_str(),
+               baselineRecord->mean_, currentRecord->mean_, delta.delta_, delta.lower_, delta.upper_,
+               regressed ? "  REGRESSION" : "");
+
+        ++compared;
+        if (regressed)
+            ++regressions;
+    }
+
+    printf("%d benchmarks compared, %d regressed" ENDL, compared, regressions);
+    return 0 == compared ? -1 : regressions;
+}
@@ -0,0 +1,27 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// @file benchmark_report.h
+//
+// Comparison of benchmark results of two commits (runner '--compare-benchmarks' mode)
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#ifndef _BENCHMARK_REPORT_HEADER_
+#define _BENCHMARK_REPORT_HEADER_
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+struct BenchmarkReportOptions
+{
+    BenchmarkReportOptions();
+
+    const char *storePath_;         ///< benchmark history file, written by test programs
+    const char *baselineCommit_;    ///< NULL means previous stored commit of this machine
+    const char *currentCommit_;     ///< NULL means last stored commit of this machine
+    double threshold_;              ///< allowed slowdown, percents
+    double confidence_;             ///< confidence level of intervals: 0.9, 0.95 or 0.99
+};
+
+/// @brief Print per-benchmark deltas of current commit against baseline one with confidence intervals
+/// @details Benchmark is regressed, if the whole confidence interval of its delta lies above threshold, so
+/// noisy measurements are not reported.
+/// @return Number of regressed benchmarks or -1, if there is nothing to compare
+int reportBenchmarks(const BenchmarkReportOptions &options);
+
+#endif // _BENCHMARK_REPORT_HEADER_
@@ -0,0 +1,245 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// bytecode_cache.cpp
+//
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "bytecode_cache.h"
+#include <atomic>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#  include <process.h>
+#  define getpid _getpid
+#else
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#endif
+
+static std::string cacheDir;
+static std::atomic<unsigned int> tmpFilesNumber(0);
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief Read-only contents of file: mapped on POSIX, read into buffer on Windows
+class MappedFile
+{
+public:
+    explicit MappedFile(const char *path)
+    : data_(NULL)
+    , size_(0)
+    {
+#ifdef _WIN32
+        FILE *file = ::fopen(path, "rb");
+        if (NULL == file)
+            return;
+        char chunk[4096];
+        size_t size;
+        while (0 < (size = ::fread(chunk, 1, sizeof(chunk), file)))
+            buf_.insert(buf_.end(), chunk, chunk + size);
+        ::fclose(file);
+        data_ = buf_.empty() ? "" : &buf_[0];
+        size_ = buf_.size();
+#else
+        const int fd = ::open(path, O_RDONLY);
+        if (fd < 0)
+            return;
+
+        struct stat info;
+        if (0 == ::fstat(fd, &info))
+        {
+            size_ = static_cast<size_t>(info.st_size);
+            void *data = (0 == size_) ? NULL : ::mmap(NULL, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (0 == size_)
+                data_ = "";
+            else if (MAP_FAILED != data)
+                data_ = static_cast<const char*>(data);
+        }
+        ::close(fd);
+#endif
+    }
+
+    ~MappedFile()
+    {
+#ifndef _WIN32
+        if (NULL != data_ && 0 != size_)
+            ::munmap(const_cast<char*>(data_), size_);
+#endif
+    }
+
+    bool opened() const
+    {
+        return NULL != data_;
+    }
+
+    const char *data_;
+    size_t size_;
+
+private:
+    MappedFile(const MappedFile&);
+    MappedFile& operator=(const MappedFile&);
+
+#ifdef _WIN32
+    std::vector<char> buf_;
+#endif
+};
+
+static uint64_t fnv1a(const char *data, size_t size)
+{
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t idx = 0; idx < size; ++idx)
+    {
+        hash ^= static_cast<unsigned char>(data[idx]);
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+static std::string cachePath(const char *path, const MappedFile &source)
+{
+    char name[96];
+    snprintf(name, sizeof(name), "/%016llx-%016llx-lua%d.luac",
+             static_cast<unsigned long long>(fnv1a(source.data_, source.size_)),
+             static_cast<unsigned long long>(fnv1a(path, ::strlen(path))), static_cast<int>(LUA_VERSION_NUM));
+    return cacheDir + name;
+}
+
+static int writeChunk(lua_State * /*L*/, const void *data, size_t size, void *file)
+{
+    return (size == ::fwrite(data, 1, size, static_cast<FILE*>(file))) ? 0 : 1;
+}
+
+// chunk on top of stack is written into temporary file, which replaces entry, so readers never see half of it;
+// name of temporary file is unique for process and for state of pool
+static void storeChunk(lua_State *L, const std::string &entryPath)
+{
+    char suffix[48];
+    snprintf(suffix, sizeof(suffix), ".%d.%u.tmp", static_cast<int>(::getpid()), tmpFilesNumber++);
+    const std::string tmpPath = entryPath + suffix;
+
+    FILE *file = ::fopen(tmpPath.c_str(), "wb");
+    if (NULL == file)
+        return;
+
+#if LUA_VERSION_NUM >= 503
+    const int rc = lua_dump(L, writeChunk, file, 0);
+#else
+    const int rc = lua_dump(L, writeChunk, file);
+#endif
+    const bool written = (0 == ::fclose(file)) && 0 == rc;
+
+#ifdef _WIN32
+    ::remove(entryPath.c_str());
+#endif
+    if (!written || 0 != ::rename(tmpPath.c_str(), entryPath.c_str()))
+        ::remove(tmpPath.c_str());
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void setBytecodeCacheDir(const char *dir)
+{
+    cacheDir = (NULL != dir) ? dir : "";
+}
+
+const char* bytecodeCacheDir()
+{
+    return cacheDir.empty() ? NULL : cacheDir.c_str();
+}
+
+int loadCachedFile(lua_State *L, const char *path)
+{
+    MappedFile source(path);
+    if (!source.opened())
+    {
+        lua_pushstring(L, (std::string("cannot open ") + path).c_str());
+        return LUA_ERRFILE;
+    }
+
+    const std::string chunkName = std::string("@") + path;
+    std::string entryPath;
+    if (!cacheDir.empty())
+    {
+        entryPath = cachePath(path, source);
+
+        MappedFile entry(entryPath.c_str());
+        if (entry.opened())
+        {
+            if (0 == luaL_loadbuffer(L, entry.data_, entry.size_, chunkName.c_str()))
+                return 0;
+            lua_pop(L, 1); // broken entry is replaced
+        }
+    }
+
+    // the first line of source is skipped like by 'luaL_loadfile', if it is '#!' line; its '\n' keeps numbers
+    // of lines
+    const char *text = source.data_;
+    size_t size = source.size_;
+    if (size > 0 && '#' == text[0])
+    {
+        const char *lineEnd = static_cast<const char*>(::memchr(text, '\n', size));
+        const size_t skipped = (NULL != lineEnd) ? static_cast<size_t>(lineEnd - text) : size;
+        text += skipped;
+        size -= skipped;
+    }
+
+    const int rc = luaL_loadbuffer(L, text, size, chunkName.c_str());
+    if (0 == rc && !entryPath.empty())
+        storeChunk(L, entryPath);
+    return rc;
+}
+
+int doCachedFile(lua_State *L, const char *path)
+{
+    const int rc = loadCachedFile(L, path);
+    return (0 != rc) ? rc : lua_pcall(L, 0, LUA_MULTRET, 0);
+}
+
+// original function is upvalue of cached one
+static int callOriginal(lua_State *L)
+{
+    lua_pushvalue(L, lua_upvalueindex(1));
+    lua_insert(L, 1);
+    lua_call(L, lua_gettop(L) - 1, LUA_MULTRET);
+    return lua_gettop(L);
+}
+
+static int cachedLoadfile(lua_State *L)
+{
+    if (1 != lua_gettop(L) || !lua_isstring(L, 1))
+        return callOriginal(L);
+
+    if (0 == loadCachedFile(L, lua_tostring(L, 1)))
+        return 1;
+    lua_pushnil(L);
+    lua_insert(L, -2);
+    return 2;
+}
+
+static int cachedDofile(lua_State *L)
+{
+    if (1 != lua_gettop(L) || !lua_isstring(L, 1))
+        return callOriginal(L);
+
+    if (0 != loadCachedFile(L, lua_tostring(L, 1)))
+        return lua_error(L);
+    lua_call(L, 0, LUA_MULTRET);
+    return lua_gettop(L) - 1;
+}
+
+void registerBytecodeCache(Lua::State &lua)
+{
+    if (cacheDir.empty())
+        return;
+
+    lua.getglobal("loadfile");
+    lua_pushcclosure(lua, cachedLoadfile, 1);
+    lua.setglobal("loadfile");
+
+    lua.getglobal("dofile");
+    lua_pushcclosure(lua, cachedDofile, 1);
+    lua.setglobal("dofile");
+}
@@ -0,0 +1,34 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// @file bytecode_cache.h
+//
+// Cache of compiled Lua chunks (runner '--bytecode-cache <dir>'). Chunk of source file is stored by
+// 'lua_dump' into '<dir>/<content hash>-<path hash>-lua<version>.luac', where hashes are 64-bit FNV-1a of
+// source text and of its path (path is kept in debug information of chunk). Source and cached chunk are
+// mapped into memory and loaded by 'luaL_loadbuffer', so neither of them is copied. Changed source has new
+// key, so its chunk is compiled again; old entries are not removed, directory may be cleaned at any time.
+//
+// Runner loads its main script through cache, Lua engines may use 'loadCachedFile' for containers.
+// Entry is written into temporary file and renamed, so several runners and states of pool may share cache.
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#ifndef _BYTECODE_CACHE_HEADER_
+#define _BYTECODE_CACHE_HEADER_
+
+#include "lua_wrapper.h"
+
+/// @brief Directory of cache, NULL disables it
+void setBytecodeCacheDir(const char *dir);
+const char* bytecodeCacheDir();
+
+/// @brief Load Lua file 'path' as function on top of stack like 'luaL_loadfile', using cache if it is enabled
+/// @return 0 or error code of Lua with error message on top of stack
+int loadCachedFile(lua_State *L, const char *path);
+
+/// @brief Load and call Lua file 'path' like 'luaL_dofile', using cache if it is enabled
+int doCachedFile(lua_State *L, const char *path);
+
+/// @brief Replace global 'loadfile' and 'dofile' of state by cached ones, if cache is enabled, so Lua test
+/// containers, loaded by scripts, are cached too. Call without file name or with mode and environment
+/// arguments is passed to original function.
+void registerBytecodeCache(Lua::State &lua);
+
+#endif // _BYTECODE_CACHE_HEADER_
@@ -0,0 +1,272 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// crash_report.cpp
+//
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "crash_report.h"
+#include "../cppunit/crash_record.h"
+#include <map>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#if defined(__linux__) || defined(__FreeBSD__)
+#  include <elf.h>
+#endif
+
+#ifdef _WIN32
+#  define ENDL "\r\n"
+#  define popen _popen
+#  define pclose _pclose
+#else
+#  define ENDL "\n"
+#endif
+
+using YUNIT_NS_PREF(CrashRecord);
+using YUNIT_NS_PREF(CrashRecordThread);
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+struct Mapping
+{
+    unsigned long long begin_;
+    unsigned long long end_;
+    unsigned long long offset_;
+    std::string path_;
+};
+
+static std::vector<Mapping> parseMaps(const std::string &maps)
+{
+    std::vector<Mapping> mappings;
+    for (size_t pos = 0; pos < maps.size(); )
+    {
+        size_t lineEnd = maps.find('\n', pos);
+        if (std::string::npos == lineEnd)
+            lineEnd = maps.size();
+        const std::string line = maps.substr(pos, lineEnd - pos);
+        pos = lineEnd + 1;
+
+        // <begin>-<end> <perms> <offset> <device> <inode> <path>
+        Mapping mapping;
+        char perms[8];
+        int pathPos = 0;
+        if (4 != ::sscanf(line.c_str(), "%llx-%llx %7s %llx %*s %*s %n", &mapping.begin_, &mapping.end_, perms,
+                          &mapping.offset_, &pathPos)
+            || 'x' != perms[2] || 0 == pathPos || '/' != line[pathPos])
+            continue;
+
+        mapping.path_ = line.substr(pathPos);
+        mappings.push_back(mapping);
+    }
+    return mappings;
+}
+
+static const Mapping* findMapping(const std::vector<Mapping> &mappings, unsigned long long address)
+{
+    for (size_t idx = 0; idx < mappings.size(); ++idx)
+        if (mappings[idx].begin_ <= address && address < mappings[idx].end_)
+            return &mappings[idx];
+    return NULL;
+}
+
+/// @brief Loadable segments of ELF file: file offset -> link time address
+class ElfSegments
+{
+public:
+    explicit ElfSegments(const std::string &path)
+    {
+#if defined(__linux__) || defined(__FreeBSD__)
+        FILE *file = ::fopen(path.c_str(), "rb");
+        if (NULL == file)
+            return;
+
+        unsigned char ident[EI_NIDENT];
+        if (1 == ::fread(ident, sizeof(ident), 1, file) && 0 == ::memcmp(ident, ELFMAG, SELFMAG))
+        {
+            ::rewind(file);
+            if (ELFCLASS64 == ident[EI_CLASS])
+                read<Elf64_Ehdr, Elf64_Phdr>(file);
+            else if (ELFCLASS32 == ident[EI_CLASS])
+                read<Elf32_Ehdr, Elf32_Phdr>(file);
+        }
+        ::fclose(file);
+#else
+        (void)path;
+#endif
+    }
+
+    bool address(unsigned long long fileOffset, unsigned long long &address) const
+    {
+        for (size_t idx = 0; idx < segments_.size(); ++idx)
+        {
+            const Segment &segment = segments_[idx];
+            if (segment.offset_ <= fileOffset && fileOffset < segment.offset_ + segment.size_)
+            {
+                address = fileOffset - segment.offset_ + segment.address_;
+                return true;
+            }
+        }
+        return false;
+    }
+
+private:
+    struct Segment
+    {
+        unsigned long long offset_;
+        unsigned long long size_;
+        unsigned long long address_;
+    };
+
+#if defined(__linux__) || defined(__FreeBSD__)
+    template<typename Ehdr, typename Phdr>
+    void read(FILE *file)
+    {
+        Ehdr header;
+        if (1 != ::fread(&header, sizeof(header), 1, file) || sizeof(Phdr) != header.e_phentsize
+            || 0 != ::fseek(file, static_cast<long>(header.e_phoff), SEEK_SET))
+            return;
+
+        for (unsigned int idx = 0; idx < header.e_phnum; ++idx)
+        {
+            Phdr programHeader;
+            if (1 != ::fread(&programHeader, sizeof(programHeader), 1, file))
+                return;
+            if (PT_LOAD != programHeader.p_type)
+                continue;
+
+            Segment segment = {programHeader.p_offset, programHeader.p_filesz, programHeader.p_vaddr};
+            segments_.push_back(segment);
+        }
+    }
+#endif
+
+    std::vector<Segment> segments_;
+};
+
+typedef std::map<unsigned long long, std::string> Symbols; // runtime address -> "function at file:line"
+
+static std::string shellQuoted(const std::string &str)
+{
+    std::string quoted = "'";
+    for (size_t idx = 0; idx < str.size(); ++idx)
+        quoted += ('\'' == str[idx]) ? std::string("'\\''") : std::string(1, str[idx]);
+    return quoted + "'";
+}
+
+// one 'addr2line' call for all addresses of module
+static void symbolizeModule(const std::string &path, const std::vector<unsigned long long> &addresses,
+                            const std::vector<unsigned long long> &linkAddresses, Symbols &symbols)
+{
+    std::string command = "addr2line -C -f -e " + shellQuoted(path);
+    char buf[32];
+    for (size_t idx = 0; idx < linkAddresses.size(); ++idx)
+    {
+        ::snprintf(buf, sizeof(buf), " 0x%llx", linkAddresses[idx]);
+        command += buf;
+    }
+
+    FILE *output = ::popen(command.c_str(), "r");
+    if (NULL == output)
+        return;
+
+    char function[1024], location[1024];
+    for (size_t idx = 0; idx < addresses.size(); ++idx)
+    {
+        if (NULL == ::fgets(function, sizeof(function), output) || NULL == ::fgets(location, sizeof(location), output))
+            break;
+        function[::strcspn(function, "\r\n")] = '\0';
+        location[::strcspn(location, "\r\n")] = '\0';
+        symbols[addresses[idx]] = std::string(function) + " at " + location;
+    }
+    ::pclose(output);
+}
+
+// the first frame is interrupted instruction, others are return addresses, which point after call instruction,
+// so previous byte is looked up for them
+static unsigned long long lookupAddress(const CrashRecordThread &thread, unsigned int frameIdx)
+{
+    return 0 == frameIdx ? thread.frames_[frameIdx] : thread.frames_[frameIdx] - 1;
+}
+
+static Symbols symbolize(const CrashRecord &record, const std::vector<Mapping> &mappings)
+{
+    std::map<std::string, std::pair<std::vector<unsigned long long>, std::vector<unsigned long long> > > modules;
+
+    for (size_t threadIdx = 0; threadIdx < record.threads_.size(); ++threadIdx)
+    {
+        const CrashRecordThread &thread = record.threads_[threadIdx];
+        for (unsigned int frameIdx = 0; frameIdx < thread.framesNumber_; ++frameIdx)
+        {
+            const unsigned long long address = lookupAddress(thread, frameIdx);
+            const Mapping *mapping = findMapping(mappings, address);
+            if (NULL == mapping)
+                continue;
+
+            modules[mapping->path_].first.push_back(address);
+            modules[mapping->path_].second.push_back(address - mapping->begin_ + mapping->offset_);
+        }
+    }
+
+    Symbols symbols;
+    for (std::map<std::string, std::pair<std::vector<unsigned long long>, std::vector<unsigned long long> > >::iterator
+         it = modules.begin(), endIt = modules.end(); it != endIt; ++it)
+    {
+        const ElfSegments segments(it->first);
+        std::vector<unsigned long long> &offsets = it->second.second;
+        for (size_t idx = 0; idx < offsets.size(); ++idx)
+            if (!segments.address(offsets[idx], offsets[idx]))
+                offsets[idx] = 0;
+        symbolizeModule(it->first, it->second.first, offsets, symbols);
+    }
+    return symbols;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+bool printCrashReport(const char *path)
+{
+    CrashRecord record;
+    std::string error;
+    if (!YUNIT_NS_PREF(readCrashRecord)(path, record, error))
+    {
+        fprintf(stderr, "%s" ENDL, error.c_str());
+        return false;
+    }
+
+    const std::vector<Mapping> mappings = parseMaps(record.maps_);
+    const Symbols symbols = symbolize(record, mappings);
+
+    printf("process %u has crashed with signal %d (code %d) at address 0x%llx" ENDL, record.header_.pid_,
+           record.header_.signal_, record.header_.code_, static_cast<unsigned long long>(record.header_.faultAddress_));
+    if ('\0' != record.header_.test_[0])
+        printf("test \"%s\" has been executed" ENDL, record.header_.test_);
+
+    for (size_t threadIdx = 0; threadIdx < record.threads_.size(); ++threadIdx)
+    {
+        const CrashRecordThread &thread = record.threads_[threadIdx];
+        printf(ENDL "thread %d%s" ENDL, thread.tid_, thread.crashed_ ? " (crashed)" : "");
+
+        for (unsigned int idx = 0; idx < thread.registersNumber_; ++idx)
+        {
+            printf("%s%8s 0x%016llx", 0 == idx % 4 ? "   " : "", YUNIT_NS_PREF(crashRegisterName)(idx).c_str(),
+                   static_cast<unsigned long long>(thread.registers_[idx]));
+            if (3 == idx % 4 || idx + 1 == thread.registersNumber_)
+                printf(ENDL);
+        }
+
+        for (unsigned int frameIdx = 0; frameIdx < thread.framesNumber_; ++frameIdx)
+        {
+            const unsigned long long address = lookupAddress(thread, frameIdx);
+            const Mapping *mapping = findMapping(mappings, address);
+            const Symbols::const_iterator symbol = symbols.find(address);
+
+            printf("    #%-2u 0x%016llx %s (%s)" ENDL, frameIdx, static_cast<unsigned long long>(thread.frames_[frameIdx]),
+                   symbols.end() != symbol ? symbol->second.c_str() : "??",
+                   NULL != mapping ? mapping->path_.c_str() : "unknown module");
+        }
+
+        printf("    stack: %llu bytes at 0x%llx" ENDL, static_cast<unsigned long long>(thread.stackSize_),
+               static_cast<unsigned long long>(thread.stackAddress_));
+    }
+
+    return true;
+}
@@ -0,0 +1,16 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// @file crash_report.h
+//
+// Offline symbolization of crash record of test process (runner '--crash-report' mode, see
+// cppunit/crash_record.h). It must be executed on machine, where record has been written, with the same
+// binaries, because frames are symbolized by 'addr2line' with files of recorded memory map.
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#ifndef _CRASH_REPORT_HEADER_
+#define _CRASH_REPORT_HEADER_
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief Print signal, crashed test, registers and symbolized call stack of every thread of 'path' record
+/// @return false, if record can not be read
+bool printCrashReport(const char *path);
+
+#endif // _CRASH_REPORT_HEADER_
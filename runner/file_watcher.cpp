@@ -0,0 +1,285 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// file_watcher.cpp
+//
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#include "file_watcher.h"
+
+#ifdef __linux__
+#  include <sys/inotify.h>
+#  include <poll.h>
+#  include <unistd.h>
+#  include <limits.h>
+#  include <errno.h>
+#endif
+
+#include <string.h>
+#include <stdlib.h>
+#include <algorithm>
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#ifdef __linux__
+
+static void splitPath(const char *path, std::string &dir, std::string &base)
+{
+    const char *slash = ::strrchr(path, '/');
+    if (NULL == slash)
+    {
+        dir = ".";
+        base = path;
+    }
+    else
+    {
+        dir.assign(path, slash == path ? 1 : slash - path);
+        base = slash + 1;
+    }
+}
+
+static std::string absPath(const std::string &path)
+{
+    char buffer[PATH_MAX];
+    return NULL != ::realpath(path.c_str(), buffer) ? std::string(buffer) : path;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+FileWatcher::FileWatcher()
+: fd_(-1)
+{
+}
+
+FileWatcher::~FileWatcher()
+{
+    if (-1 != fd_)
+        ::close(fd_);
+}
+
+bool FileWatcher::initialize()
+{
+    fd_ = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (-1 == fd_)
+    {
+        setError("inotify_init1");
+        return false;
+    }
+    return true;
+}
+
+const char* FileWatcher::error() const
+{
+    return error_.c_str();
+}
+
+void FileWatcher::setError(const char *prefix)
+{
+    error_ = prefix;
+    error_ += ": ";
+    error_ += ::strerror(errno);
+}
+
+int FileWatcher::addWatch(const std::string &dirPath)
+{
+    // IN_CLOSE_WRITE - file rewritten in place
+    // IN_MOVED_TO, IN_CREATE - file replaced by rename or by unlink + create (usual linker behaviour)
+    const int wd = ::inotify_add_watch(fd_, dirPath.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+    if (-1 == wd)
+        setError(dirPath.c_str());
+    else
+        dirs_[wd].path_ = dirPath; // inotify returns the same descriptor for directory, watched twice
+    return wd;
+}
+
+bool FileWatcher::watchFile(const char *path, std::string &watchedPath)
+{
+    std::string dir, base;
+    splitPath(path, dir, base);
+
+    const std::string absDir = absPath(dir);
+    const int wd = addWatch(absDir);
+    if (-1 == wd)
+        return false;
+
+    watchedPath = absDir + '/' + base;
+    std::vector<std::string> &files = dirs_[wd].files_;
+    if (files.end() == std::find(files.begin(), files.end(), base))
+        files.push_back(base);
+    return true;
+}
+
+bool FileWatcher::readEvents(std::vector<std::string> &changed)
+{
+    enum {bufferSize = 64 * 1024};
+    char buffer[bufferSize] __attribute__ ((aligned(__alignof__(struct inotify_event))));
+
+    for (;;)
+    {
+        const ssize_t len = ::read(fd_, buffer, bufferSize);
+        if (-1 == len)
+        {
+            if (EAGAIN == errno)
+                return true;
+            setError("read inotify events");
+            return false;
+        }
+
+        for (const char *ptr = buffer; ptr < buffer + len; )
+        {
+            const struct inotify_event *event = reinterpret_cast<const struct inotify_event*>(ptr);
+            ptr += sizeof(struct inotify_event) + event->len;
+
+            WatchedDirs::iterator it = dirs_.find(event->wd);
+            if (dirs_.end() == it || 0 == event->len)
+                continue;
+
+            const WatchedDir &dir = it->second;
+            if ((event->mask & IN_ISDIR)
+                || dir.files_.end() == std::find(dir.files_.begin(), dir.files_.end(), event->name))
+            {
+                continue;
+            }
+
+            const std::string path = dir.path_ + '/' + event->name;
+
+            if (changed.end() == std::find(changed.begin(), changed.end(), path))
+                changed.push_back(path);
+        }
+    }
+}
+
+bool FileWatcher::wait(int timeoutMs, std::vector<std::string> &changed)
+{
+    error_.clear();
+
+    struct pollfd pfd;
+    pfd.fd = fd_;
+    pfd.events = POLLIN;
+
+    int timeout = timeoutMs;
+    for (;;)
+    {
+        pfd.revents = 0;
+        const int rc = ::poll(&pfd, 1, timeout);
+        if (-1 == rc)
+        {
+            if (EINTR == errno)
+                continue;
+            setError("poll");
+            return false;
+        }
+
+        if (0 == rc)
+            return true; // timeout without changes or files become quiet
+
+        if (!readEvents(changed))
+            return false;
+
+        // events about not watched files of watched directories must not start settle period
+        if (!changed.empty())
+            timeout = settleTimeMs;
+    }
+}
+
+#else // __linux__
+
+FileWatcher::FileWatcher()
+: fd_(-1)
+{
+}
+
+FileWatcher::~FileWatcher()
+{
+}
+
+bool FileWatcher::initialize()
+{
+    error_ = "watch mode is supported on Linux only";
+    return false;
+}
+
+const char* FileWatcher::error() const
+{
+    return error_.c_str();
+}
+
+bool FileWatcher::watchFile(const char *, std::string&)
+{
+    return false;
+}
+
+bool FileWatcher::wait(int, std::vector<std::string>&)
+{
+    return false;
+}
+
+#endif // __linux__
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+LUA_CONSTRUCTOR(FileWatcher)
+{
+    using namespace Lua;
+
+    FileWatcher *watcher = new FileWatcher;
+    if (watcher->initialize())
+    {
+        LUA_PUSH(watcher, FileWatcher);
+        return 1;
+    }
+
+    lua.push(Nil);
+    lua.push(watcher->error());
+    delete watcher;
+    return 2;
+}
+
+LUA_DESTRUCTOR(FileWatcher)
+{
+    enum Args {selfIdx = 1};
+    delete lua.to<FileWatcher*>(selfIdx);
+    LUA_GC(selfIdx);
+    return 0;
+}
+
+LUA_METHOD(FileWatcher, watchFile)
+{
+    enum Args {selfIdx = 1, pathIdx};
+    LUA_CHECK_ARG(string, const char*, pathIdx);
+
+    FileWatcher *watcher = lua.to<FileWatcher*>(selfIdx);
+    std::string watchedPath;
+    if (watcher->watchFile(lua.to<const char*>(pathIdx), watchedPath))
+    {
+        lua.push(watchedPath);
+        return 1;
+    }
+
+    lua.push(Lua::Nil);
+    lua.push(watcher->error());
+    return 2;
+}
+
+LUA_METHOD(FileWatcher, wait)
+{
+    enum Args {selfIdx = 1, timeoutIdx};
+
+    FileWatcher *watcher = lua.to<FileWatcher*>(selfIdx);
+    const int timeoutMs = lua.isnumber(timeoutIdx) ? static_cast<int>(lua.to<unsigned long>(timeoutIdx)) : -1;
+
+    std::vector<std::string> changed;
+    if (!watcher->wait(timeoutMs, changed))
+    {
+        lua.push(Lua::Nil);
+        lua.push(watcher->error());
+        return 2;
+    }
+
+    lua.push(Lua::Table(static_cast<int>(changed.size())));
+    const int changedTableIdx = lua.top();
+    int changedIdx = 0;
+
+    for (std::vector<std::string>::const_iterator it = changed.begin(), endIt = changed.end(); it != endIt; ++it)
+    {
+        lua.push(++changedIdx);
+        lua.push(*it);
+        lua.settable(changedTableIdx);
+    }
+
+    return 1;
+}
@@ -0,0 +1,80 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// @file file_watcher.h
+//
+// Watch test container files for changes (used by runner '--watch' mode)
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#ifndef _FILE_WATCHER_HEADER_
+#define _FILE_WATCHER_HEADER_
+
+#include "lua_wrapper.h"
+#include <string>
+#include <vector>
+#include <map>
+
+class FileWatcher;
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief Report which of watched files have been changed since last 'wait' call
+/// @details Linux implementation is based on inotify. Watched files are tracked through watch of their
+/// parent directory, because linkers and editors usually replace file (unlink + create or rename) instead of
+/// rewriting it, so watch of file inode would be lost after first rebuild.
+class FileWatcher
+{
+public:
+    FileWatcher();
+    ~FileWatcher();
+
+    bool initialize();
+    const char* error() const;
+
+    /// @brief Report changes of file 'path' (file may not exist at the moment of call)
+    /// @param[out] watchedPath Absolute path of file, which will be reported by 'wait'
+    bool watchFile(const char *path, std::string &watchedPath);
+
+    /// @brief Wait for changes not longer than 'timeoutMs' milliseconds (negative value means infinite wait)
+    /// @param[out] changed Absolute paths of changed files, every path is listed once
+    /// @return false in case of error
+    /// @details After first change has been detected, method waits until watched files become quiet for
+    /// 'settleTimeMs' milliseconds, so the whole rebuild is reported as one change set.
+    bool wait(int timeoutMs, std::vector<std::string> &changed);
+
+    enum {settleTimeMs = 150};
+
+private:
+    int addWatch(const std::string &dirPath);
+    bool readEvents(std::vector<std::string> &changed);
+    void setError(const char *prefix);
+
+private:
+    int fd_;
+    std::string error_;
+
+    struct WatchedDir
+    {
+        std::string path_;
+        std::vector<std::string> files_;   ///< base names of watched files
+    };
+    typedef std::map<int, WatchedDir> WatchedDirs;
+    WatchedDirs dirs_;
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+LUA_CLASS(FileWatcher)
+{
+    /// @return object or nil and error message
+    ADD_CONSTRUCTOR(FileWatcher);
+
+    ADD_DESTRUCTOR(FileWatcher);
+
+    /// @fn watchFile(path)
+    /// @return absolute path of watched file (as it will be reported by 'wait') or nil and error message
+    ADD_METHOD(FileWatcher, watchFile);
+
+    /// @fn wait(timeoutMs)
+    /// @return Table with paths of changed files (empty table on timeout) or nil and error message
+    ADD_METHOD(FileWatcher, wait);
+};
+
+DEFINE_LUA_TO(FileWatcher)
+
+#endif // _FILE_WATCHER_HEADER_
@@ -0,0 +1,229 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// lua_state_pool.cpp
+//
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "lua_state_pool.h"
+#include "test_engine_interface.h"
+#include "test_engine.h"
+#include "file_watcher.h"
+#include "bytecode_cache.h"
+#include "results_merge.h"
+#include "test_plan.h"
+#include "trace_lib.h"
+#include "../cppunit/test_results.h"
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <string>
+#include <thread>
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+LuaEnvironment::LuaEnvironment()
+: program_(NULL)
+, mainScript_(NULL)
+, resultsPath_("yunit_results.txt")
+{
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+struct LuaStatePool::Worker
+{
+    Worker()
+    : lua_(Lua::State::newstate())
+    , results_(NULL)
+    , rc_(0)
+    {
+    }
+
+    ~Worker()
+    {
+        if (NULL != results_)
+            ::fclose(results_);
+        lua_close(lua_);
+    }
+
+    Lua::State lua_;
+    std::string resultsPath_;
+    FILE *results_;
+    int rc_;
+};
+
+LuaStatePool::LuaStatePool(const LuaEnvironment &environment, unsigned int size)
+: environment_(environment)
+, queue_(environment.testContainers_)
+, nextContainer_(0)
+{
+    orderLongestFirst(queue_, environment_.resultsPath_);
+
+    for (unsigned int idx = 0; idx < size; ++idx)
+    {
+        Worker *worker = new Worker;
+        char suffix[16];
+        snprintf(suffix, sizeof(suffix), ".%u", idx);
+        worker->resultsPath_ = std::string(environment_.resultsPath_) + suffix;
+        ::remove(worker->resultsPath_.c_str()); // left by previous run
+        workers_.push_back(worker);
+        prepare(*worker);
+    }
+}
+
+LuaStatePool::~LuaStatePool()
+{
+    for (size_t idx = 0; idx < workers_.size(); ++idx)
+        delete workers_[idx];
+}
+
+static void pushPaths(Lua::State &lua, const std::vector<const char*> &paths, const char *name)
+{
+    lua.push(Lua::Table());
+    const int tableIdx = lua.top();
+    for (size_t idx = 0; idx < paths.size(); ++idx)
+    {
+        lua.push(static_cast<int>(idx + 1));
+        lua.push(paths[idx]);
+        lua.settable(tableIdx);
+    }
+    lua.setglobal(name);
+}
+
+// the same environment as main state has, but without watch mode
+void LuaStatePool::prepare(Worker &worker)
+{
+    Lua::State &lua = worker.lua_;
+
+    pushPaths(lua, environment_.testEngines_, "testEnginePaths");
+    pushPaths(lua, environment_.testContainers_, "testContainerPaths");
+    lua.push(false);
+    lua.setglobal("watchMode");
+    lua.push(environment_.program_);
+    lua.setglobal("program");
+
+    lua.openlibs();
+
+    LUA_REGISTER(TestEngine)(lua);
+    LUA_REGISTER(TestCase)(lua);
+    LUA_REGISTER(FileWatcher)(lua);
+    registerTraceLib(lua);
+    registerBytecodeCache(lua);
+
+    lua_pushlightuserdata(lua, this);
+    lua_pushcclosure(lua, &LuaStatePool::nextTestContainer, 1);
+    lua.setglobal("nextTestContainer");
+
+    lua_pushlightuserdata(lua, &worker);
+    lua_pushcclosure(lua, &LuaStatePool::writeResult, 1);
+    lua.setglobal("writeResult");
+
+    lua_pushcfunction(lua, &LuaStatePool::clockNs);
+    lua.setglobal("clockNs");
+}
+
+/// @fn nextTestContainer()
+/// @return Path of container, which is not executed by any state, or nil
+int LuaStatePool::nextTestContainer(lua_State *L)
+{
+    LuaStatePool *self = static_cast<LuaStatePool*>(lua_touserdata(L, lua_upvalueindex(1)));
+
+    const char *path = NULL;
+    {
+        std::lock_guard<std::mutex> lock(self->queueMutex_);
+        if (self->nextContainer_ < self->queue_.size())
+            path = self->queue_[self->nextContainer_++];
+    }
+
+    if (NULL == path)
+        lua_pushnil(L);
+    else
+        lua_pushstring(L, path);
+    return 1;
+}
+
+/// @fn writeResult(source, name, line, outcome, durationNs)
+/// @param outcome "success", "fail", "crashed" or "ignored"
+int LuaStatePool::writeResult(lua_State *L)
+{
+    Worker *worker = static_cast<Worker*>(lua_touserdata(L, lua_upvalueindex(1)));
+    enum Args {sourceIdx = 1, nameIdx, lineIdx, outcomeIdx, durationIdx};
+
+    YUNIT_NS_PREF(TestResult) result;
+    result.key_ = std::string(luaL_checkstring(L, sourceIdx)) + "\t" + luaL_checkstring(L, nameIdx);
+    result.lineNumber_ = static_cast<int>(luaL_checkinteger(L, lineIdx));
+    result.durationNs_ = static_cast<unsigned long long>(luaL_optnumber(L, durationIdx, 0));
+
+    const char *outcome = luaL_checkstring(L, outcomeIdx);
+    int value = 0;
+    while (value < YUNIT_NS_PREF(outcomesNumber)
+           && 0 != ::strcmp(outcome, YUNIT_NS_PREF(outcomeName)(static_cast<YUNIT_NS_PREF(TestOutcome)>(value))))
+        ++value;
+    if (YUNIT_NS_PREF(outcomesNumber) == value)
+        return luaL_error(L, "unknown test outcome '%s'", outcome);
+    result.outcome_ = static_cast<YUNIT_NS_PREF(TestOutcome)>(value);
+
+    if (NULL == worker->results_)
+        worker->results_ = ::fopen(worker->resultsPath_.c_str(), "w");
+    if (NULL == worker->results_ || !YUNIT_NS_PREF(writeTestResult)(worker->results_, result))
+        return luaL_error(L, "results file '%s' can not be written", worker->resultsPath_.c_str());
+    return 0;
+}
+
+/// @fn clockNs()
+/// @return Monotonic time in nanoseconds, for durations of tests
+int LuaStatePool::clockNs(lua_State *L)
+{
+    const std::chrono::nanoseconds now = std::chrono::steady_clock::now().time_since_epoch();
+    lua_pushnumber(L, static_cast<lua_Number>(now.count()));
+    return 1;
+}
+
+void LuaStatePool::work(LuaStatePool *self, Worker *worker)
+{
+    worker->rc_ = doCachedFile(worker->lua_, self->environment_.mainScript_);
+    if (0 != worker->rc_)
+        fprintf(stderr, "%s" ENDL, worker->lua_.to<const char*>());
+
+    if (NULL != worker->results_)
+    {
+        ::fclose(worker->results_);
+        worker->results_ = NULL;
+    }
+}
+
+int LuaStatePool::run()
+{
+    std::vector<std::thread> threads;
+    for (size_t idx = 0; idx < workers_.size(); ++idx)
+        threads.push_back(std::thread(&LuaStatePool::work, this, workers_[idx]));
+
+    int failedStates = 0;
+    for (size_t idx = 0; idx < threads.size(); ++idx)
+    {
+        threads[idx].join();
+        if (0 != workers_[idx]->rc_)
+            ++failedStates;
+    }
+
+    return mergeWorkerResults() ? failedStates : -1;
+}
+
+// states, which have executed no test, have no results file
+bool LuaStatePool::mergeWorkerResults()
+{
+    std::vector<const char*> inputs;
+    for (size_t idx = 0; idx < workers_.size(); ++idx)
+    {
+        FILE *file = ::fopen(workers_[idx]->resultsPath_.c_str(), "r");
+        if (NULL == file)
+            continue;
+        ::fclose(file);
+        inputs.push_back(workers_[idx]->resultsPath_.c_str());
+    }
+
+    MergeOptions options;
+    options.output_ = environment_.resultsPath_;
+    const bool merged = ::mergeResults(inputs, options) >= 0;
+
+    for (size_t idx = 0; idx < inputs.size(); ++idx)
+        ::remove(inputs[idx]);
+    return merged;
+}
@@ -0,0 +1,67 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// @file lua_state_pool.h
+//
+// Parallel run of test containers by several independent Lua states (runner '--jobs <n>'). Every state of
+// pool is prepared as the main one: standard libraries, TestEngine, TestCase and FileWatcher classes, 'trace'
+// library and variables of execution environment (see yunit_main.lua), then main script is executed by its
+// own thread. Instead of iteration over 'testContainerPaths' script takes containers by 'nextTestContainer()'
+// from queue, shared by all states, so containers are spread between states dynamically and every container is
+// executed once. Queue is ordered longest first by results of previous run (see orderLongestFirst in
+// test_plan.h), so the longest containers do not start last. Test engines must be loaded by several states
+// simultaneously then.
+//
+// State measures durations of its tests by 'clockNs()' and writes their results by
+// 'writeResult(source, name, line, outcome, durationNs)' into own results file (see cppunit/test_results.h),
+// these files are merged into one report after run.
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#ifndef _LUA_STATE_POOL_HEADER_
+#define _LUA_STATE_POOL_HEADER_
+
+#include "lua_wrapper.h"
+#include <mutex>
+#include <vector>
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+struct LuaEnvironment
+{
+    LuaEnvironment();
+
+    const char *program_;                   ///< 'program' variable
+    const char *mainScript_;
+    const char *resultsPath_;               ///< merged results of all states
+    std::vector<const char*> testEngines_;
+    std::vector<const char*> testContainers_;
+};
+
+class LuaStatePool
+{
+public:
+    /// @param size Number of states, one per worker thread
+    LuaStatePool(const LuaEnvironment &environment, unsigned int size);
+    ~LuaStatePool();
+
+    /// @brief Execute main script by all states, until containers queue is empty
+    /// @return Number of states, which main script has failed, or -1, if results are not merged
+    int run();
+
+private:
+    LuaStatePool(const LuaStatePool&);
+    LuaStatePool& operator=(const LuaStatePool&);
+
+    struct Worker;
+
+    static void work(LuaStatePool *self, Worker *worker);
+    static int nextTestContainer(lua_State *L);
+    static int writeResult(lua_State *L);
+    static int clockNs(lua_State *L);
+    void prepare(Worker &worker);
+    bool mergeWorkerResults();
+
+    const LuaEnvironment &environment_;
+    std::vector<Worker*> workers_;
+    std::vector<const char*> queue_;    ///< containers in order of dispatch
+    std::mutex queueMutex_;
+    size_t nextContainer_;
+};
+
+#endif // _LUA_STATE_POOL_HEADER_
@@ -0,0 +1,337 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// results_merge.cpp
+//
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "results_merge.h"
+#include "../cppunit/test_results.h"
+#include <algorithm>
+#include <chrono>
+#include <queue>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+
+#ifdef _WIN32
+#  define ENDL "\r\n"
+#else
+#  define ENDL "\n"
+#endif
+
+using YUNIT_NS_PREF(TestResult);
+using YUNIT_NS_PREF(TestOutcome);
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+MergeOptions::MergeOptions()
+: output_(NULL)
+, policy_(mergeWorst)
+, maxRecordsInMemory_(100000)
+, fanIn_(64)
+{
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief Result with its position among all input records: (input index, line index)
+struct Entry
+{
+    TestResult result_;
+    unsigned long long seq_;
+
+    bool operator<(const Entry &entry) const
+    {
+        const int cmp = result_.key_.compare(entry.result_.key_);
+        return cmp < 0 || (0 == cmp && seq_ < entry.seq_);
+    }
+};
+
+enum {seqLineBits = 40};
+
+static void combine(Entry &into, const Entry &entry, MergePolicy policy)
+{
+    TestResult &result = into.result_;
+    const TestResult &other = entry.result_;
+
+    const bool later = entry.seq_ > into.seq_;
+    const bool take = (mergeLast == policy) ? later
+                    : other.outcome_ > result.outcome_ || (other.outcome_ == result.outcome_ && later);
+
+    result.attempts_ += other.attempts_;
+    result.durationNs_ += other.durationNs_;
+    result.allocations_ += other.allocations_;
+    result.allocatedBytes_ += other.allocatedBytes_;
+    result.perfAvailable_ |= other.perfAvailable_;
+    for (int counter = 0; counter < perfCountersNumber; ++counter)
+        result.perf_[counter] += other.perf_[counter];
+
+    if (take)
+    {
+        result.outcome_ = other.outcome_;
+        result.lineNumber_ = other.lineNumber_;
+        into.seq_ = entry.seq_;
+    }
+}
+
+static bool readLine(FILE *file, std::string &line)
+{
+    line.clear();
+    char buf[1024];
+    while (::fgets(buf, sizeof(buf), file))
+    {
+        line += buf;
+        if ('\n' == line[line.size() - 1])
+            return true;
+    }
+    return !line.empty();
+}
+
+/// @brief Sorted run in temporary file, line is '<seq>\t<result>'
+class Run
+{
+public:
+    explicit Run(FILE *file)
+    : file_(file)
+    {
+    }
+
+    bool next(Entry &entry)
+    {
+        if (!readLine(file_, line_))
+            return false;
+
+        char *pos = NULL;
+        entry.seq_ = ::strtoull(line_.c_str(), &pos, 10);
+        return '\t' == *pos && YUNIT_NS_PREF(parseTestResult)(pos + 1, entry.result_);
+    }
+
+    void close()
+    {
+        ::fclose(file_);
+    }
+
+private:
+    FILE *file_;
+    std::string line_;
+};
+
+static bool writeEntry(FILE *file, const Entry &entry)
+{
+    return 0 < ::fprintf(file, "%llu\t", entry.seq_) && YUNIT_NS_PREF(writeTestResult)(file, entry.result_);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief Destination of merged results: the next run or final report
+class Sink
+{
+public:
+    Sink(FILE *file, bool final)
+    : file_(file)
+    , final_(final)
+    , error_(false)
+    , tests_(0)
+    , retried_(0)
+    {
+        for (int idx = 0; idx < YUNIT_NS_PREF(outcomesNumber); ++idx)
+            outcomes_[idx] = 0;
+    }
+
+    void write(const Entry &entry)
+    {
+        if (final_)
+        {
+            error_ = !YUNIT_NS_PREF(writeTestResult)(file_, entry.result_) || error_;
+            ++tests_;
+            ++outcomes_[entry.result_.outcome_];
+            if (entry.result_.attempts_ > 1)
+                ++retried_;
+        }
+        else
+            error_ = !writeEntry(file_, entry) || error_;
+    }
+
+    FILE *file_;
+    bool final_;
+    bool error_;
+    unsigned long long tests_;
+    unsigned long long retried_;
+    unsigned long long outcomes_[YUNIT_NS_PREF(outcomesNumber)];
+};
+
+struct RunHead
+{
+    Entry entry_;
+    size_t run_;
+};
+
+struct LaterHead
+{
+    bool operator()(const RunHead *lhs, const RunHead *rhs) const
+    {
+        return rhs->entry_ < lhs->entry_;
+    }
+};
+
+// k-way merge by heap of runs heads, records of the same test are combined
+static bool mergeRuns(std::vector<Run> &runs, Sink &sink, MergePolicy policy)
+{
+    std::vector<RunHead> heads(runs.size());
+    std::priority_queue<RunHead*, std::vector<RunHead*>, LaterHead> queue;
+    for (size_t idx = 0; idx < runs.size(); ++idx)
+    {
+        heads[idx].run_ = idx;
+        if (runs[idx].next(heads[idx].entry_))
+            queue.push(&heads[idx]);
+    }
+
+    bool hasCurrent = false;
+    Entry current;
+    while (!queue.empty())
+    {
+        RunHead *head = queue.top();
+        queue.pop();
+
+        if (hasCurrent && current.result_.key_ == head->entry_.result_.key_)
+            combine(current, head->entry_, policy);
+        else
+        {
+            if (hasCurrent)
+                sink.write(current);
+            current = head->entry_;
+            hasCurrent = true;
+        }
+
+        if (runs[head->run_].next(head->entry_))
+            queue.push(head);
+    }
+    if (hasCurrent)
+        sink.write(current);
+
+    for (size_t idx = 0; idx < runs.size(); ++idx)
+        runs[idx].close();
+    return !sink.error_;
+}
+
+// sorted chunk is written with combined records of the same test
+static bool writeRun(std::vector<Entry> &chunk, MergePolicy policy, std::vector<Run> &runs)
+{
+    std::sort(chunk.begin(), chunk.end());
+
+    FILE *file = ::tmpfile();
+    if (NULL == file)
+        return false;
+
+    Sink sink(file, false);
+    for (size_t idx = 0; idx < chunk.size(); )
+    {
+        Entry entry = chunk[idx];
+        for (++idx; idx < chunk.size() && chunk[idx].result_.key_ == entry.result_.key_; ++idx)
+            combine(entry, chunk[idx], policy);
+        sink.write(entry);
+    }
+    chunk.clear();
+
+    if (sink.error_ || 0 != ::fflush(file))
+    {
+        ::fclose(file);
+        return false;
+    }
+    ::rewind(file);
+    runs.push_back(Run(file));
+    return true;
+}
+
+static bool sortInput(const char *path, unsigned long long inputIdx, const MergeOptions &options,
+                      std::vector<Entry> &chunk, std::vector<Run> &runs, unsigned long long &records)
+{
+    FILE *file = ::fopen(path, "r");
+    if (NULL == file)
+    {
+        fprintf(stderr, "Can not open results file '%s'" ENDL, path);
+        return false;
+    }
+
+    bool res = true;
+    std::string line;
+    for (unsigned long long lineIdx = 0; res && readLine(file, line); ++lineIdx)
+    {
+        Entry entry;
+        if (!YUNIT_NS_PREF(parseTestResult)(line.c_str(), entry.result_))
+        {
+            fprintf(stderr, "%s:%llu: wrong results line is skipped" ENDL, path, lineIdx + 1);
+            continue;
+        }
+        entry.seq_ = (inputIdx << seqLineBits) | lineIdx;
+        chunk.push_back(entry);
+        ++records;
+
+        if (chunk.size() >= options.maxRecordsInMemory_)
+            res = writeRun(chunk, options.policy_, runs);
+    }
+
+    ::fclose(file);
+    return res;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+int mergeResults(const std::vector<const char*> &inputs, const MergeOptions &options)
+{
+    const std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+
+    std::vector<Entry> chunk;
+    chunk.reserve(options.maxRecordsInMemory_);
+    std::vector<Run> runs;
+    unsigned long long records = 0;
+
+    bool res = true;
+    for (size_t idx = 0; res && idx < inputs.size(); ++idx)
+        res = sortInput(inputs[idx], idx, options, chunk, runs, records);
+    if (res && !chunk.empty())
+        res = writeRun(chunk, options.policy_, runs);
+
+    // too many runs are merged in several passes, so number of opened files is bounded
+    const size_t fanIn = options.fanIn_ < 2 ? 2 : options.fanIn_;
+    while (res && runs.size() > fanIn)
+    {
+        std::vector<Run> merged;
+        for (size_t first = 0; res && first < runs.size(); first += fanIn)
+        {
+            std::vector<Run> group(runs.begin() + first, runs.begin() + std::min(first + fanIn, runs.size()));
+            FILE *file = ::tmpfile();
+            if (NULL == file)
+            {
+                res = false;
+                break;
+            }
+
+            Sink sink(file, false);
+            res = mergeRuns(group, sink, options.policy_) && 0 == ::fflush(file);
+            ::rewind(file);
+            merged.push_back(Run(file));
+        }
+        runs.swap(merged);
+    }
+
+    FILE *output = res ? ::fopen(options.output_, "w") : NULL;
+    if (NULL == output)
+    {
+        for (size_t idx = 0; idx < runs.size(); ++idx)
+            runs[idx].close();
+        fprintf(stderr, "Results are not merged into '%s'" ENDL, options.output_);
+        return -1;
+    }
+
+    Sink report(output, true);
+    res = mergeRuns(runs, report, options.policy_);
+    res = (0 == ::fclose(output)) && res;
+
+    const std::chrono::duration<double, std::milli> duration = std::chrono::steady_clock::now() - startTime;
+    fprintf(stderr, "%llu results of %u files are merged into '%s' in %.3f ms: %llu tests, %llu success, %llu fail, "
+                    "%llu crashed, %llu ignored, %llu retried" ENDL,
+            records, static_cast<unsigned int>(inputs.size()), options.output_, duration.count(), report.tests_,
+            report.outcomes_[YUNIT_NS_PREF(outcomeSuccess)], report.outcomes_[YUNIT_NS_PREF(outcomeFail)],
+            report.outcomes_[YUNIT_NS_PREF(outcomeCrashed)], report.outcomes_[YUNIT_NS_PREF(outcomeIgnored)],
+            report.retried_);
+
+    if (!res)
+        return -1;
+    return static_cast<int>(report.outcomes_[YUNIT_NS_PREF(outcomeFail)] + report.outcomes_[YUNIT_NS_PREF(outcomeCrashed)]);
+}
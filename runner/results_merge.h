@@ -0,0 +1,37 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// @file results_merge.h
+//
+// Merge of results files of shards and worker processes into one report (runner '--merge-results' mode, see
+// cppunit/test_results.h). Inputs are sorted by test key in bounded chunks (external sort), then runs are
+// combined by k-way merge, so memory does not depend on number of records.
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#ifndef _RESULTS_MERGE_HEADER_
+#define _RESULTS_MERGE_HEADER_
+
+#include <stddef.h>
+#include <vector>
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief Outcome of test, which has been met several times (retried or executed by several shards)
+enum MergePolicy
+{
+    mergeWorst, ///< the most severe outcome: crashed, fail, success, ignored
+    mergeLast   ///< outcome of the last record: later input file, later line
+};
+
+struct MergeOptions
+{
+    MergeOptions();
+
+    const char *output_;
+    MergePolicy policy_;
+    size_t maxRecordsInMemory_;     ///< size of sorted chunk
+    size_t fanIn_;                  ///< number of runs, merged at once
+};
+
+/// @brief Write results of 'inputs' into 'options.output_' sorted by test key; every test is written once with
+/// outcome by policy and total attempts, duration and allocations of all its records. Summary is printed to stderr.
+/// @return Number of failed and crashed tests or -1, if inputs can not be read or output can not be written
+int mergeResults(const std::vector<const char*> &inputs, const MergeOptions &options);
+
+#endif // _RESULTS_MERGE_HEADER_
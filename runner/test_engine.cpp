@@ -52,6 +52,7 @@ public:
     virtual bool initialize() = 0;
     virtual const char *error() const = 0;
     virtual TestContainerPtr load(const char* path) = 0;
+    virtual bool unloadContainer(const char* path) = 0;
     virtual void unload() = 0;
     virtual ~TestEngine() {}
 };
@@ -153,6 +154,7 @@ public:
     virtual bool initialize();
     virtual const char** supportedExtensions();
     virtual TestPtr load(const char* testContainerPath);
+    virtual bool unloadContainer(const char* testContainerPath);
     virtual const char *error() const;
     virtual void unload();
             
@@ -165,6 +167,9 @@ private:
 
     typedef Test* (*LoadTestContainerFunc)(const char*);
     LoadTestContainerFunc loadTestContainerFunc_;
+
+    typedef void (*ReleaseTestContainerFunc)(const char*);
+    ReleaseTestContainerFunc releaseTestContainerFunc_; ///< optional, NULL if engine does not export it
 };
 
 #endif // _WIN32
@@ -340,6 +345,7 @@ TestEngineUnix::TestEngineUnix(const char *path)
 : path_(path)
 , testContainerExtensions_(NULL)
 , loadTestContainerFunc_(NULL)
+, releaseTestContainerFunc_(NULL)
 {
 }
 
@@ -359,6 +365,9 @@ bool TestEngineUnix::initialize()
     if (NULL == funcPtr)
         return false;
     loadTestContainerFunc_ = reinterpret_cast<LoadTestContainerFunc>(funcPtr);
+
+    // engine, which does not export function, can reload container only together with itself
+    releaseTestContainerFunc_ = reinterpret_cast<ReleaseTestContainerFunc>(resolve("releaseTestContainer"));
     
     return true;
 }
@@ -373,6 +382,15 @@ Test* TestEngineUnix::load(const char* testContainerPath)
     return (*loadTestContainerFunc_)(testContainerPath);
 }
 
+bool TestEngineUnix::unloadContainer(const char* testContainerPath)
+{
+    if (NULL == releaseTestContainerFunc_)
+        return false;
+
+    (*releaseTestContainerFunc_)(testContainerPath);
+    return true;
+}
+
 const char *TestEngineUnix::error() const
 {
     return Parent2::error();
@@ -752,6 +770,16 @@ LUA_METHOD(TestEngine, load)
     return 1;
 }
 
+LUA_METHOD(TestEngine, unloadContainer)
+{
+    enum Args {selfIdx = 1, testContainerPathIdx};
+    LUA_CHECK_ARG(string, const char*, testContainerPathIdx);
+
+    TestEngine *testEngine = lua.to<TestEngine*>(selfIdx);
+    lua.push(testEngine->unloadContainer(lua.to<const char*>(testContainerPathIdx)));
+    return 1;
+}
+
 LUA_METHOD(TestEngine, unload)
 {
     enum Args {selfIdx = 1};
@@ -806,7 +834,7 @@ LUA_METHOD(TestCase, tearDown)
 LUA_METHOD(TestCase, isIgnored)
 {
     enum Args {selfIdx = 1};
-    lua.push(isIgnored(lua.to<TestPtr>(selfIdx)));
+    lua.push(0 != ignored(lua.to<TestPtr>(selfIdx)));
     return 1;
 }
 
@@ -30,6 +30,12 @@ LUA_CLASS(TestEngine)
     /// @fn load(testContainerPath)
     ADD_METHOD(TestEngine, load);
 
+    /// @fn unloadContainer(testContainerPath)
+    /// @brief Release test container by optional engine function 'releaseTestContainer(const char *path)', so
+    /// the next 'load' of the same path reads rebuilt container file, while engine itself stays loaded
+    /// @return false, if engine does not export 'releaseTestContainer'
+    ADD_METHOD(TestEngine, unloadContainer);
+
     /// @fn unload()
     ADD_METHOD(TestEngine, unload);
 };
@@ -0,0 +1,161 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// test_plan.cpp
+//
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "test_plan.h"
+#include "../cppunit/test_manifest.h"
+#include "../cppunit/test_results.h"
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <stdio.h>
+#include <string>
+#include <utility>
+
+#ifdef _WIN32
+#  define ENDL "\r\n"
+#else
+#  define ENDL "\n"
+#endif
+
+using YUNIT_NS_PREF(ManifestTest);
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+int listTests(const std::vector<const char*> &containers)
+{
+    const std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+    int failedContainers = 0;
+    size_t testsNumber = 0;
+
+    std::vector<ManifestTest> tests;
+    std::string error;
+
+    for (size_t containerIdx = 0; containerIdx < containers.size(); ++containerIdx)
+    {
+        tests.clear();
+        if (!YUNIT_NS_PREF(readTestManifest)(containers[containerIdx], tests, error))
+        {
+            fprintf(stderr, "%s" ENDL, error.c_str());
+            ++failedContainers;
+            continue;
+        }
+
+        for (size_t idx = 0; idx < tests.size(); ++idx)
+        {
+            const ManifestTest &test = tests[idx];
+            const char *flags = (test.flags_ & YUNIT_TEST_IGNORED) ? "\tignored"
+                              : (test.flags_ & YUNIT_TEST_GENERATED) ? "\tgenerated" : "";
+            printf("%s\t%s:%d\t%s%s" ENDL, containers[containerIdx], test.fileName_.c_str(), test.lineNumber_,
+                   test.name_.c_str(), flags);
+        }
+        testsNumber += tests.size();
+    }
+
+    const std::chrono::duration<double, std::milli> duration = std::chrono::steady_clock::now() - startTime;
+    fprintf(stderr, "%u tests of %u containers are listed in %.3f ms" ENDL, static_cast<unsigned int>(testsNumber),
+            static_cast<unsigned int>(containers.size()), duration.count());
+    return failedContainers;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// average duration of one attempt by key of test
+typedef std::map<std::string, unsigned long long> Durations;
+
+static void readDurations(const char *resultsPath, Durations &durations)
+{
+    FILE *file = ::fopen(resultsPath, "r");
+    if (NULL == file)
+        return;
+
+    enum {lineSize = 4096};
+    char line[lineSize];
+    YUNIT_NS_PREF(TestResult) result;
+    while (::fgets(line, lineSize, file))
+    {
+        if (YUNIT_NS_PREF(parseTestResult)(line, result) && result.attempts_ > 0
+            && YUNIT_NS_PREF(outcomeIgnored) != result.outcome_)
+        {
+            durations[result.key_] = result.durationNs_ / result.attempts_;
+        }
+    }
+
+    ::fclose(file);
+}
+
+// results of generated test are written per case: '<file>\t<name>/<case>'
+static bool testDuration(const Durations &durations, const ManifestTest &test, unsigned long long &durationNs)
+{
+    const std::string key = test.fileName_ + '\t' + test.name_;
+    if (!(test.flags_ & YUNIT_TEST_GENERATED))
+    {
+        Durations::const_iterator it = durations.find(key);
+        if (durations.end() == it)
+            return false;
+        durationNs = it->second;
+        return true;
+    }
+
+    const std::string prefix = key + '/';
+    bool found = false;
+    durationNs = 0;
+    for (Durations::const_iterator it = durations.lower_bound(prefix), endIt = durations.end();
+         it != endIt && 0 == it->first.compare(0, prefix.size(), prefix); ++it)
+    {
+        durationNs += it->second;
+        found = true;
+    }
+    return found;
+}
+
+static bool longerFirst(const std::pair<unsigned long long, const char*> &left,
+                        const std::pair<unsigned long long, const char*> &right)
+{
+    return left.first > right.first;
+}
+
+void orderLongestFirst(std::vector<const char*> &containers, const char *resultsPath)
+{
+    Durations durations;
+    readDurations(resultsPath, durations);
+    if (durations.empty())
+        return;
+
+    // (known duration, number of tests without result) of every container
+    std::vector<std::pair<unsigned long long, size_t> > known(containers.size());
+    unsigned long long knownNs = 0, knownTests = 0;
+
+    std::vector<ManifestTest> tests;
+    std::string error;
+    for (size_t containerIdx = 0; containerIdx < containers.size(); ++containerIdx)
+    {
+        tests.clear();
+        if (!YUNIT_NS_PREF(readTestManifest)(containers[containerIdx], tests, error))
+            continue; // container is reported by its load
+
+        for (size_t idx = 0; idx < tests.size(); ++idx)
+        {
+            unsigned long long durationNs = 0;
+            if (tests[idx].flags_ & YUNIT_TEST_IGNORED)
+                continue;
+            if (!testDuration(durations, tests[idx], durationNs))
+            {
+                ++known[containerIdx].second;
+                continue;
+            }
+            known[containerIdx].first += durationNs;
+            knownNs += durationNs;
+            ++knownTests;
+        }
+    }
+
+    const unsigned long long averageNs = 0 == knownTests ? 0 : knownNs / knownTests;
+    std::vector<std::pair<unsigned long long, const char*> > expected;
+    expected.reserve(containers.size());
+    for (size_t idx = 0; idx < containers.size(); ++idx)
+        expected.push_back(std::make_pair(known[idx].first + known[idx].second * averageNs, containers[idx]));
+
+    std::stable_sort(expected.begin(), expected.end(), longerFirst);
+    for (size_t idx = 0; idx < containers.size(); ++idx)
+        containers[idx] = expected[idx].second;
+}
@@ -0,0 +1,23 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// @file test_plan.h
+//
+// Run planning by test manifests of containers (runner '--list-tests' mode and order of '--jobs <n>' queue).
+// Containers are not loaded.
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#ifndef _TEST_PLAN_HEADER_
+#define _TEST_PLAN_HEADER_
+
+#include <vector>
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/// @brief Print tests of every container, one per line: <container>\t<file>:<line>\t<name>[\tignored|generated]
+/// @return Number of containers, which manifests can not be read
+int listTests(const std::vector<const char*> &containers);
+
+/// @brief Order containers longest first (LPT) by durations of their tests in results file of previous run
+/// @details Expected duration of container is a sum of its tests durations; test without result is expected to
+/// last as average test with result. Order of containers with equal expected durations is kept, so without
+/// results file (first run) the order is not changed.
+void orderLongestFirst(std::vector<const char*> &containers, const char *resultsPath);
+
+#endif // _TEST_PLAN_HEADER_
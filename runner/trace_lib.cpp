@@ -0,0 +1,77 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// trace_lib.cpp
+//
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#include "trace_lib.h"
+#include "../cppunit/trace.h"
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+static int beginSpan(lua_State *L)
+{
+    Lua::State lua(L);
+    enum Args {nameIdx = 1};
+    LUA_CHECK_ARG(string, const char*, nameIdx);
+
+    YUNIT_NS_PREF(traceBegin)(lua.to<const char*>(nameIdx));
+    return 0;
+}
+
+static int endSpan(lua_State *L)
+{
+    Lua::State lua(L);
+    enum Args {nameIdx = 1};
+    LUA_CHECK_ARG(string, const char*, nameIdx);
+
+    YUNIT_NS_PREF(traceEnd)(lua.to<const char*>(nameIdx));
+    return 0;
+}
+
+static int counter(lua_State *L)
+{
+    Lua::State lua(L);
+    enum Args {nameIdx = 1, valueIdx};
+    LUA_CHECK_ARG(string, const char*, nameIdx);
+
+    YUNIT_NS_PREF(traceCounter)(lua.to<const char*>(nameIdx), lua_tonumber(L, valueIdx));
+    return 0;
+}
+
+static int message(lua_State *L)
+{
+    Lua::State lua(L);
+    enum Args {textIdx = 1};
+    LUA_CHECK_ARG(string, const char*, textIdx);
+
+    YUNIT_NS_PREF(traceMessage)(lua.to<const char*>(textIdx));
+    return 0;
+}
+
+static int flush(lua_State * /*L*/)
+{
+    YUNIT_NS_PREF(flushTrace)();
+    return 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+void registerTraceLib(Lua::State &lua)
+{
+    lua.push(Lua::Table());
+    const int libIdx = lua.top();
+
+    lua.push(beginSpan);
+    lua.setfield(libIdx, "beginSpan");
+
+    lua.push(endSpan);
+    lua.setfield(libIdx, "endSpan");
+
+    lua.push(counter);
+    lua.setfield(libIdx, "counter");
+
+    lua.push(message);
+    lua.setfield(libIdx, "message");
+
+    lua.push(flush);
+    lua.setfield(libIdx, "flush");
+
+    lua.setglobal("trace");
+}
@@ -0,0 +1,15 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// @file trace_lib.h
+//
+// Lua interface of trace buffers (cppunit/trace.h), registered as global 'trace' table:
+//   trace.beginSpan(name), trace.endSpan(name), trace.counter(name, value), trace.message(text), trace.flush()
+// Calls do nothing, if runner has been started without '--trace <path>' option.
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#ifndef _TRACE_LIB_HEADER_
+#define _TRACE_LIB_HEADER_
+
+#include "lua_wrapper.h"
+
+void registerTraceLib(Lua::State &lua);
+
+#endif // _TRACE_LIB_HEADER_
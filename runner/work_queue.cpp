@@ -0,0 +1,685 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// work_queue.cpp
+//
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "work_queue.h"
+#include "../cppunit/test_manifest.h"
+#include "../cppunit/test_results.h"
+#include <chrono>
+#include <deque>
+#include <set>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+#ifndef _WIN32
+#  include <errno.h>
+#  include <fcntl.h>
+#  include <netdb.h>
+#  include <arpa/inet.h>
+#  include <netinet/in.h>
+#  include <poll.h>
+#  include <signal.h>
+#  include <sys/socket.h>
+#  include <sys/wait.h>
+#  include <unistd.h>
+#endif
+
+#ifdef _WIN32
+#  define ENDL "\r\n"
+#else
+#  define ENDL "\n"
+#endif
+
+using YUNIT_NS_PREF(ManifestTest);
+using YUNIT_NS_PREF(TestResult);
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+CoordinatorOptions::CoordinatorOptions()
+: port_(0)
+, bindAddress_("127.0.0.1")
+, unitSize_(16)
+, unitTimeoutSec_(0)
+, maxAttempts_(3)
+, resultsPath_("yunit_results.txt")
+{
+}
+
+#ifndef _WIN32
+
+typedef std::chrono::steady_clock Clock;
+
+enum {noUnit = -1};
+
+static bool sendAll(int sock, const std::string &msg)
+{
+    for (size_t sent = 0; sent < msg.size(); )
+    {
+        const ssize_t size = ::send(sock, msg.data() + sent, msg.size() - sent, MSG_NOSIGNAL);
+        if (size < 0 && EINTR == errno)
+            continue;
+        if (size <= 0)
+            return false;
+        sent += static_cast<size_t>(size);
+    }
+    return true;
+}
+
+// complete lines of 'buf' without '\n' are moved into 'lines'
+static void takeLines(std::string &buf, std::vector<std::string> &lines)
+{
+    size_t begin = 0;
+    for (size_t end; std::string::npos != (end = buf.find('\n', begin)); begin = end + 1)
+        lines.push_back(buf.substr(begin, end - begin));
+    buf.erase(0, begin);
+}
+
+static std::string testKey(const ManifestTest &test)
+{
+    return test.fileName_ + "\t" + test.name_;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+struct WorkUnit
+{
+    enum State {pending, leased, finished};
+
+    size_t container_;
+    size_t first_;
+    size_t end_;
+    State state_;
+    Clock::time_point leaseTime_;
+    unsigned int attempts_;
+    std::vector<TestResult> results_;
+};
+
+struct WorkerConnection
+{
+    int socket_;
+    std::string input_;
+    bool waiting_;                      ///< worker has requested unit, but no one is pending
+    int unit_;
+};
+
+class Coordinator
+{
+public:
+    Coordinator(const std::vector<const char*> &containers, const CoordinatorOptions &options)
+    : containers_(containers)
+    , options_(options)
+    , listener_(-1)
+    , output_(NULL)
+    , finishedUnits_(0)
+    , tests_(0)
+    , reassigned_(0)
+    {
+        for (int idx = 0; idx < YUNIT_NS_PREF(outcomesNumber); ++idx)
+            outcomes_[idx] = 0;
+    }
+
+    ~Coordinator()
+    {
+        for (size_t idx = 0; idx < workers_.size(); ++idx)
+            ::close(workers_[idx].socket_);
+        if (listener_ >= 0)
+            ::close(listener_);
+        if (NULL != output_)
+            ::fclose(output_);
+    }
+
+    int run()
+    {
+        if (!planUnits() || !listen())
+            return -1;
+
+        output_ = ::fopen(options_.resultsPath_, "w");
+        if (NULL == output_)
+        {
+            fprintf(stderr, "Can not open results file '%s'" ENDL, options_.resultsPath_);
+            return -1;
+        }
+
+        const Clock::time_point startTime = Clock::now();
+        while (finishedUnits_ < units_.size())
+        {
+            std::vector<struct pollfd> fds(workers_.size() + 1);
+            fds[0].fd = listener_;
+            fds[0].events = POLLIN;
+            for (size_t idx = 0; idx < workers_.size(); ++idx)
+            {
+                fds[idx + 1].fd = workers_[idx].socket_;
+                fds[idx + 1].events = POLLIN;
+            }
+
+            enum {pollTimeoutMs = 200};
+            if (::poll(&fds[0], fds.size(), pollTimeoutMs) < 0 && EINTR != errno)
+            {
+                perror("Coordinator poll error");
+                return -1;
+            }
+
+            // disconnected workers are removed from the end, so indexes of 'fds' stay valid
+            for (size_t idx = workers_.size(); idx > 0; --idx)
+                if (0 != (fds[idx].revents & (POLLIN | POLLHUP | POLLERR)) && !receive(workers_[idx - 1]))
+                    dropWorker(idx - 1, "has disconnected");
+
+            if (0 != (fds[0].revents & POLLIN))
+                accept();
+
+            expireLeases();
+            dispatch();
+        }
+
+        for (size_t idx = 0; idx < workers_.size(); ++idx)
+            sendAll(workers_[idx].socket_, "DONE\n");
+
+        const bool written = 0 == ::fclose(output_);
+        output_ = NULL;
+
+        const std::chrono::duration<double> duration = Clock::now() - startTime;
+        fprintf(stderr, "%u tests of %u units are executed in %.3f s, %u units are reassigned: %llu success, "
+                        "%llu fail, %llu crashed, %llu ignored; results are written into '%s'" ENDL,
+                static_cast<unsigned int>(tests_), static_cast<unsigned int>(units_.size()), duration.count(),
+                reassigned_, outcomes_[YUNIT_NS_PREF(outcomeSuccess)], outcomes_[YUNIT_NS_PREF(outcomeFail)],
+                outcomes_[YUNIT_NS_PREF(outcomeCrashed)], outcomes_[YUNIT_NS_PREF(outcomeIgnored)],
+                options_.resultsPath_);
+
+        if (!written)
+            return -1;
+        return static_cast<int>(outcomes_[YUNIT_NS_PREF(outcomeFail)] + outcomes_[YUNIT_NS_PREF(outcomeCrashed)]);
+    }
+
+private:
+    bool planUnits()
+    {
+        const size_t unitSize = (0 == options_.unitSize_) ? 1 : options_.unitSize_;
+        manifests_.resize(containers_.size());
+
+        std::string error;
+        for (size_t containerIdx = 0; containerIdx < containers_.size(); ++containerIdx)
+        {
+            if (!YUNIT_NS_PREF(readTestManifest)(containers_[containerIdx], manifests_[containerIdx], error))
+            {
+                fprintf(stderr, "%s" ENDL, error.c_str());
+                return false;
+            }
+
+            const size_t testsNumber = manifests_[containerIdx].size();
+            for (size_t first = 0; first < testsNumber; first += unitSize)
+            {
+                WorkUnit unit;
+                unit.container_ = containerIdx;
+                unit.first_ = first;
+                unit.end_ = (first + unitSize < testsNumber) ? first + unitSize : testsNumber;
+                unit.state_ = WorkUnit::pending;
+                unit.attempts_ = 0;
+                pending_.push_back(units_.size());
+                units_.push_back(unit);
+            }
+        }
+        return true;
+    }
+
+    bool listen()
+    {
+        listener_ = ::socket(AF_INET, SOCK_STREAM, 0);
+        if (listener_ < 0)
+        {
+            perror("Coordinator socket is not created");
+            return false;
+        }
+
+        const int reuse = 1;
+        ::setsockopt(listener_, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+        struct sockaddr_in address;
+        ::memset(&address, 0, sizeof(address));
+        address.sin_family = AF_INET;
+        address.sin_port = htons(options_.port_);
+        if (1 != ::inet_pton(AF_INET, options_.bindAddress_, &address.sin_addr))
+        {
+            fprintf(stderr, "Bind address '%s' is not IPv4 address" ENDL, options_.bindAddress_);
+            return false;
+        }
+        if (0 != ::bind(listener_, reinterpret_cast<struct sockaddr*>(&address), sizeof(address))
+            || 0 != ::listen(listener_, SOMAXCONN))
+        {
+            fprintf(stderr, "Address %s:%u can not be listened: %s" ENDL, options_.bindAddress_, options_.port_,
+                    ::strerror(errno));
+            return false;
+        }
+
+        fprintf(stderr, "Coordinator serves %u units of %u containers on %s:%u" ENDL,
+                static_cast<unsigned int>(units_.size()), static_cast<unsigned int>(containers_.size()),
+                options_.bindAddress_, options_.port_);
+        return true;
+    }
+
+    void accept()
+    {
+        const int sock = ::accept(listener_, NULL, NULL);
+        if (sock < 0)
+            return;
+
+        WorkerConnection worker;
+        worker.socket_ = sock;
+        worker.waiting_ = false;
+        worker.unit_ = noUnit;
+        workers_.push_back(worker);
+    }
+
+    // @return false if worker has disconnected or has broken protocol
+    bool receive(WorkerConnection &worker)
+    {
+        char buf[4096];
+        const ssize_t size = ::recv(worker.socket_, buf, sizeof(buf), 0);
+        if (size < 0 && EINTR == errno)
+            return true;
+        if (size <= 0)
+            return false;
+
+        worker.input_.append(buf, static_cast<size_t>(size));
+        std::vector<std::string> lines;
+        takeLines(worker.input_, lines);
+
+        for (size_t idx = 0; idx < lines.size(); ++idx)
+            if (!handle(worker, lines[idx]))
+                return false;
+        return true;
+    }
+
+    bool handle(WorkerConnection &worker, const std::string &line)
+    {
+        if ("GET" == line)
+        {
+            worker.waiting_ = noUnit == worker.unit_;
+            return true;
+        }
+
+        const bool result = 0 == line.compare(0, sizeof("RESULT ") - 1, "RESULT ");
+        const bool end = 0 == line.compare(0, sizeof("END ") - 1, "END ");
+        if (!result && !end)
+            return false;
+
+        char *pos = NULL;
+        const long unitIdx = ::strtol(line.c_str() + line.find(' ') + 1, &pos, 10);
+        if ('\t' != *pos || unitIdx != worker.unit_)
+            return false;
+
+        WorkUnit &unit = units_[unitIdx];
+        if (result)
+        {
+            TestResult testResult;
+            if (!YUNIT_NS_PREF(parseTestResult)(pos + 1, testResult))
+                return false;
+            unit.results_.push_back(testResult);
+        }
+        else
+        {
+            const int status = ::atoi(pos + 1);
+            if (0 != status)
+                fprintf(stderr, "Test program of unit %ld (%s) has exited with status %d" ENDL, unitIdx,
+                        containers_[unit.container_], status);
+            finish(unit);
+            worker.unit_ = noUnit;
+        }
+        return true;
+    }
+
+    // results of unit are written at once, tests without results are reported as crashed
+    void finish(WorkUnit &unit)
+    {
+        std::set<std::string> executed;
+        for (size_t idx = 0; idx < unit.results_.size(); ++idx)
+        {
+            write(unit.results_[idx]);
+            executed.insert(unit.results_[idx].key_);
+        }
+
+        const std::vector<ManifestTest> &manifest = manifests_[unit.container_];
+        for (size_t idx = unit.first_; idx < unit.end_; ++idx)
+        {
+            TestResult crashed;
+            crashed.key_ = testKey(manifest[idx]);
+
+            // cases of generated test family are named "<family>/<case>"
+            const std::set<std::string>::const_iterator found = executed.lower_bound(crashed.key_);
+            if (executed.end() != found && 0 == found->compare(0, crashed.key_.size(), crashed.key_)
+                && (found->size() == crashed.key_.size() || '/' == (*found)[crashed.key_.size()]))
+                continue;
+
+            crashed.lineNumber_ = manifest[idx].lineNumber_;
+            crashed.outcome_ = YUNIT_NS_PREF(outcomeCrashed);
+            write(crashed);
+        }
+
+        unit.results_.clear();
+        unit.state_ = WorkUnit::finished;
+        ++finishedUnits_;
+    }
+
+    void write(const TestResult &result)
+    {
+        YUNIT_NS_PREF(writeTestResult)(output_, result);
+        ++tests_;
+        ++outcomes_[result.outcome_];
+    }
+
+    // unit of lost worker is returned to the head of queue, so it is not delayed till the end of run
+    void dropWorker(size_t workerIdx, const char *reason)
+    {
+        WorkerConnection &worker = workers_[workerIdx];
+        if (noUnit != worker.unit_)
+        {
+            WorkUnit &unit = units_[worker.unit_];
+            unit.results_.clear();
+            if (unit.attempts_ >= options_.maxAttempts_)
+            {
+                fprintf(stderr, "Worker %s, unit %d has been lost %u times, its tests are crashed" ENDL, reason,
+                        worker.unit_, unit.attempts_);
+                finish(unit);
+            }
+            else
+            {
+                fprintf(stderr, "Worker %s, unit %d is reassigned" ENDL, reason, worker.unit_);
+                unit.state_ = WorkUnit::pending;
+                pending_.push_front(worker.unit_);
+                ++reassigned_;
+            }
+        }
+
+        ::close(worker.socket_);
+        workers_.erase(workers_.begin() + workerIdx);
+    }
+
+    void expireLeases()
+    {
+        if (0 == options_.unitTimeoutSec_)
+            return;
+
+        const Clock::time_point now = Clock::now();
+        for (size_t idx = workers_.size(); idx > 0; --idx)
+        {
+            const int unitIdx = workers_[idx - 1].unit_;
+            if (noUnit != unitIdx && now - units_[unitIdx].leaseTime_ > std::chrono::seconds(options_.unitTimeoutSec_))
+                dropWorker(idx - 1, "has exceeded unit timeout");
+        }
+    }
+
+    void dispatch()
+    {
+        for (size_t idx = workers_.size(); idx > 0 && !pending_.empty(); --idx)
+        {
+            WorkerConnection &worker = workers_[idx - 1];
+            if (!worker.waiting_)
+                continue;
+
+            const size_t unitIdx = pending_.front();
+            pending_.pop_front();
+
+            WorkUnit &unit = units_[unitIdx];
+            unit.state_ = WorkUnit::leased;
+            unit.leaseTime_ = Clock::now();
+            ++unit.attempts_;
+            worker.waiting_ = false;
+            worker.unit_ = static_cast<int>(unitIdx);
+
+            char header[64];
+            snprintf(header, sizeof(header), "UNIT %u\t%u\t%u\t", static_cast<unsigned int>(unitIdx),
+                     static_cast<unsigned int>(unit.first_), static_cast<unsigned int>(unit.end_));
+            if (!sendAll(worker.socket_, header + std::string(containers_[unit.container_]) + "\n"))
+                dropWorker(idx - 1, "is not reachable");
+        }
+    }
+
+    const std::vector<const char*> &containers_;
+    const CoordinatorOptions &options_;
+    std::vector<std::vector<ManifestTest> > manifests_;
+    std::vector<WorkUnit> units_;
+    std::deque<size_t> pending_;
+    std::vector<WorkerConnection> workers_;
+    int listener_;
+    FILE *output_;
+    size_t finishedUnits_;
+    size_t tests_;
+    unsigned int reassigned_;
+    unsigned long long outcomes_[YUNIT_NS_PREF(outcomesNumber)];
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+int coordinateTests(const std::vector<const char*> &containers, const CoordinatorOptions &options)
+{
+    Coordinator coordinator(containers, options);
+    return coordinator.run();
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// coordinator may be started after workers, so connection is retried
+static int connectTo(const char *address)
+{
+    const char *colon = ::strrchr(address, ':');
+    if (NULL == colon)
+    {
+        fprintf(stderr, "Coordinator address '%s' has no port" ENDL, address);
+        return -1;
+    }
+    const std::string host(address, colon);
+
+    struct addrinfo hints;
+    ::memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+
+    enum {connectAttempts = 100, connectDelayMs = 100};
+    for (int attempt = 0; attempt < connectAttempts; ++attempt)
+    {
+        struct addrinfo *addresses = NULL;
+        if (0 == ::getaddrinfo(host.c_str(), colon + 1, &hints, &addresses))
+        {
+            for (struct addrinfo *it = addresses; NULL != it; it = it->ai_next)
+            {
+                const int sock = ::socket(it->ai_family, it->ai_socktype, it->ai_protocol);
+                if (sock < 0)
+                    continue;
+                if (0 == ::connect(sock, it->ai_addr, it->ai_addrlen))
+                {
+                    ::freeaddrinfo(addresses);
+                    return sock;
+                }
+                ::close(sock);
+            }
+            ::freeaddrinfo(addresses);
+        }
+        ::usleep(connectDelayMs * 1000);
+    }
+
+    fprintf(stderr, "Coordinator '%s' is not reachable" ENDL, address);
+    return -1;
+}
+
+static bool readLine(int sock, std::string &buf, std::string &line)
+{
+    for (;;)
+    {
+        const size_t end = buf.find('\n');
+        if (std::string::npos != end)
+        {
+            line = buf.substr(0, end);
+            buf.erase(0, end + 1);
+            return true;
+        }
+
+        char chunk[4096];
+        const ssize_t size = ::recv(sock, chunk, sizeof(chunk), 0);
+        if (size < 0 && EINTR == errno)
+            continue;
+        if (size <= 0)
+            return false;
+        buf.append(chunk, static_cast<size_t>(size));
+    }
+}
+
+static bool makeTempFile(std::string &path)
+{
+    const char *dir = ::getenv("TMPDIR");
+    path = std::string(NULL != dir ? dir : "/tmp") + "/yunit-unit-XXXXXX";
+    const int fd = ::mkstemp(&path[0]);
+    if (fd < 0)
+        return false;
+    ::close(fd);
+    return true;
+}
+
+// complete lines, appended to results file by test program, are sent to coordinator
+static bool sendNewResults(int sock, const std::string &prefix, int resultsFd, std::string &buf)
+{
+    char chunk[4096];
+    ssize_t size;
+    while ((size = ::read(resultsFd, chunk, sizeof(chunk))) > 0)
+        buf.append(chunk, static_cast<size_t>(size));
+
+    std::vector<std::string> lines;
+    takeLines(buf, lines);
+    std::string msg;
+    for (size_t idx = 0; idx < lines.size(); ++idx)
+        msg += prefix + lines[idx] + "\n";
+    return sendAll(sock, msg);
+}
+
+// @return exit code of test program, -signal, if it has been killed, or -1000, if it is not executed
+static int executeUnit(int sock, unsigned int unitIdx, size_t first, size_t end, const char *container,
+                       const std::vector<const char*> &testArgs)
+{
+    enum {notExecuted = -1000};
+
+    std::vector<ManifestTest> manifest;
+    std::string error;
+    if (!YUNIT_NS_PREF(readTestManifest)(container, manifest, error) || end > manifest.size())
+    {
+        fprintf(stderr, "Manifest of '%s' does not match unit: %s" ENDL, container, error.c_str());
+        return notExecuted;
+    }
+
+    std::string listPath, resultsPath;
+    if (!makeTempFile(listPath) || !makeTempFile(resultsPath))
+    {
+        perror("Temporary files of unit are not created");
+        return notExecuted;
+    }
+
+    FILE *list = ::fopen(listPath.c_str(), "w");
+    for (size_t idx = first; NULL != list && idx < end; ++idx)
+        fprintf(list, "%s\n", testKey(manifest[idx]).c_str());
+    if (NULL != list)
+        ::fclose(list);
+
+    const std::string listArg = "--test-list=" + listPath;
+    const std::string resultsArg = "--results=" + resultsPath;
+    std::vector<char*> argv;
+    argv.push_back(const_cast<char*>(container));
+    argv.push_back(const_cast<char*>("--no-history"));
+    argv.push_back(const_cast<char*>(listArg.c_str()));
+    argv.push_back(const_cast<char*>(resultsArg.c_str()));
+    for (size_t idx = 0; idx < testArgs.size(); ++idx)
+        argv.push_back(const_cast<char*>(testArgs[idx]));
+    argv.push_back(NULL);
+
+    // file is opened before test program starts, so its truncation by test program does not move offset
+    const int resultsFd = ::open(resultsPath.c_str(), O_RDONLY);
+    int status = notExecuted;
+    const pid_t pid = (resultsFd >= 0) ? ::fork() : -1;
+    if (0 == pid)
+    {
+        ::close(sock);
+        ::execv(container, &argv[0]);
+        _exit(127);
+    }
+
+    if (pid > 0)
+    {
+        char prefix[32];
+        snprintf(prefix, sizeof(prefix), "RESULT %u\t", unitIdx);
+        std::string buf;
+
+        enum {resultsPollMs = 20};
+        bool connected = true;
+        for (;;)
+        {
+            int waitStatus = 0;
+            const pid_t exited = ::waitpid(pid, &waitStatus, WNOHANG);
+            connected = sendNewResults(sock, prefix, resultsFd, buf) && connected;
+            if (exited == pid)
+            {
+                status = WIFEXITED(waitStatus) ? WEXITSTATUS(waitStatus) : -WTERMSIG(waitStatus);
+                break;
+            }
+            if (exited < 0 && EINTR != errno)
+                break;
+
+            // unit of lost connection is executed by another worker
+            if (!connected)
+                ::kill(pid, SIGKILL);
+            ::usleep(resultsPollMs * 1000);
+        }
+    }
+    else
+        perror("Test program is not started");
+
+    if (resultsFd >= 0)
+        ::close(resultsFd);
+    ::unlink(listPath.c_str());
+    ::unlink(resultsPath.c_str());
+    return status;
+}
+
+int workForCoordinator(const char *address, const std::vector<const char*> &testArgs)
+{
+    const int sock = connectTo(address);
+    if (sock < 0)
+        return -1;
+
+    int executedUnits = 0;
+    std::string buf, line;
+    while (sendAll(sock, "GET\n") && readLine(sock, buf, line) && 0 == line.compare(0, 5, "UNIT "))
+    {
+        char *pos = NULL;
+        const unsigned int unitIdx = static_cast<unsigned int>(::strtoul(line.c_str() + 5, &pos, 10));
+        const size_t first = ::strtoul(pos + 1, &pos, 10);
+        const size_t end = ::strtoul(pos + 1, &pos, 10);
+        if ('\t' != *pos)
+        {
+            fprintf(stderr, "Wrong unit from coordinator: %s" ENDL, line.c_str());
+            break;
+        }
+
+        const int status = executeUnit(sock, unitIdx, first, end, pos + 1, testArgs);
+
+        char msg[64];
+        snprintf(msg, sizeof(msg), "END %u\t%d\n", unitIdx, status);
+        if (!sendAll(sock, msg))
+            break;
+        ++executedUnits;
+    }
+
+    ::close(sock);
+    fprintf(stderr, "Worker has executed %d units" ENDL, executedUnits);
+    return executedUnits;
+}
+
+#else // _WIN32
+
+int coordinateTests(const std::vector<const char*> &/*containers*/, const CoordinatorOptions &/*options*/)
+{
+    fprintf(stderr, "Coordinator mode is not supported on this platform" ENDL);
+    return -1;
+}
+
+int workForCoordinator(const char */*address*/, const std::vector<const char*> &/*testArgs*/)
+{
+    fprintf(stderr, "Worker mode is not supported on this platform" ENDL);
+    return -1;
+}
+
+#endif // _WIN32
@@ -0,0 +1,51 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// @file work_queue.h
+//
+// Dynamic distribution of tests between machines (runner '--coordinate' and '--work-for' modes). Coordinator
+// splits tests of containers, listed in their manifests, into work units of consecutive manifest indexes and
+// serves them over TCP; workers pull the next unit, when previous one is finished, so fast machines take more
+// units and durations need not be known in advance. Unit is executed by test program of container with
+// '--test-list' and '--results' options (paths of containers must be the same on all machines).
+//
+// Protocol is text, one message per line:
+// @code
+// worker:      GET
+// coordinator: UNIT <id>\t<first index>\t<end index>\t<container>     or DONE, when all units are finished
+// worker:      RESULT <id>\t<results file line>                       for every executed test, while unit runs
+// worker:      END <id>\t<exit code of test program, -signal if it is killed>
+// @endcode
+// Coordinator listens on loopback interface by default, because protocol has no authentication; address of
+// interface, which is reachable by other machines, is set explicitly (runner '--coordinate-bind <address>').
+//
+// Results of unit are accepted, when it is finished. Unit of worker, which has disconnected or has exceeded
+// unit timeout, is given to another worker; tests of unit, which has been lost by several workers or which
+// have no results after end of unit, are reported as crashed.
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#ifndef _WORK_QUEUE_HEADER_
+#define _WORK_QUEUE_HEADER_
+
+#include <vector>
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+struct CoordinatorOptions
+{
+    CoordinatorOptions();
+
+    unsigned short port_;
+    const char *bindAddress_;       ///< IPv4 address of listened interface, "0.0.0.0" for all interfaces
+    unsigned int unitSize_;         ///< number of tests in work unit
+    unsigned int unitTimeoutSec_;   ///< unit is reassigned, if it is not finished in time (0 - no limit)
+    unsigned int maxAttempts_;      ///< number of workers, which may lose unit
+    const char *resultsPath_;       ///< results of all units (see cppunit/test_results.h)
+};
+
+/// @brief Serve units of tests of 'containers' until all of them are finished
+/// @return Number of failed and crashed tests or -1, if address can not be listened or results can not be written
+int coordinateTests(const std::vector<const char*> &containers, const CoordinatorOptions &options);
+
+/// @brief Execute units of coordinator 'address' ("<host>:<port>") until it has no more units
+/// @param testArgs Additional options of test programs
+/// @return Number of executed units or -1, if coordinator is not reachable
+int workForCoordinator(const char *address, const std::vector<const char*> &testArgs);
+
+#endif // _WORK_QUEUE_HEADER_
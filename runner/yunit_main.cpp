@@ -1,5 +1,15 @@
 #include "test_engine_interface.h"
 #include "test_engine.h"
+#include "file_watcher.h"
+#include "benchmark_report.h"
+#include "crash_report.h"
+#include "results_merge.h"
+#include "work_queue.h"
+#include "lua_state_pool.h"
+#include "bytecode_cache.h"
+#include "test_plan.h"
+#include "trace_lib.h"
+#include "../cppunit/trace.h"
 #include "lua_wrapper.h"
 
 #ifdef _WIN32
@@ -10,10 +20,58 @@
 #  define ACCESS_FUNC access
 #endif
 
+#include <ctype.h>
+#include <limits.h>
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
 #include <list>
+#include <vector>
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// options, which are followed by value argument
+static bool hasValue(const char *option)
+{
+    static const char* const options[] = {"--test-unit-engine", "-e", "--test-container", "-t", "--trace",
+        "--crash-report", "--merge-results", "--results", "--coordinate", "--coordinate-bind", "--unit-size",
+        "--unit-timeout", "--work-results", "--bytecode-cache", "--jobs", "-j", "--work-for", "--test-arg",
+        "--merge-policy", "--compare-benchmarks", "--baseline-commit", "--current-commit", "--regression-threshold",
+        "--confidence"};
+
+    for (size_t idx = 0; idx < sizeof(options) / sizeof(options[0]); ++idx)
+        if (0 == ::strcmp(option, options[idx]))
+            return true;
+    return false;
+}
+
+static bool parseNumber(const char *option, const char *value, unsigned long min, unsigned long max,
+                        unsigned long &number)
+{
+    char *end = NULL;
+    number = isdigit(static_cast<unsigned char>(*value)) ? ::strtoul(value, &end, 10) : 0;
+    if (NULL == end || '\0' != *end || number < min || number > max)
+    {
+        fprintf(stderr, "Wrong value '%s' of option '%s', it must be number from %lu to %lu" ENDL, value, option,
+                min, max);
+        return false;
+    }
+    return true;
+}
+
+// 'min' and 'max' are excluded, if 'exclusive' is set
+static bool parseReal(const char *option, const char *value, double min, double max, bool exclusive, double &number)
+{
+    char *end = NULL;
+    number = ::strtod(value, &end);
+    if (end == value || '\0' != *end || number < min || number > max
+        || (exclusive && (number == min || number == max)))
+    {
+        fprintf(stderr, "Wrong value '%s' of option '%s', it must be number %s %g and %g" ENDL, value, option,
+                exclusive ? "strictly between" : "from", min, max);
+        return false;
+    }
+    return true;
+}
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////
 int main(int argc, char **argv)
@@ -32,10 +90,52 @@ int main(int argc, char **argv)
     const int testContainerPathTableIdx = lua.top();
     int testContainerPathIdx = 0;
     
+    bool watchMode = false;
+    unsigned int jobs = 1;
+    LuaEnvironment luaEnvironment;
     const char* mainScript = NULL;
+
+    const char *traceFile = NULL;
+
+    bool listTestsMode = false;
+    std::vector<const char*> testContainerPaths;
+
+    const char *crashRecordPath = NULL;
+
+    MergeOptions mergeOptions;
+    std::vector<const char*> resultsPaths;
+
+    bool coordinatorMode = false;
+    CoordinatorOptions coordinatorOptions;
+    const char *coordinatorAddress = NULL;
+    std::vector<const char*> testArgs;
+
+    bool compareBenchmarksMode = false;
+    BenchmarkReportOptions benchmarkReportOptions;
     
+    enum ReturnStatus
+    {
+        ST_SUCCESS = 0,
+        ST_ERROR = -1,
+        ST_NO_ANY_TUE = -2,
+        ST_NO_ANY_TEST_CONTAINER = -3,
+        ST_MAIN_SCRIPT_FAIL = -4,
+        ST_NO_SET_MAIN_SCRIPT = -5,
+        ST_BENCHMARK_REGRESSION = -6,
+        ST_NO_BENCHMARKS = -7,
+        ST_FAILED_TESTS = -8,
+        ST_WRONG_OPTION = -9
+    };
+
+    unsigned long number = 0;
     for (int argIdx = 1/* skip program path */; argIdx < argc; ++argIdx)
     {
+        if (hasValue(argv[argIdx]) && argIdx + 1 == argc)
+        {
+            fprintf(stderr, "Option '%s' needs a value" ENDL, argv[argIdx]);
+            return ST_WRONG_OPTION;
+        }
+
         /// @todo It is needed to use customized argument parser instead of many ::strcmp calls for more performance
         if (0 == ::strcmp("--test-unit-engine", argv[argIdx])
            || 0 == ::strcmp("-e", argv[argIdx]))
@@ -44,6 +144,7 @@ int main(int argc, char **argv)
             lua.push(++testEnginePathIdx);
             lua.push(argv[++argIdx]);
             lua.settable(testEnginePathTableIdx);
+            luaEnvironment.testEngines_.push_back(argv[argIdx]);
         }
         else if (0 == ::strcmp("--test-container", argv[argIdx])
                 || 0 == ::strcmp("-t", argv[argIdx]))
@@ -52,21 +153,149 @@ int main(int argc, char **argv)
             lua.push(++testContainerPathIdx);
             lua.push(argv[++argIdx]);
             lua.settable(testContainerPathTableIdx);
+            testContainerPaths.push_back(argv[argIdx]);
+        }
+        else if (0 == ::strcmp("--list-tests", argv[argIdx]))
+            listTestsMode = true;
+        else if (0 == ::strcmp("--watch", argv[argIdx])
+                || 0 == ::strcmp("-w", argv[argIdx]))
+        {
+            watchMode = true;
+        }
+        else if (0 == ::strcmp("--trace", argv[argIdx]))
+            traceFile = argv[++argIdx];
+        else if (0 == ::strcmp("--crash-report", argv[argIdx]))
+            crashRecordPath = argv[++argIdx];
+        else if (0 == ::strcmp("--merge-results", argv[argIdx]))
+            mergeOptions.output_ = argv[++argIdx];
+        else if (0 == ::strcmp("--results", argv[argIdx]))
+            resultsPaths.push_back(argv[++argIdx]);
+        else if (0 == ::strcmp("--coordinate", argv[argIdx]))
+        {
+            coordinatorMode = true;
+            if (!parseNumber(argv[argIdx], argv[argIdx + 1], 0, 65535, number))
+                return ST_WRONG_OPTION;
+            coordinatorOptions.port_ = static_cast<unsigned short>(number);
+            ++argIdx;
+        }
+        else if (0 == ::strcmp("--coordinate-bind", argv[argIdx]))
+            coordinatorOptions.bindAddress_ = argv[++argIdx];
+        else if (0 == ::strcmp("--unit-size", argv[argIdx]))
+        {
+            if (!parseNumber(argv[argIdx], argv[argIdx + 1], 1, UINT_MAX, number))
+                return ST_WRONG_OPTION;
+            coordinatorOptions.unitSize_ = static_cast<unsigned int>(number);
+            ++argIdx;
+        }
+        else if (0 == ::strcmp("--unit-timeout", argv[argIdx]))
+        {
+            if (!parseNumber(argv[argIdx], argv[argIdx + 1], 0, UINT_MAX, number))
+                return ST_WRONG_OPTION;
+            coordinatorOptions.unitTimeoutSec_ = static_cast<unsigned int>(number);
+            ++argIdx;
+        }
+        else if (0 == ::strcmp("--work-results", argv[argIdx]))
+        {
+            coordinatorOptions.resultsPath_ = argv[++argIdx];
+            luaEnvironment.resultsPath_ = argv[argIdx];
+        }
+        else if (0 == ::strcmp("--bytecode-cache", argv[argIdx]))
+            setBytecodeCacheDir(argv[++argIdx]);
+        else if (0 == ::strcmp("--jobs", argv[argIdx])
+                || 0 == ::strcmp("-j", argv[argIdx]))
+        {
+            if (!parseNumber(argv[argIdx], argv[argIdx + 1], 1, UINT_MAX, number))
+                return ST_WRONG_OPTION;
+            jobs = static_cast<unsigned int>(number);
+            ++argIdx;
+        }
+        else if (0 == ::strcmp("--work-for", argv[argIdx]))
+            coordinatorAddress = argv[++argIdx];
+        else if (0 == ::strcmp("--test-arg", argv[argIdx]))
+            testArgs.push_back(argv[++argIdx]);
+        else if (0 == ::strcmp("--merge-policy", argv[argIdx]))
+        {
+            ++argIdx;
+            if (0 != ::strcmp("last", argv[argIdx]) && 0 != ::strcmp("worst", argv[argIdx]))
+            {
+                fprintf(stderr, "Wrong value '%s' of option '--merge-policy', it must be 'last' or 'worst'" ENDL,
+                        argv[argIdx]);
+                return ST_WRONG_OPTION;
+            }
+            mergeOptions.policy_ = (0 == ::strcmp("last", argv[argIdx])) ? mergeLast : mergeWorst;
+        }
+        else if (0 == ::strcmp("--compare-benchmarks", argv[argIdx]))
+        {
+            compareBenchmarksMode = true;
+            benchmarkReportOptions.storePath_ = argv[++argIdx];
+        }
+        else if (0 == ::strcmp("--baseline-commit", argv[argIdx]))
+            benchmarkReportOptions.baselineCommit_ = argv[++argIdx];
+        else if (0 == ::strcmp("--current-commit", argv[argIdx]))
+            benchmarkReportOptions.currentCommit_ = argv[++argIdx];
+        else if (0 == ::strcmp("--regression-threshold", argv[argIdx]))
+        {
+            if (!parseReal(argv[argIdx], argv[argIdx + 1], 0, 1e6, false, benchmarkReportOptions.threshold_))
+                return ST_WRONG_OPTION;
+            ++argIdx;
+        }
+        else if (0 == ::strcmp("--confidence", argv[argIdx]))
+        {
+            if (!parseReal(argv[argIdx], argv[argIdx + 1], 0, 1, true, benchmarkReportOptions.confidence_))
+                return ST_WRONG_OPTION;
+            ++argIdx;
         }
         else
             mainScript = argv[argIdx];
     }
     
-    enum ReturnStatus
+
+    if (compareBenchmarksMode)
     {
-        ST_SUCCESS = 0,
-        ST_ERROR = -1,
-        ST_NO_ANY_TUE = -2,
-        ST_NO_ANY_TEST_CONTAINER = -3,
-        ST_MAIN_SCRIPT_FAIL = -4,
-        ST_NO_SET_MAIN_SCRIPT = -5
-    };
+        const int regressions = reportBenchmarks(benchmarkReportOptions);
+        if (regressions < 0)
+            return ST_NO_BENCHMARKS;
+        return 0 == regressions ? ST_SUCCESS : ST_BENCHMARK_REGRESSION;
+    }
     
+    if (NULL != crashRecordPath)
+        return printCrashReport(crashRecordPath) ? ST_SUCCESS : ST_ERROR;
+
+    if (NULL != mergeOptions.output_)
+    {
+        const int failed = mergeResults(resultsPaths, mergeOptions);
+        if (failed < 0)
+            return ST_ERROR;
+        return 0 == failed ? ST_SUCCESS : ST_FAILED_TESTS;
+    }
+
+    if (NULL != coordinatorAddress)
+        return workForCoordinator(coordinatorAddress, testArgs) < 0 ? ST_ERROR : ST_SUCCESS;
+
+    // manifests are read from container files, so neither test engine nor Lua script is needed
+    if (listTestsMode)
+    {
+        if (testContainerPaths.empty())
+        {
+            perror("No one test container set" ENDL);
+            return ST_NO_ANY_TEST_CONTAINER;
+        }
+        return 0 == listTests(testContainerPaths) ? ST_SUCCESS : ST_ERROR;
+    }
+
+    if (coordinatorMode)
+    {
+        if (testContainerPaths.empty())
+        {
+            perror("No one test container set" ENDL);
+            return ST_NO_ANY_TEST_CONTAINER;
+        }
+        const int failed = coordinateTests(testContainerPaths, coordinatorOptions);
+        if (failed < 0)
+            return ST_ERROR;
+        return 0 == failed ? ST_SUCCESS : ST_FAILED_TESTS;
+    }
+
     if (0 == testEnginePathIdx)
     {
         perror("No one test unit engine set" ENDL);
@@ -84,12 +313,33 @@ int main(int argc, char **argv)
 
     lua.push(Value(testContainerPathTableIdx));
     lua.setglobal(testContainerPathTableNameInLua);
+
+    lua.push(watchMode);
+    lua.setglobal("watchMode");
     
     if (NULL == mainScript)
     {
         perror("Not set Lua script for execution");
         return ST_NO_SET_MAIN_SCRIPT;
     }
+    if (NULL != traceFile && !YUNIT_NS_PREF(openTraceFile)(traceFile))
+        fprintf(stderr, "Can not open trace file '%s'" ENDL, traceFile);
+
+    // containers are spread between states of pool; watch mode keeps containers of one state loaded
+    if (jobs > 1 && !watchMode)
+    {
+        luaEnvironment.program_ = argv[0];
+        luaEnvironment.mainScript_ = mainScript;
+        luaEnvironment.testContainers_ = testContainerPaths;
+
+        LuaStatePool pool(luaEnvironment, jobs);
+        const int failedStates = pool.run();
+        YUNIT_NS_PREF(closeTraceFile)();
+        if (failedStates < 0)
+            return ST_ERROR;
+        return 0 == failedStates ? ST_SUCCESS : ST_MAIN_SCRIPT_FAIL;
+    }
+
     //
     // add executable file path into Lua state environment
     lua.push(argv[0]);
@@ -99,13 +349,17 @@ int main(int argc, char **argv)
     
     LUA_REGISTER(TestEngine)(lua);
     LUA_REGISTER(TestCase)(lua);
+    LUA_REGISTER(FileWatcher)(lua);
+    registerTraceLib(lua);
+    registerBytecodeCache(lua);
 //    LUA_REGISTER(Logger)(lua);
 
     SimpleLogger logger;
 //    LUA_PUSH(logger.logger(), Logger);
 //    lua.setglobal("logger");
     
-    int rc = lua.dofile(mainScript);
+    int rc = doCachedFile(lua, mainScript);
+    YUNIT_NS_PREF(closeTraceFile)();
     if (0 != rc)
     {
         perror(lua.to<const char*>());
@@ -1,19 +1,25 @@
 -- Execution environment:
 -- (1) Variables:
---  (var) program            (string) Path for executable file, used to run current process 
---  (var) testEnginePaths    (table)  List of path to test engine files
---  (var) testContainerPaths (table)  List of path to test container files
+--  (var) program            (string)  Path for executable file, used to run current process
+--  (var) testEnginePaths    (table)   List of path to test engine files
+--  (var) testContainerPaths (table)   List of path to test container files
+--  (var) watchMode          (boolean) Keep test engines and test containers loaded, rerun changed ones
+--  (var) trace              (table)   Trace buffers interface: beginSpan, endSpan, counter, message, flush
+-- (2) Functions of state of pool (runner '--jobs <n>', see lua_state_pool.h), nil in the main state:
+--  (func) nextTestContainer()  Path of the next container of shared queue or nil
+--  (func) writeResult(source, name, line, outcome[, durationNs])  Append result of test to results file
+--  (func) clockNs()            Monotonic time in nanoseconds
 -- all standart Lua libraries are loaded
 
 --[[
     Problem 1:
-        Every Test Engine is build as Dynamic Link Library. 
+        Every Test Engine is build as Dynamic Link Library.
         Every may be linked with other Dynamic Link Libraries.
         There is not zero opportunity, that two (or more) Test Engine are linked with library of the same name.
         So conflict will occure, if we load both Test Engine simultaneously.
-    
+
     Problem 2:
-    
+
     How defence from problems:
       * work only with one Test Engine in the same time. Unload DLL after using
       * change working directory to Test Engine file directory
@@ -21,39 +27,158 @@
 
 --[[
     Problem 3:
-        Several Test Engines may support 
+        Several Test Engines may support
+--]]
+
+--[[
+    Watch mode:
+        Lua state stays alive between runs and every Test Engine is loaded once (one object per engine path,
+        engines are loaded with RTLD_DEEPBIND, so libraries of the same name do not conflict). Changed test
+        container is released by 'engine:unloadContainer' and loaded again by the same engine. Engine, which
+        does not export 'releaseTestContainer', is reloaded together with all its containers.
 --]]
 
-local testEngine, testContainer, unitTests, errMsg
+local function runTest(unitTest)
+    unitTest:setUp()
+    unitTest:test()
+    unitTest:tearDown()
+end
+
+local function runTests(testCases)
+    for _, unitTest in pairs(testCases) do
+        local name = unitTest:name()
+        trace.beginSpan(name)
+        if writeResult and unitTest:isIgnored() then
+            writeResult(unitTest:source(), name, unitTest:line(), 'ignored')
+        elseif writeResult then
+            -- state of pool reports error of test and continues with the next one
+            local startTime = clockNs()
+            local ok, errMsg = pcall(runTest, unitTest)
+            local durationNs = clockNs() - startTime
+            if not ok then
+                print(errMsg)
+            end
+            writeResult(unitTest:source(), name, unitTest:line(), ok and 'success' or 'fail', durationNs)
+        else
+            runTest(unitTest)
+        end
+        trace.endSpan(name)
+        trace.flush()
+    end
+end
+
+-- TestEngine:load returns table of TestCase objects, it is empty, if engine does not support container
+local function loadTestContainer(engine, loaded)
+    local tests = engine:load(loaded.path)
+    if not tests or not next(tests) then
+        engine:unloadContainer(loaded.path)
+        return false
+    end
+
+    print(loaded.path)
+    loaded.tests = tests
+    return true
+end
+
+local function unloadTestContainer(engine, loaded)
+    loaded.tests = nil
+    return engine:unloadContainer(loaded.path)
+end
+
+local function reloadEngine(engines, enginePath, loadedContainers)
+    engines[enginePath]:unload()
+    engines[enginePath] = assert(TestEngine(enginePath))
+
+    for _, loaded in ipairs(loadedContainers) do
+        if loaded.enginePath == enginePath then
+            loaded.tests = nil
+            loaded.changed = loadTestContainer(engines[enginePath], loaded)
+        end
+    end
+end
+
+local function watch(engines, loadedContainers)
+    local watcher = assert(FileWatcher())
 
-for _, path in pairs(testEnginePaths) do
-    testEngine, errMsg = TestEngine(path)
+    for _, loaded in ipairs(loadedContainers) do
+        loaded.watchedPath = assert(watcher:watchFile(loaded.path))
+    end
+
+    while true do
+        print('Watching for changes...')
+        local changedPaths = assert(watcher:wait())
+
+        for _, changedPath in ipairs(changedPaths) do
+            for _, loaded in ipairs(loadedContainers) do
+                if loaded.watchedPath == changedPath then
+                    local engine = engines[loaded.enginePath]
+                    if unloadTestContainer(engine, loaded) then
+                        loaded.changed = loadTestContainer(engine, loaded)
+                    else
+                        reloadEngine(engines, loaded.enginePath, loadedContainers)
+                    end
+                end
+            end
+        end
+
+        for _, loaded in ipairs(loadedContainers) do
+            if loaded.changed then
+                runTests(loaded.tests)
+                loaded.changed = nil
+            end
+        end
+    end
+end
+
+local enginePaths, engines, loadedContainers = {}, {}, {}
+
+-- engine, which can not be loaded, is reported once
+for _, enginePath in pairs(testEnginePaths) do
+    local testEngine, errMsg = TestEngine(enginePath)
     if testEngine then
         print('TestEngine: ' .. tostring(testEngine))
+        table.insert(enginePaths, enginePath)
+        engines[enginePath] = testEngine
+    else
+        print(errMsg)
+    end
+end
 
-        for _, path in pairs(testContainerPaths) do
-            print(path)
-            
-            testContainer = testEngine:load(path)
-            if testContainer then
-                testCases = testContainer:tests() 
-                 if testCases then
-                     print('testCases = ', testCases)
-                     print(#unitTests)
-                
-                     for _, unitTest in pairs(testCases) do
-                         unitTest:setUp()
-                         unitTest:test()
-			 unitTest:tearDown()
-                     end
-                 end
-		testEngine:unload(testContainer)
-		testContainer = nil
-             end
-	end
-    end
-    
-    unload(testEngine)
-    testEngine = nil
+-- state of pool takes containers from queue, shared with other states; every container is tried by all engines
+local function containers()
+    if nextTestContainer then
+        return nextTestContainer
+    end
+    local idx = 0
+    return function()
+        idx = idx + 1
+        return testContainerPaths[idx]
+    end
+end
+
+for path in containers() do
+    for _, enginePath in ipairs(enginePaths) do
+        local loaded = {enginePath = enginePath, path = path}
+        if loadTestContainer(engines[enginePath], loaded) then
+            runTests(loaded.tests)
+            if watchMode then
+                table.insert(loadedContainers, loaded)
+            else
+                unloadTestContainer(engines[enginePath], loaded)
+            end
+            break
+        end
+    end
 end
 
+if watchMode then
+    watch(engines, loadedContainers)
+end
+
+for _, loaded in ipairs(loadedContainers) do
+    unloadTestContainer(engines[loaded.enginePath], loaded)
+end
+
+for _, enginePath in ipairs(enginePaths) do
+    engines[enginePath]:unload()
+end